@@ -0,0 +1,235 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+// Qt
+#include <QtTest>
+// client
+#include "../../src/client/compositor.h"
+#include "../../src/client/connection_thread.h"
+#include "../../src/client/ddeshell.h"
+#include "../../src/client/event_queue.h"
+#include "../../src/client/registry.h"
+#include "../../src/client/surface.h"
+// server
+#include "../../src/server/compositor_interface.h"
+#include "../../src/server/ddeshell_interface.h"
+#include "../../src/server/display.h"
+#include "../../src/server/surface_interface.h"
+
+#include <wayland-dde-shell-client-protocol.h>
+
+using namespace KWayland::Client;
+using namespace KWaylandServer;
+
+// counts the events received for a raw dde_shell_surface
+struct ShellSurfaceEvents {
+    int stateChanges = 0;
+    quint32 state = 0;
+    int geometryChanges = 0;
+    QRect geometry;
+};
+
+class TestDDEShell : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void testStateCoalescing();
+    void testExplicitStateChange();
+
+private:
+    Display *m_display = nullptr;
+    CompositorInterface *m_compositorInterface = nullptr;
+    DDEShellInterface *m_ddeShellInterface = nullptr;
+    DDEShellSurfaceInterface *m_shellSurfaceInterface = nullptr;
+
+    ConnectionThread *m_connection = nullptr;
+    QThread *m_thread = nullptr;
+    EventQueue *m_queue = nullptr;
+    Registry *m_registry = nullptr;
+    Compositor *m_compositor = nullptr;
+    DDEShell *m_ddeShell = nullptr;
+    Surface *m_surface = nullptr;
+    dde_shell_surface *m_shellSurface = nullptr;
+
+    ShellSurfaceEvents m_events;
+};
+
+static const QString s_socketName = QStringLiteral("kwayland-test-dde-shell-0");
+
+static void geometryCallback(void *data, dde_shell_surface *surface, int32_t x, int32_t y, uint32_t width, uint32_t height)
+{
+    Q_UNUSED(surface)
+    auto events = static_cast<ShellSurfaceEvents *>(data);
+    events->geometryChanges++;
+    events->geometry = QRect(x, y, width, height);
+}
+
+static void stateChangedCallback(void *data, dde_shell_surface *surface, uint32_t state)
+{
+    Q_UNUSED(surface)
+    auto events = static_cast<ShellSurfaceEvents *>(data);
+    events->stateChanges++;
+    events->state = state;
+}
+
+static const dde_shell_surface_listener s_listener = {
+    geometryCallback,
+    stateChangedCallback,
+};
+
+void TestDDEShell::init()
+{
+    m_display = new Display(this);
+    m_display->addSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+    m_compositorInterface = new CompositorInterface(m_display, m_display);
+    m_ddeShellInterface = new DDEShellInterface(m_display, m_display);
+
+    m_connection = new ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &ConnectionThread::connected);
+    QVERIFY(connectedSpy.isValid());
+    m_connection->setSocketName(s_socketName);
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new EventQueue(this);
+    m_queue->setup(m_connection);
+
+    m_registry = new Registry(this);
+    QSignalSpy interfacesAnnouncedSpy(m_registry, &Registry::interfacesAnnounced);
+    QVERIFY(interfacesAnnouncedSpy.isValid());
+    m_registry->setEventQueue(m_queue);
+    m_registry->create(m_connection);
+    QVERIFY(m_registry->isValid());
+    m_registry->setup();
+    QVERIFY(interfacesAnnouncedSpy.wait());
+
+    m_compositor = m_registry->createCompositor(m_registry->interface(Registry::Interface::Compositor).name,
+                                                m_registry->interface(Registry::Interface::Compositor).version,
+                                                this);
+    QVERIFY(m_compositor->isValid());
+    m_ddeShell = m_registry->createDDEShell(m_registry->interface(Registry::Interface::DDEShell).name,
+                                            m_registry->interface(Registry::Interface::DDEShell).version,
+                                            this);
+    QVERIFY(m_ddeShell->isValid());
+
+    QSignalSpy shellSurfaceCreatedSpy(m_ddeShellInterface, &DDEShellInterface::shellSurfaceCreated);
+    QVERIFY(shellSurfaceCreatedSpy.isValid());
+    m_surface = m_compositor->createSurface(this);
+    m_shellSurface = dde_shell_get_shell_surface(*m_ddeShell, *m_surface);
+    m_queue->addProxy(m_shellSurface);
+    m_events = ShellSurfaceEvents();
+    dde_shell_surface_add_listener(m_shellSurface, &s_listener, &m_events);
+    QVERIFY(shellSurfaceCreatedSpy.wait());
+    m_shellSurfaceInterface = shellSurfaceCreatedSpy.first().first().value<DDEShellSurfaceInterface *>();
+    QVERIFY(m_shellSurfaceInterface);
+}
+
+void TestDDEShell::cleanup()
+{
+    if (m_shellSurface) {
+        dde_shell_surface_destroy(m_shellSurface);
+        m_shellSurface = nullptr;
+    }
+#define CLEANUP(variable)                                                                                                                                      \
+    if (variable) {                                                                                                                                            \
+        delete variable;                                                                                                                                       \
+        variable = nullptr;                                                                                                                                    \
+    }
+    CLEANUP(m_surface)
+    CLEANUP(m_ddeShell)
+    CLEANUP(m_compositor)
+    CLEANUP(m_queue)
+    CLEANUP(m_registry)
+    if (m_connection) {
+        m_connection->deleteLater();
+        m_connection = nullptr;
+    }
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    CLEANUP(m_display)
+#undef CLEANUP
+    // these are the children of the display
+    m_compositorInterface = nullptr;
+    m_ddeShellInterface = nullptr;
+    m_shellSurfaceInterface = nullptr;
+}
+
+void TestDDEShell::testStateCoalescing()
+{
+    // this test verifies that the state changes made within one event loop iteration are sent as one event,
+    // a geometry change sent along serves as a fence, state changes arrive before it
+    m_shellSurfaceInterface->setActive(true);
+    m_shellSurfaceInterface->setMaximized(true);
+    m_shellSurfaceInterface->setKeepAbove(true);
+    m_shellSurfaceInterface->sendGeometry(QRect(0, 0, 100, 50));
+    QTRY_COMPARE(m_events.geometryChanges, 1);
+    QCOMPARE(m_events.stateChanges, 1);
+    QCOMPARE(m_events.state, quint32(DDE_SHELL_STATE_ACTIVE | DDE_SHELL_STATE_MAXIMIZED | DDE_SHELL_STATE_KEEP_ABOVE));
+    QCOMPARE(m_events.geometry, QRect(0, 0, 100, 50));
+
+    // focus moves away
+    m_shellSurfaceInterface->setActive(false);
+    m_shellSurfaceInterface->setKeepAbove(false);
+    m_shellSurfaceInterface->sendGeometry(QRect(0, 0, 100, 60));
+    QTRY_COMPARE(m_events.geometryChanges, 2);
+    QCOMPARE(m_events.stateChanges, 2);
+    QCOMPARE(m_events.state, quint32(DDE_SHELL_STATE_MAXIMIZED));
+
+    // switching the split mode flips three flags
+    m_shellSurfaceInterface->sendSplitable(1);
+    m_shellSurfaceInterface->sendGeometry(QRect(0, 0, 100, 70));
+    QTRY_COMPARE(m_events.geometryChanges, 3);
+    QCOMPARE(m_events.stateChanges, 3);
+    QCOMPARE(m_events.state, quint32(DDE_SHELL_STATE_MAXIMIZED | DDE_SHELL_STATE_TWO_SPLIT));
+    m_shellSurfaceInterface->sendSplitable(2);
+    m_shellSurfaceInterface->sendGeometry(QRect(0, 0, 100, 80));
+    QTRY_COMPARE(m_events.geometryChanges, 4);
+    QCOMPARE(m_events.stateChanges, 4);
+    QCOMPARE(m_events.state, quint32(DDE_SHELL_STATE_MAXIMIZED | DDE_SHELL_STATE_FOUR_SPLIT));
+
+    // changes which cancel each other out are not sent at all, neither is an unchanged geometry
+    m_shellSurfaceInterface->setActive(true);
+    m_shellSurfaceInterface->setActive(false);
+    m_shellSurfaceInterface->sendGeometry(QRect(0, 0, 1, 1));
+    m_shellSurfaceInterface->sendGeometry(QRect(0, 0, 100, 80));
+    m_shellSurfaceInterface->setMinimized(true);
+    m_shellSurfaceInterface->sendGeometry(QRect(0, 0, 100, 90));
+    QTRY_COMPARE(m_events.geometryChanges, 5);
+    QCOMPARE(m_events.stateChanges, 5);
+    QCOMPARE(m_events.state, quint32(DDE_SHELL_STATE_MAXIMIZED | DDE_SHELL_STATE_FOUR_SPLIT | DDE_SHELL_STATE_MINIMIZED));
+}
+
+void TestDDEShell::testExplicitStateChange()
+{
+    // this test verifies that changes between beginStateChange and commitStateChange are sent by the commit
+    m_shellSurfaceInterface->beginStateChange();
+    m_shellSurfaceInterface->setActive(true);
+    m_shellSurfaceInterface->beginStateChange();
+    m_shellSurfaceInterface->setMaximized(true);
+    m_shellSurfaceInterface->sendGeometry(QRect(10, 20, 100, 50));
+    m_shellSurfaceInterface->commitStateChange();
+    // the nested commit does not send anything, not even once the event loop ran
+    QCoreApplication::processEvents();
+    m_shellSurfaceInterface->setKeepAbove(true);
+    m_shellSurfaceInterface->commitStateChange();
+    QTRY_COMPARE(m_events.geometryChanges, 1);
+    QCOMPARE(m_events.stateChanges, 1);
+    QCOMPARE(m_events.state, quint32(DDE_SHELL_STATE_ACTIVE | DDE_SHELL_STATE_MAXIMIZED | DDE_SHELL_STATE_KEEP_ABOVE));
+    QCOMPARE(m_events.geometry, QRect(10, 20, 100, 50));
+}
+
+QTEST_GUILESS_MAIN(TestDDEShell)
+#include "test_dde_shell.moc"
@@ -37,6 +37,7 @@ private Q_SLOTS:
     void testTouchDragAndDrop();
     void testDragAndDropWithCancelByDestroyDataSource();
     void testPointerEventsIgnored();
+    void testDragMotionInterval();
 
 private:
     KWayland::Client::Surface *createSurface();
@@ -574,5 +575,69 @@ void TestDragAndDrop::testPointerEventsIgnored()
     QVERIFY(pointerLeftSpy.isEmpty());
 }
 
+void TestDragAndDrop::testDragMotionInterval()
+{
+    // this test verifies that drag motion is coalesced according to the drag motion interval
+    using namespace KWaylandServer;
+    using namespace KWayland::Client;
+    QScopedPointer<Surface> s(createSurface());
+    auto serverSurface = getServerSurface();
+    QVERIFY(serverSurface);
+
+    QCOMPARE(m_seatInterface->dragMotionInterval(), 0);
+    m_seatInterface->setDragMotionInterval(500);
+    QCOMPARE(m_seatInterface->dragMotionInterval(), 500);
+
+    QSignalSpy buttonPressSpy(m_pointer, &Pointer::buttonStateChanged);
+    QVERIFY(buttonPressSpy.isValid());
+    m_seatInterface->setFocusedPointerSurface(serverSurface);
+    m_seatInterface->setTimestamp(2);
+    m_seatInterface->notifyPointerButton(1, PointerButtonState::Pressed);
+    m_seatInterface->notifyPointerFrame();
+    QVERIFY(buttonPressSpy.wait());
+
+    QSignalSpy dragEnteredSpy(m_dataDevice, &DataDevice::dragEntered);
+    QVERIFY(dragEnteredSpy.isValid());
+    QSignalSpy dragMotionSpy(m_dataDevice, &DataDevice::dragMotion);
+    QVERIFY(dragMotionSpy.isValid());
+    m_dataDevice->startDrag(buttonPressSpy.first().first().value<quint32>(), m_dataSource, s.data());
+    QVERIFY(dragEnteredSpy.wait());
+    auto offer = m_dataDevice->dragOffer();
+    QVERIFY(offer);
+    offer->accept(QStringLiteral("text/plain"), dragEnteredSpy.last().at(0).toUInt());
+
+    // the first motion goes out right away, the following ones are coalesced
+    m_seatInterface->setTimestamp(3);
+    m_seatInterface->notifyPointerMotion(QPointF(3, 3));
+    m_seatInterface->notifyPointerFrame();
+    m_seatInterface->setTimestamp(4);
+    m_seatInterface->notifyPointerMotion(QPointF(4, 4));
+    m_seatInterface->notifyPointerFrame();
+    m_seatInterface->setTimestamp(5);
+    m_seatInterface->notifyPointerMotion(QPointF(5, 5));
+    m_seatInterface->notifyPointerFrame();
+    QVERIFY(dragMotionSpy.wait());
+    QCOMPARE(dragMotionSpy.count(), 1);
+    QCOMPARE(dragMotionSpy.first().first().toPointF(), QPointF(3, 3));
+    QVERIFY(dragMotionSpy.wait());
+    QCOMPARE(dragMotionSpy.count(), 2);
+    QCOMPARE(dragMotionSpy.last().first().toPointF(), QPointF(5, 5));
+    QCOMPARE(dragMotionSpy.last().last().toUInt(), 5u);
+
+    // pending motion is sent before the drop
+    QSignalSpy droppedSpy(m_dataDevice, &DataDevice::dropped);
+    QVERIFY(droppedSpy.isValid());
+    m_seatInterface->setTimestamp(6);
+    m_seatInterface->notifyPointerMotion(QPointF(6, 6));
+    m_seatInterface->notifyPointerFrame();
+    m_seatInterface->setTimestamp(7);
+    m_seatInterface->notifyPointerButton(1, PointerButtonState::Released);
+    m_seatInterface->notifyPointerFrame();
+    QVERIFY(droppedSpy.wait());
+    QCOMPARE(dragMotionSpy.count(), 3);
+    QCOMPARE(dragMotionSpy.last().first().toPointF(), QPointF(6, 6));
+    delete offer;
+}
+
 QTEST_GUILESS_MAIN(TestDragAndDrop)
 #include "test_drag_drop.moc"
@@ -0,0 +1,206 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+// Qt
+#include <QImage>
+#include <QtTest>
+// client
+#include "../../src/client/compositor.h"
+#include "../../src/client/connection_thread.h"
+#include "../../src/client/event_queue.h"
+#include "../../src/client/framescheduler.h"
+#include "../../src/client/registry.h"
+#include "../../src/client/shm_pool.h"
+#include "../../src/client/surface.h"
+// server
+#include "../../src/server/compositor_interface.h"
+#include "../../src/server/display.h"
+#include "../../src/server/surface_interface.h"
+
+using namespace KWayland::Client;
+using namespace KWaylandServer;
+
+class TestFrameScheduler : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void testCoalesce();
+    void testPresentationInterval();
+
+private:
+    Display *m_display = nullptr;
+    CompositorInterface *m_compositorInterface = nullptr;
+    SurfaceInterface *m_serverSurface = nullptr;
+
+    ConnectionThread *m_connection = nullptr;
+    QThread *m_thread = nullptr;
+    EventQueue *m_queue = nullptr;
+    Registry *m_registry = nullptr;
+    Compositor *m_compositor = nullptr;
+    ShmPool *m_shm = nullptr;
+    Surface *m_surface = nullptr;
+    FrameScheduler *m_scheduler = nullptr;
+};
+
+static const QString s_socketName = QStringLiteral("kwayland-test-frame-scheduler-0");
+
+void TestFrameScheduler::init()
+{
+    m_display = new Display(this);
+    m_display->addSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+    m_display->createShm();
+    m_compositorInterface = new CompositorInterface(m_display, m_display);
+
+    m_connection = new ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &ConnectionThread::connected);
+    QVERIFY(connectedSpy.isValid());
+    m_connection->setSocketName(s_socketName);
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new EventQueue(this);
+    m_queue->setup(m_connection);
+
+    m_registry = new Registry(this);
+    QSignalSpy interfacesAnnouncedSpy(m_registry, &Registry::interfacesAnnounced);
+    QVERIFY(interfacesAnnouncedSpy.isValid());
+    m_registry->setEventQueue(m_queue);
+    m_registry->create(m_connection);
+    QVERIFY(m_registry->isValid());
+    m_registry->setup();
+    QVERIFY(interfacesAnnouncedSpy.wait());
+
+    m_compositor = m_registry->createCompositor(m_registry->interface(Registry::Interface::Compositor).name,
+                                                m_registry->interface(Registry::Interface::Compositor).version,
+                                                this);
+    QVERIFY(m_compositor->isValid());
+    m_shm = m_registry->createShmPool(m_registry->interface(Registry::Interface::Shm).name, m_registry->interface(Registry::Interface::Shm).version, this);
+    QVERIFY(m_shm->isValid());
+
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+    m_surface = m_compositor->createSurface(this);
+    QVERIFY(surfaceCreatedSpy.wait());
+    m_serverSurface = surfaceCreatedSpy.first().first().value<SurfaceInterface *>();
+    QVERIFY(m_serverSurface);
+
+    // every requested frame gets painted and committed
+    m_scheduler = new FrameScheduler(m_surface, this);
+    connect(m_scheduler, &FrameScheduler::renderRequested, this, [this] {
+        QImage image(QSize(10, 10), QImage::Format_ARGB32_Premultiplied);
+        image.fill(Qt::black);
+        m_surface->attachBuffer(m_shm->createBuffer(image));
+        m_surface->damage(image.rect());
+        m_scheduler->commit();
+    });
+}
+
+void TestFrameScheduler::cleanup()
+{
+#define CLEANUP(variable)                                                                                                                                      \
+    if (variable) {                                                                                                                                            \
+        delete variable;                                                                                                                                       \
+        variable = nullptr;                                                                                                                                    \
+    }
+    CLEANUP(m_scheduler)
+    CLEANUP(m_surface)
+    CLEANUP(m_shm)
+    CLEANUP(m_compositor)
+    CLEANUP(m_queue)
+    CLEANUP(m_registry)
+    if (m_connection) {
+        m_connection->deleteLater();
+        m_connection = nullptr;
+    }
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    CLEANUP(m_display)
+#undef CLEANUP
+    // these are the children of the display
+    m_compositorInterface = nullptr;
+    m_serverSurface = nullptr;
+}
+
+void TestFrameScheduler::testCoalesce()
+{
+    // this test verifies that requests are coalesced and held back until the previous frame got rendered
+    QSignalSpy renderRequestedSpy(m_scheduler, &FrameScheduler::renderRequested);
+    QVERIFY(renderRequestedSpy.isValid());
+    QSignalSpy committedSpy(m_serverSurface, &SurfaceInterface::committed);
+    QVERIFY(committedSpy.isValid());
+
+    m_scheduler->scheduleFrame();
+    m_scheduler->scheduleFrame();
+    QVERIFY(m_scheduler->isFrameScheduled());
+    QVERIFY(renderRequestedSpy.isEmpty());
+    QVERIFY(renderRequestedSpy.wait());
+    QVERIFY(!m_scheduler->isFrameScheduled());
+    QVERIFY(m_scheduler->isFrameCallbackPending());
+    QVERIFY(committedSpy.wait());
+
+    // the compositor did not render the frame yet
+    m_scheduler->scheduleFrame();
+    m_scheduler->scheduleFrame();
+    QVERIFY(!renderRequestedSpy.wait(100));
+    QCOMPARE(renderRequestedSpy.count(), 1);
+
+    m_serverSurface->frameRendered(16);
+    QVERIFY(renderRequestedSpy.wait());
+    QCOMPARE(renderRequestedSpy.count(), 2);
+    QVERIFY(committedSpy.wait());
+
+    // without a request the frame callback does not cause a new frame
+    m_serverSurface->frameRendered(33);
+    QTRY_VERIFY(!m_scheduler->isFrameCallbackPending());
+    QCOMPARE(renderRequestedSpy.count(), 2);
+}
+
+void TestFrameScheduler::testPresentationInterval()
+{
+    // this test verifies that the interval is measured from callbacks of consecutive frames
+    QSignalSpy renderRequestedSpy(m_scheduler, &FrameScheduler::renderRequested);
+    QVERIFY(renderRequestedSpy.isValid());
+    QSignalSpy committedSpy(m_serverSurface, &SurfaceInterface::committed);
+    QVERIFY(committedSpy.isValid());
+    QCOMPARE(m_scheduler->presentationInterval(), 0.0);
+
+    m_scheduler->scheduleFrame();
+    QVERIFY(committedSpy.wait());
+    m_scheduler->scheduleFrame();
+    m_serverSurface->frameRendered(100);
+    QVERIFY(committedSpy.wait());
+    // the first frame was not preceded by one, so there is no interval yet
+    QCOMPARE(m_scheduler->presentationInterval(), 0.0);
+
+    m_scheduler->scheduleFrame();
+    m_serverSurface->frameRendered(116);
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(m_scheduler->presentationInterval(), 16.0);
+
+    // idle periods are not measured
+    m_serverSurface->frameRendered(132);
+    QTRY_VERIFY(!m_scheduler->isFrameCallbackPending());
+    QCOMPARE(m_scheduler->presentationInterval(), 16.0);
+    m_scheduler->scheduleFrame();
+    QVERIFY(committedSpy.wait());
+    m_serverSurface->frameRendered(500);
+    QTRY_VERIFY(!m_scheduler->isFrameCallbackPending());
+    QCOMPARE(m_scheduler->presentationInterval(), 16.0);
+    QCOMPARE(renderRequestedSpy.count(), 4);
+}
+
+QTEST_GUILESS_MAIN(TestFrameScheduler)
+#include "test_frame_scheduler.moc"
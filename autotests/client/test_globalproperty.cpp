@@ -0,0 +1,257 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+// Qt
+#include <QtTest>
+// client
+#include "../../src/client/compositor.h"
+#include "../../src/client/connection_thread.h"
+#include "../../src/client/event_queue.h"
+#include "../../src/client/globalproperty.h"
+#include "../../src/client/registry.h"
+#include "../../src/client/strut.h"
+#include "../../src/client/surface.h"
+// server
+#include "../../src/server/compositor_interface.h"
+#include "../../src/server/display.h"
+#include "../../src/server/globalproperty_interface.h"
+#include "../../src/server/strut_interface.h"
+#include "../../src/server/surface_interface.h"
+#include "../../src/server/surfaceproperties.h"
+
+using namespace KWayland::Client;
+using namespace KWaylandServer;
+
+class TestGlobalProperty : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void testJson();
+    void testBinary();
+    void testInvalidBinary();
+    void testJsonWithBinaryType();
+    void testPropertiesChanged();
+
+private:
+    Display *m_display = nullptr;
+    CompositorInterface *m_compositorInterface = nullptr;
+    GlobalPropertyInterface *m_globalPropertyInterface = nullptr;
+    StrutInterface *m_strutInterface = nullptr;
+    SurfaceInterface *m_serverSurface = nullptr;
+
+    ConnectionThread *m_connection = nullptr;
+    QThread *m_thread = nullptr;
+    EventQueue *m_queue = nullptr;
+    Registry *m_registry = nullptr;
+    Compositor *m_compositor = nullptr;
+    GlobalProperty *m_globalProperty = nullptr;
+    Strut *m_strut = nullptr;
+    Surface *m_surface = nullptr;
+
+    // the properties passed with each windowDecoratePropertyChanged
+    QVector<QVariantMap> m_changes;
+};
+
+static const QString s_socketName = QStringLiteral("kwayland-test-globalproperty-0");
+
+void TestGlobalProperty::init()
+{
+    qRegisterMetaType<SurfaceProperties::Properties>();
+    m_display = new Display(this);
+    m_display->addSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+    m_compositorInterface = new CompositorInterface(m_display, m_display);
+    m_globalPropertyInterface = new GlobalPropertyInterface(m_display, m_display);
+    m_strutInterface = new StrutInterface(m_display, m_display);
+    m_changes.clear();
+    connect(m_globalPropertyInterface,
+            &GlobalPropertyInterface::windowDecoratePropertyChanged,
+            this,
+            [this](SurfaceInterface *surface, QMap<QString, QVariant> &properties) {
+                QCOMPARE(surface, m_serverSurface);
+                m_changes << properties;
+            });
+
+    m_connection = new ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &ConnectionThread::connected);
+    QVERIFY(connectedSpy.isValid());
+    m_connection->setSocketName(s_socketName);
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new EventQueue(this);
+    m_queue->setup(m_connection);
+
+    m_registry = new Registry(this);
+    QSignalSpy interfacesAnnouncedSpy(m_registry, &Registry::interfacesAnnounced);
+    QVERIFY(interfacesAnnouncedSpy.isValid());
+    m_registry->setEventQueue(m_queue);
+    m_registry->create(m_connection);
+    QVERIFY(m_registry->isValid());
+    m_registry->setup();
+    QVERIFY(interfacesAnnouncedSpy.wait());
+
+    m_compositor = m_registry->createCompositor(m_registry->interface(Registry::Interface::Compositor).name,
+                                                m_registry->interface(Registry::Interface::Compositor).version,
+                                                this);
+    QVERIFY(m_compositor->isValid());
+    m_globalProperty = m_registry->createGlobalProperty(m_registry->interface(Registry::Interface::GlobalProperty).name,
+                                                        m_registry->interface(Registry::Interface::GlobalProperty).version,
+                                                        this);
+    QVERIFY(m_globalProperty->isValid());
+    m_strut = m_registry->createStrut(m_registry->interface(Registry::Interface::Strut).name,
+                                      m_registry->interface(Registry::Interface::Strut).version,
+                                      this);
+    QVERIFY(m_strut->isValid());
+
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+    m_surface = m_compositor->createSurface(this);
+    QVERIFY(surfaceCreatedSpy.wait());
+    m_serverSurface = surfaceCreatedSpy.first().first().value<SurfaceInterface *>();
+    QVERIFY(m_serverSurface);
+}
+
+void TestGlobalProperty::cleanup()
+{
+#define CLEANUP(variable)                                                                                                                                      \
+    if (variable) {                                                                                                                                            \
+        delete variable;                                                                                                                                       \
+        variable = nullptr;                                                                                                                                    \
+    }
+    CLEANUP(m_surface)
+    CLEANUP(m_globalProperty)
+    CLEANUP(m_strut)
+    CLEANUP(m_compositor)
+    CLEANUP(m_queue)
+    CLEANUP(m_registry)
+    if (m_connection) {
+        m_connection->deleteLater();
+        m_connection = nullptr;
+    }
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    CLEANUP(m_display)
+#undef CLEANUP
+    // these are the children of the display
+    m_compositorInterface = nullptr;
+    m_globalPropertyInterface = nullptr;
+    m_strutInterface = nullptr;
+    m_serverSurface = nullptr;
+}
+
+void TestGlobalProperty::testJson()
+{
+    // this test verifies that properties sent as JSON are passed on and stored
+    m_globalProperty->setProperty(QString(), QString(), m_surface, 0, QStringLiteral("{\"windowRadius\": 8, \"borderColor\": \"#ff0000\"}"));
+    QTRY_COMPARE(m_changes.count(), 1);
+    QCOMPARE(m_changes.first().count(), 2);
+    QCOMPARE(m_changes.first().value(QStringLiteral("windowRadius")).toInt(), 8);
+    QCOMPARE(m_globalPropertyInterface->surfaceProperty(m_serverSurface, QStringLiteral("borderColor")).toString(), QStringLiteral("#ff0000"));
+
+    m_globalProperty->setProperty(QString(), QString(), m_surface, 0, QStringLiteral("{\"windowRadius\": 4}"));
+    QTRY_COMPARE(m_changes.count(), 2);
+    QCOMPARE(m_changes.last().count(), 1);
+    const QVariantMap properties = m_globalPropertyInterface->surfaceProperties(m_serverSurface);
+    QCOMPARE(properties.count(), 2);
+    QCOMPARE(properties.value(QStringLiteral("windowRadius")).toInt(), 4);
+}
+
+void TestGlobalProperty::testBinary()
+{
+    // this test verifies the binary encoding, the keys are registered with the first update
+    QVariantMap properties;
+    properties.insert(QStringLiteral("noTitlebar"), true);
+    properties.insert(QStringLiteral("windowRadius"), 8);
+    properties.insert(QStringLiteral("shadowOffset"), 2.5);
+    properties.insert(QStringLiteral("borderColor"), QStringLiteral("#ff0000"));
+    properties.insert(QStringLiteral("windowId"), Q_INT64_C(9007199254740993));
+    m_globalProperty->setProperties(QString(), QString(), m_surface, properties);
+    QTRY_COMPARE(m_changes.count(), 1);
+    QCOMPARE(m_changes.first(), properties);
+    QCOMPARE(m_globalPropertyInterface->surfaceProperties(m_serverSurface), properties);
+
+    // later updates refer to the registered keys
+    QVariantMap update;
+    update.insert(QStringLiteral("windowRadius"), 4);
+    update.insert(QStringLiteral("borderColor"), QVariant());
+    m_globalProperty->setProperties(QString(), QString(), m_surface, update);
+    QTRY_COMPARE(m_changes.count(), 2);
+    // the removed property is not passed on
+    QCOMPARE(m_changes.last().count(), 1);
+    QCOMPARE(m_changes.last().value(QStringLiteral("windowRadius")).toInt(), 4);
+    QCOMPARE(m_globalPropertyInterface->surfaceProperty(m_serverSurface, QStringLiteral("windowRadius")).toInt(), 4);
+    QVERIFY(!m_globalPropertyInterface->surfaceProperty(m_serverSurface, QStringLiteral("borderColor")).isValid());
+    QCOMPARE(m_globalPropertyInterface->surfaceProperty(m_serverSurface, QStringLiteral("windowId")).toLongLong(), Q_INT64_C(9007199254740993));
+    QCOMPARE(m_globalPropertyInterface->surfaceProperties(m_serverSurface).count(), 4);
+    QCOMPARE(m_serverSurface->properties()->windowDecoration(), m_globalPropertyInterface->surfaceProperties(m_serverSurface));
+}
+
+void TestGlobalProperty::testInvalidBinary()
+{
+    // this test verifies that records referring to keys which were never registered are ignored
+    const QByteArray record = QByteArray::fromHex("02050001000000");
+    m_globalProperty->setProperty(QString(), QString(), m_surface, 1, QLatin1String("dwpb:") + QString::fromLatin1(record.toBase64()));
+    m_globalProperty->setProperty(QString(), QString(), m_surface, 0, QStringLiteral("{\"windowRadius\": 8}"));
+    QTRY_COMPARE(m_changes.count(), 1);
+    QCOMPARE(m_globalPropertyInterface->surfaceProperties(m_serverSurface).count(), 1);
+}
+
+void TestGlobalProperty::testJsonWithBinaryType()
+{
+    // this test verifies that older clients sending JSON with a non-zero type keep working
+    m_globalProperty->setProperty(QString(), QString(), m_surface, 1, QStringLiteral("{\"windowRadius\": 8}"));
+    QTRY_COMPARE(m_changes.count(), 1);
+    QCOMPARE(m_globalPropertyInterface->surfaceProperty(m_serverSurface, QStringLiteral("windowRadius")).toInt(), 8);
+}
+
+void TestGlobalProperty::testPropertiesChanged()
+{
+    // this test verifies that all properties set before a commit are announced together
+    SurfaceProperties *properties = m_serverSurface->properties();
+    QSignalSpy propertiesChangedSpy(properties, &SurfaceProperties::propertiesChanged);
+    QVERIFY(propertiesChangedSpy.isValid());
+    QSignalSpy committedSpy(m_serverSurface, &SurfaceInterface::committed);
+    QVERIFY(committedSpy.isValid());
+
+    KWayland::Client::deepinKwinStrut strut(0, 0, 0, 40, 0, 0, 0, 0, 0, 0, 0, 1920);
+    m_strut->setStrutPartial(*m_surface, strut);
+    m_globalProperty->setProperty(QString(), QString(), m_surface, 0, QStringLiteral("{\"windowRadius\": 8}"));
+    m_globalProperty->setProperty(QString(), QString(), m_surface, 0, QStringLiteral("{\"borderWidth\": 1}"));
+    m_surface->commit(Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(propertiesChangedSpy.count(), 1);
+    QCOMPARE(propertiesChangedSpy.first().first().value<SurfaceProperties::Properties>(),
+             SurfaceProperties::Property::Strut | SurfaceProperties::Property::WindowDecoration);
+    QCOMPARE(properties->strut().bottom, 40);
+    QCOMPARE(properties->strut().bottom_end_x, 1920);
+    QCOMPARE(properties->windowDecoration().count(), 2);
+
+    // setting the same values again does not announce anything
+    m_strut->setStrutPartial(*m_surface, strut);
+    m_globalProperty->setProperty(QString(), QString(), m_surface, 0, QStringLiteral("{\"windowRadius\": 8}"));
+    m_surface->commit(Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(propertiesChangedSpy.count(), 1);
+
+    // without a commit the changes are announced once the event loop is reached
+    m_globalProperty->setProperty(QString(), QString(), m_surface, 0, QStringLiteral("{\"windowRadius\": 4}"));
+    QVERIFY(propertiesChangedSpy.wait());
+    QCOMPARE(propertiesChangedSpy.last().first().value<SurfaceProperties::Properties>(), SurfaceProperties::Property::WindowDecoration);
+    QCOMPARE(properties->windowDecoration().value(QStringLiteral("windowRadius")).toInt(), 4);
+}
+
+QTEST_GUILESS_MAIN(TestGlobalProperty)
+#include "test_globalproperty.moc"
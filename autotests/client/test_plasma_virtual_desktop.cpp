@@ -40,6 +40,9 @@ private Q_SLOTS:
     void testAllDesktops();
     void testCreateRequested();
     void testRemoveRequested();
+    void testBatchedUpdate();
+    void testSwitchDesktops_data();
+    void testSwitchDesktops();
 
 private:
     KWaylandServer::Display *m_display;
@@ -521,5 +524,168 @@ void TestVirtualDesktop::testRemoveRequested()
     QCOMPARE(desktopRemoveRequestedSpy.first().first().toString(), QStringLiteral("0-1"));
 }
 
+void TestVirtualDesktop::testBatchedUpdate()
+{
+    // rebuild some desktops
+    testCreate();
+
+    KWaylandServer::PlasmaVirtualDesktopManagementInterface *management = m_plasmaVirtualDesktopManagementInterface;
+    KWaylandServer::PlasmaVirtualDesktopInterface *desktop1Int = management->desktops()[0];
+    KWaylandServer::PlasmaVirtualDesktopInterface *desktop2Int = management->desktops()[1];
+    KWaylandServer::PlasmaVirtualDesktopInterface *desktop3Int = management->desktops()[2];
+    KWayland::Client::PlasmaVirtualDesktop *desktop1 = m_plasmaVirtualDesktopManagement->desktops()[0];
+    KWayland::Client::PlasmaVirtualDesktop *desktop2 = m_plasmaVirtualDesktopManagement->desktops()[1];
+    KWayland::Client::PlasmaVirtualDesktop *desktop3 = m_plasmaVirtualDesktopManagement->desktops()[2];
+
+    QSignalSpy desktopCreatedSpy(m_plasmaVirtualDesktopManagement, &PlasmaVirtualDesktopManagement::desktopCreated);
+    QSignalSpy rowsChangedSpy(m_plasmaVirtualDesktopManagement, &PlasmaVirtualDesktopManagement::rowsChanged);
+    QSignalSpy managementDoneSpy(m_plasmaVirtualDesktopManagement, &PlasmaVirtualDesktopManagement::done);
+    QSignalSpy deactivatedSpy(desktop1, &KWayland::Client::PlasmaVirtualDesktop::deactivated);
+    QSignalSpy desktop1DoneSpy(desktop1, &KWayland::Client::PlasmaVirtualDesktop::done);
+    QSignalSpy activatedSpy(desktop2, &KWayland::Client::PlasmaVirtualDesktop::activated);
+    QSignalSpy desktop2DoneSpy(desktop2, &KWayland::Client::PlasmaVirtualDesktop::done);
+    QSignalSpy desktop3DoneSpy(desktop3, &KWayland::Client::PlasmaVirtualDesktop::done);
+
+    // nothing is sent before the update is committed
+    management->beginUpdate();
+    desktop1Int->setActive(false);
+    desktop2Int->setActive(true);
+    management->beginUpdate();
+    desktop3Int->setName(QStringLiteral("Renamed"));
+    management->createDesktop(QStringLiteral("0-4"), 1);
+    management->setRows(2);
+    management->commitUpdate();
+    QVERIFY(!managementDoneSpy.wait(100));
+    QVERIFY(deactivatedSpy.isEmpty());
+
+    management->commitUpdate();
+    QVERIFY(managementDoneSpy.wait());
+    QCOMPARE(managementDoneSpy.count(), 1);
+    QCOMPARE(desktopCreatedSpy.count(), 1);
+    QCOMPARE(desktopCreatedSpy.first().at(0).toString(), QStringLiteral("0-4"));
+    QCOMPARE(desktopCreatedSpy.first().at(1).toUInt(), 1u);
+    QCOMPARE(rowsChangedSpy.count(), 1);
+    QCOMPARE(deactivatedSpy.count(), 1);
+    QCOMPARE(activatedSpy.count(), 1);
+    QCOMPARE(desktop1DoneSpy.count(), 1);
+    QCOMPARE(desktop2DoneSpy.count(), 1);
+    QCOMPARE(desktop3DoneSpy.count(), 1);
+    QCOMPARE(desktop3->name(), QStringLiteral("Renamed"));
+    QVERIFY(desktop2->isActive());
+    QVERIFY(!desktop1->isActive());
+
+    // changes which cancel out are not sent at all
+    management->beginUpdate();
+    desktop2Int->setActive(false);
+    desktop1Int->setActive(true);
+    desktop1Int->setActive(false);
+    desktop2Int->setActive(true);
+    management->commitUpdate();
+    QVERIFY(!desktop2DoneSpy.wait(100));
+    QCOMPARE(desktop1DoneSpy.count(), 1);
+    QCOMPARE(managementDoneSpy.count(), 1);
+
+    // a desktop replaced by one with the same id is removed and created again
+    QSignalSpy desktopRemovedSpy(m_plasmaVirtualDesktopManagement, &PlasmaVirtualDesktopManagement::desktopRemoved);
+    const QString id = desktop3Int->id();
+    management->beginUpdate();
+    management->removeDesktop(id);
+    management->createDesktop(id, 3);
+    management->commitUpdate();
+    QVERIFY(managementDoneSpy.wait());
+    QCOMPARE(desktopRemovedSpy.count(), 1);
+    QCOMPARE(desktopRemovedSpy.first().first().toString(), id);
+    QCOMPARE(desktopCreatedSpy.count(), 2);
+    QCOMPARE(desktopCreatedSpy.last().at(0).toString(), id);
+    QCOMPARE(m_plasmaVirtualDesktopManagement->desktops().count(), 4);
+}
+
+void TestVirtualDesktop::testSwitchDesktops_data()
+{
+    QTest::addColumn<int>("mode");
+
+    // each switch sent right away with a done for every desktop
+    QTest::newRow("unbatched") << 0;
+    // each switch in its own update
+    QTest::newRow("batched") << 1;
+    // the whole sequence in one update
+    QTest::newRow("coalesced") << 2;
+}
+
+void TestVirtualDesktop::testSwitchDesktops()
+{
+    // this benchmark switches through 12 desktops and counts what a pager receives per sequence
+    QFETCH(int, mode);
+    KWaylandServer::PlasmaVirtualDesktopManagementInterface *management = m_plasmaVirtualDesktopManagementInterface;
+    const int desktopCount = 12;
+    management->beginUpdate();
+    for (int i = 0; i < desktopCount; ++i) {
+        management->createDesktop(QStringLiteral("0-%1").arg(i))->setName(QStringLiteral("Desktop %1").arg(i + 1));
+    }
+    QSignalSpy managementDoneSpy(m_plasmaVirtualDesktopManagement, &PlasmaVirtualDesktopManagement::done);
+    management->commitUpdate();
+    QVERIFY(managementDoneSpy.wait());
+    QCOMPARE(m_plasmaVirtualDesktopManagement->desktops().count(), desktopCount);
+
+    // make sure all desktops are bound before counting
+    QSignalSpy lastDoneSpy(m_plasmaVirtualDesktopManagement->desktops().last(), &PlasmaVirtualDesktop::done);
+    for (auto desktop : management->desktops()) {
+        desktop->sendDone();
+    }
+    QVERIFY(lastDoneSpy.wait());
+
+    int events = 0;
+    QObject counter;
+    for (auto desktop : m_plasmaVirtualDesktopManagement->desktops()) {
+        connect(desktop, &PlasmaVirtualDesktop::activated, &counter, [&events] {
+            ++events;
+        });
+        connect(desktop, &PlasmaVirtualDesktop::deactivated, &counter, [&events] {
+            ++events;
+        });
+        connect(desktop, &PlasmaVirtualDesktop::done, &counter, [&events] {
+            ++events;
+        });
+    }
+
+    auto switchTo = [management, mode](int index) {
+        if (mode == 1) {
+            management->beginUpdate();
+        }
+        const auto desktops = management->desktops();
+        for (int i = 0; i < desktops.count(); ++i) {
+            desktops[i]->setActive(i == index);
+        }
+        if (mode == 0) {
+            for (auto desktop : desktops) {
+                desktop->sendDone();
+            }
+        } else if (mode == 1) {
+            management->commitUpdate();
+        }
+    };
+
+    int sequences = 0;
+    QBENCHMARK {
+        if (mode == 2) {
+            management->beginUpdate();
+        }
+        for (int i = 1; i < desktopCount; ++i) {
+            switchTo(i);
+        }
+        switchTo(0);
+        if (mode == 2) {
+            management->commitUpdate();
+        }
+        // the management done only serves as a sync point and is not counted
+        management->sendDone();
+        QVERIFY(managementDoneSpy.wait());
+        ++sequences;
+    }
+
+    // activated, deactivated and done carry no arguments, each is a bare 8 byte message header
+    qInfo() << "events per client and sequence:" << events / sequences << "bytes:" << events * 8 / sequences;
+}
+
 QTEST_GUILESS_MAIN(TestVirtualDesktop)
 #include "test_plasma_virtual_desktop.moc"
@@ -0,0 +1,291 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+// Qt
+#include <QtTest>
+// client
+#include "../../src/client/connection_thread.h"
+#include "../../src/client/event_queue.h"
+#include "../../src/client/output.h"
+#include "../../src/client/registry.h"
+#include "../../src/client/remote_access.h"
+// server
+#include "../../src/server/display.h"
+#include "../../src/server/output_interface.h"
+#include "../../src/server/remote_access_interface.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace KWayland::Client;
+using namespace KWaylandServer;
+
+class TestRemoteAccess : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void testMaximumPendingBuffers();
+    void testRevokedBuffer();
+    void testTargetFrameRate();
+    void testUnchangedFrame();
+    void testSession();
+
+private:
+    Display *m_display = nullptr;
+    OutputInterface *m_serverOutput = nullptr;
+    RemoteAccessManagerInterface *m_remoteAccessInterface = nullptr;
+
+    ConnectionThread *m_connection = nullptr;
+    QThread *m_thread = nullptr;
+    EventQueue *m_queue = nullptr;
+    Registry *m_registry = nullptr;
+    Output *m_output = nullptr;
+    RemoteAccessManager *m_remoteAccess = nullptr;
+
+    // the buffers announced to the client and released by it
+    QVector<RemoteBuffer *> m_clientBuffers;
+    QVector<const BufferHandle *> m_releasedBuffers;
+    BufferHandle m_buffers[2];
+};
+
+static const QString s_socketName = QStringLiteral("kwayland-test-remote-access-0");
+
+void TestRemoteAccess::init()
+{
+    m_display = new Display(this);
+    m_display->addSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+    m_serverOutput = new OutputInterface(m_display, m_display);
+    m_serverOutput->setMode(QSize(1024, 768));
+    m_remoteAccessInterface = new RemoteAccessManagerInterface(m_display);
+    m_releasedBuffers.clear();
+    connect(m_remoteAccessInterface, &RemoteAccessManagerInterface::bufferReleased, this, [this](const BufferHandle *buf) {
+        m_releasedBuffers << buf;
+    });
+    for (BufferHandle &buf : m_buffers) {
+        buf.setFd(::open("/dev/null", O_RDONLY | O_CLOEXEC));
+        QVERIFY(buf.fd() != -1);
+        buf.setSize(1024, 768);
+        buf.setStride(4096);
+        buf.setDamage(QRect(0, 0, 1024, 768));
+    }
+
+    m_connection = new ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &ConnectionThread::connected);
+    QVERIFY(connectedSpy.isValid());
+    m_connection->setSocketName(s_socketName);
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new EventQueue(this);
+    m_queue->setup(m_connection);
+
+    m_registry = new Registry(this);
+    QSignalSpy interfacesAnnouncedSpy(m_registry, &Registry::interfacesAnnounced);
+    QVERIFY(interfacesAnnouncedSpy.isValid());
+    m_registry->setEventQueue(m_queue);
+    m_registry->create(m_connection);
+    QVERIFY(m_registry->isValid());
+    m_registry->setup();
+    QVERIFY(interfacesAnnouncedSpy.wait());
+
+    m_output = m_registry->createOutput(m_registry->interface(Registry::Interface::Output).name,
+                                        m_registry->interface(Registry::Interface::Output).version,
+                                        this);
+    QSignalSpy outputChangedSpy(m_output, &Output::changed);
+    QVERIFY(outputChangedSpy.wait());
+
+    m_remoteAccess = m_registry->createRemoteAccessManager(m_registry->interface(Registry::Interface::RemoteAccessManager).name,
+                                                           m_registry->interface(Registry::Interface::RemoteAccessManager).version,
+                                                           this);
+    QVERIFY(m_remoteAccess->isValid());
+    m_clientBuffers.clear();
+    connect(m_remoteAccess, &RemoteAccessManager::bufferReady, this, [this](const void *output, const RemoteBuffer *rbuf) {
+        Q_UNUSED(output)
+        m_clientBuffers << const_cast<RemoteBuffer *>(rbuf);
+    });
+    QTRY_VERIFY(m_remoteAccessInterface->isBound());
+}
+
+void TestRemoteAccess::cleanup()
+{
+#define CLEANUP(variable)                                                                                                                                      \
+    if (variable) {                                                                                                                                            \
+        delete variable;                                                                                                                                       \
+        variable = nullptr;                                                                                                                                    \
+    }
+    qDeleteAll(m_clientBuffers);
+    m_clientBuffers.clear();
+    CLEANUP(m_remoteAccess)
+    CLEANUP(m_output)
+    CLEANUP(m_queue)
+    CLEANUP(m_registry)
+    if (m_connection) {
+        m_connection->deleteLater();
+        m_connection = nullptr;
+    }
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    CLEANUP(m_remoteAccessInterface)
+    CLEANUP(m_display)
+#undef CLEANUP
+    // this is a child of the display
+    m_serverOutput = nullptr;
+    for (BufferHandle &buf : m_buffers) {
+        ::close(buf.fd());
+    }
+}
+
+void TestRemoteAccess::testMaximumPendingBuffers()
+{
+    // this test verifies that frames for a client holding too many buffers are dropped
+    QCOMPARE(m_remoteAccessInterface->maximumPendingBuffers(), 0);
+    m_remoteAccessInterface->setMaximumPendingBuffers(1);
+
+    m_remoteAccessInterface->sendBufferReady(m_serverOutput, &m_buffers[0]);
+    QTRY_COMPARE(m_clientBuffers.count(), 1);
+    QSignalSpy parametersObtainedSpy(m_clientBuffers.first(), &RemoteBuffer::parametersObtained);
+    QVERIFY(parametersObtainedSpy.wait());
+    QCOMPARE(m_clientBuffers.first()->width(), 1024u);
+
+    // the fetched buffer is pinned, so the new frame is released right away
+    m_remoteAccessInterface->sendBufferReady(m_serverOutput, &m_buffers[1]);
+    QCOMPARE(m_releasedBuffers.count(), 1);
+    QCOMPARE(m_releasedBuffers.first(), &m_buffers[1]);
+    QCOMPARE(m_remoteAccessInterface->droppedFrames(), quint64(1));
+
+    // once the client is done with the buffer it is released and new frames are sent again
+    delete m_clientBuffers.takeFirst();
+    QTRY_COMPARE(m_releasedBuffers.count(), 2);
+    QCOMPARE(m_releasedBuffers.last(), &m_buffers[0]);
+    m_remoteAccessInterface->sendBufferReady(m_serverOutput, &m_buffers[1]);
+    QTRY_COMPARE(m_clientBuffers.count(), 1);
+    QCOMPARE(m_releasedBuffers.count(), 2);
+    QCOMPARE(m_remoteAccessInterface->droppedFrames(), quint64(1));
+
+    // the buffers a client holds are released when the client goes away
+    delete m_remoteAccess;
+    m_remoteAccess = nullptr;
+    // these were children of the manager
+    m_clientBuffers.clear();
+    QTRY_COMPARE(m_releasedBuffers.count(), 3);
+    QCOMPARE(m_releasedBuffers.last(), &m_buffers[1]);
+}
+
+void TestRemoteAccess::testRevokedBuffer()
+{
+    // this test verifies that a client fetching a buffer which got revoked before it dispatched
+    // the announcement is not disconnected
+    m_remoteAccessInterface->setMaximumPendingBuffers(1);
+
+    // the client dispatches its events only once the test returns to the event loop
+    m_remoteAccessInterface->sendBufferReady(m_serverOutput, &m_buffers[0]);
+    m_remoteAccessInterface->sendBufferReady(m_serverOutput, &m_buffers[1]);
+    QCOMPARE(m_releasedBuffers.count(), 1);
+    QCOMPARE(m_releasedBuffers.first(), &m_buffers[0]);
+    QCOMPARE(m_remoteAccessInterface->droppedFrames(), quint64(1));
+
+    QTRY_COMPARE(m_clientBuffers.count(), 2);
+    QSignalSpy parametersObtainedSpy(m_clientBuffers.last(), &RemoteBuffer::parametersObtained);
+    QVERIFY(parametersObtainedSpy.wait());
+    QCOMPARE(m_clientBuffers.last()->width(), 1024u);
+    // the revoked buffer never gets parameters
+    QCOMPARE(m_clientBuffers.first()->width(), 0u);
+
+    // releasing the revoked buffer is fine as well
+    delete m_clientBuffers.takeFirst();
+    QSignalSpy renderSequenceSpy(m_remoteAccess, &RemoteAccessManager::renderSequence);
+    QVERIFY(renderSequenceSpy.isValid());
+    m_remoteAccess->getRendersequence();
+    QVERIFY(renderSequenceSpy.wait());
+    QVERIFY(!m_connection->hasError());
+    QCOMPARE(m_releasedBuffers.count(), 1);
+
+    delete m_clientBuffers.takeFirst();
+    QTRY_COMPARE(m_releasedBuffers.count(), 2);
+    QCOMPARE(m_releasedBuffers.last(), &m_buffers[1]);
+    QVERIFY(!m_connection->hasError());
+}
+
+void TestRemoteAccess::testTargetFrameRate()
+{
+    // this test verifies that frames coming in faster than the target frame rate are skipped
+    m_remoteAccessInterface->setTargetFrameRate(1);
+
+    m_remoteAccessInterface->sendBufferReady(m_serverOutput, &m_buffers[0]);
+    m_remoteAccessInterface->sendBufferReady(m_serverOutput, &m_buffers[1]);
+    QCOMPARE(m_releasedBuffers.count(), 1);
+    QCOMPARE(m_releasedBuffers.first(), &m_buffers[1]);
+    QCOMPARE(m_remoteAccessInterface->droppedFrames(), quint64(1));
+    QTRY_COMPARE(m_clientBuffers.count(), 1);
+}
+
+void TestRemoteAccess::testUnchangedFrame()
+{
+    // this test verifies that frames without damage are not sent to a client which got the previous frame
+    m_buffers[0].setDamage(QRegion());
+    m_remoteAccessInterface->sendBufferReady(m_serverOutput, &m_buffers[0]);
+    QTRY_COMPARE(m_clientBuffers.count(), 1);
+    QVERIFY(m_releasedBuffers.isEmpty());
+
+    m_buffers[1].setDamage(QRegion());
+    m_remoteAccessInterface->sendBufferReady(m_serverOutput, &m_buffers[1]);
+    QCOMPARE(m_releasedBuffers.count(), 1);
+    QCOMPARE(m_releasedBuffers.first(), &m_buffers[1]);
+    QCOMPARE(m_remoteAccessInterface->droppedFrames(), quint64(0));
+
+    m_buffers[1].setDamage(QRect(10, 10, 20, 20));
+    m_remoteAccessInterface->sendBufferReady(m_serverOutput, &m_buffers[1]);
+    QTRY_COMPARE(m_clientBuffers.count(), 2);
+    QCOMPARE(m_releasedBuffers.count(), 1);
+}
+
+void TestRemoteAccess::testSession()
+{
+    // this test verifies that the recording state only changes when a client starts or stops recording
+    QCOMPARE(m_remoteAccessInterface->sessions().count(), 1);
+    RemoteAccessSession *session = m_remoteAccessInterface->sessions().first();
+    QVERIFY(!session->isRecording());
+    QSignalSpy statusChangedSpy(m_remoteAccessInterface, &RemoteAccessManagerInterface::screenRecordStatusChanged);
+    QVERIFY(statusChangedSpy.isValid());
+    QSignalSpy sessionDestroyedSpy(session, &QObject::destroyed);
+    QVERIFY(sessionDestroyedSpy.isValid());
+
+    m_remoteAccessInterface->sendBufferReady(m_serverOutput, &m_buffers[0]);
+    QTRY_VERIFY(session->isRecording());
+    QCOMPARE(statusChangedSpy.count(), 1);
+    QCOMPARE(statusChangedSpy.first().first().toBool(), true);
+    QVERIFY(m_remoteAccessInterface->isRecording());
+
+    // returning buffers and fetching new ones keeps recording
+    delete m_clientBuffers.takeFirst();
+    QTRY_COMPARE(m_releasedBuffers.count(), 1);
+    m_remoteAccessInterface->sendBufferReady(m_serverOutput, &m_buffers[1]);
+    QTRY_COMPARE(session->frameCount(), quint64(2));
+    QCOMPARE(session->exportedBytes(), quint64(2 * 4096 * 768));
+    QCOMPARE(statusChangedSpy.count(), 1);
+
+    // the recording stops when the client goes away
+    delete m_remoteAccess;
+    m_remoteAccess = nullptr;
+    m_clientBuffers.clear();
+    QVERIFY(sessionDestroyedSpy.wait());
+    QCOMPARE(statusChangedSpy.count(), 2);
+    QCOMPARE(statusChangedSpy.last().first().toBool(), false);
+    QVERIFY(m_remoteAccessInterface->sessions().isEmpty());
+}
+
+QTEST_GUILESS_MAIN(TestRemoteAccess)
+#include "test_remote_access.moc"
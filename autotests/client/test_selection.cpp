@@ -10,6 +10,7 @@
 #include "../../src/client/connection_thread.h"
 #include "../../src/client/datadevice.h"
 #include "../../src/client/datadevicemanager.h"
+#include "../../src/client/dataoffer.h"
 #include "../../src/client/datasource.h"
 #include "../../src/client/event_queue.h"
 #include "../../src/client/keyboard.h"
@@ -17,10 +18,14 @@
 #include "../../src/client/seat.h"
 #include "../../src/client/surface.h"
 // server
+#include "../../src/server/abstract_data_source.h"
 #include "../../src/server/compositor_interface.h"
 #include "../../src/server/datadevicemanager_interface.h"
 #include "../../src/server/display.h"
 #include "../../src/server/seat_interface.h"
+// system
+#include <fcntl.h>
+#include <unistd.h>
 
 using namespace KWayland::Client;
 using namespace KWaylandServer;
@@ -32,6 +37,9 @@ private Q_SLOTS:
     void init();
     void cleanup();
     void testClearOnEnter();
+    void testSelectionCache();
+    void testRefocusKeepsOffer();
+    void testFocusChurn();
 
 private:
     Display *m_display = nullptr;
@@ -248,5 +256,208 @@ void SelectionTest::testClearOnEnter()
     QVERIFY(selectionClearedClient1Spy.wait());
 }
 
+static QByteArray receive(DataOffer *offer, const QString &mimeType)
+{
+    int pipeFds[2] = {0, 0};
+    if (pipe2(pipeFds, O_CLOEXEC | O_NONBLOCK) != 0) {
+        return QByteArray();
+    }
+    offer->receive(mimeType, pipeFds[1]);
+    close(pipeFds[1]);
+
+    // the source client and the compositor live in this thread, keep them going while reading
+    QByteArray content;
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < 5000) {
+        char buffer[4096];
+        const ssize_t count = read(pipeFds[0], buffer, sizeof(buffer));
+        if (count == 0) {
+            break;
+        }
+        if (count > 0) {
+            content.append(buffer, count);
+        } else {
+            QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+        }
+    }
+    close(pipeFds[0]);
+    return content;
+}
+
+void SelectionTest::testSelectionCache()
+{
+    // this test verifies that the content of the selection is requested only once from the source
+    QCOMPARE(m_seatInterface->selectionCacheSize(), qint64(0));
+    m_seatInterface->setSelectionCacheSize(1024 * 1024);
+    QCOMPARE(m_seatInterface->selectionCacheSize(), qint64(1024 * 1024));
+
+    QSignalSpy keyboardEnteredClient1Spy(m_client1.keyboard, &Keyboard::entered);
+    QVERIFY(keyboardEnteredClient1Spy.isValid());
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+    QScopedPointer<Surface> s1(m_client1.compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto serverSurface1 = surfaceCreatedSpy.first().first().value<SurfaceInterface *>();
+    m_seatInterface->setFocusedKeyboardSurface(serverSurface1);
+    QVERIFY(keyboardEnteredClient1Spy.wait());
+
+    // small enough to fit into a pipe, the source writes without anybody reading yet
+    const QByteArray content = QByteArray(32 * 1024, 'k');
+    QScopedPointer<DataSource> dataSource(m_client1.ddm->createDataSource());
+    QSignalSpy sendRequestedSpy(dataSource.data(), &DataSource::sendDataRequested);
+    QVERIFY(sendRequestedSpy.isValid());
+    connect(dataSource.data(), &DataSource::sendDataRequested, this, [content](const QString &mimeType, qint32 fd) {
+        Q_UNUSED(mimeType)
+        QFile file;
+        file.open(fd, QIODevice::WriteOnly, QFileDevice::AutoCloseHandle);
+        file.write(content);
+        file.close();
+    });
+    dataSource->offer(QStringLiteral("text/plain"));
+    m_client1.dataDevice->setSelection(keyboardEnteredClient1Spy.first().first().value<quint32>(), dataSource.data());
+
+    // bring in client 2, which pastes
+    QSignalSpy selectionOfferedClient2Spy(m_client2.dataDevice, &DataDevice::selectionOffered);
+    QVERIFY(selectionOfferedClient2Spy.isValid());
+    QScopedPointer<Surface> s2(m_client2.compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto serverSurface2 = surfaceCreatedSpy.last().first().value<SurfaceInterface *>();
+    m_seatInterface->setFocusedKeyboardSurface(serverSurface2);
+    QVERIFY(selectionOfferedClient2Spy.wait());
+    auto offer = selectionOfferedClient2Spy.first().first().value<DataOffer *>();
+    QVERIFY(offer);
+
+    QCOMPARE(receive(offer, QStringLiteral("text/plain")), content);
+    QCOMPARE(sendRequestedSpy.count(), 1);
+    // served by the compositor
+    QCOMPARE(receive(offer, QStringLiteral("text/plain")), content);
+    QCOMPARE(receive(offer, QStringLiteral("text/plain")), content);
+    QCOMPARE(sendRequestedSpy.count(), 1);
+
+    // content exceeding the limit is always requested from the source
+    m_seatInterface->setSelectionCacheSize(1024);
+    QCOMPARE(receive(offer, QStringLiteral("text/plain")), content);
+    QCOMPARE(receive(offer, QStringLiteral("text/plain")), content);
+    QCOMPARE(sendRequestedSpy.count(), 3);
+
+    // without the cache every paste reaches the source
+    m_seatInterface->setSelectionCacheSize(0);
+    QCOMPARE(receive(offer, QStringLiteral("text/plain")), content);
+    QCOMPARE(sendRequestedSpy.count(), 4);
+}
+
+void SelectionTest::testRefocusKeepsOffer()
+{
+    // this test verifies that a client which still holds the offer for the current selection is not sent a new one
+    QSignalSpy keyboardEnteredClient1Spy(m_client1.keyboard, &Keyboard::entered);
+    QVERIFY(keyboardEnteredClient1Spy.isValid());
+    QSignalSpy keyboardEnteredClient2Spy(m_client2.keyboard, &Keyboard::entered);
+    QVERIFY(keyboardEnteredClient2Spy.isValid());
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+    QScopedPointer<Surface> s1(m_client1.compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto serverSurface1 = surfaceCreatedSpy.first().first().value<SurfaceInterface *>();
+    QScopedPointer<Surface> s2(m_client2.compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto serverSurface2 = surfaceCreatedSpy.last().first().value<SurfaceInterface *>();
+
+    m_seatInterface->setFocusedKeyboardSurface(serverSurface1);
+    QVERIFY(keyboardEnteredClient1Spy.wait());
+    QScopedPointer<DataSource> dataSource(m_client1.ddm->createDataSource());
+    dataSource->offer(QStringLiteral("text/plain"));
+    QSignalSpy selectionChangedSpy(m_seatInterface, &SeatInterface::selectionChanged);
+    QVERIFY(selectionChangedSpy.isValid());
+    m_client1.dataDevice->setSelection(keyboardEnteredClient1Spy.first().first().value<quint32>(), dataSource.data());
+    QVERIFY(selectionChangedSpy.wait());
+
+    QSignalSpy selectionOfferedClient2Spy(m_client2.dataDevice, &DataDevice::selectionOffered);
+    QVERIFY(selectionOfferedClient2Spy.isValid());
+    m_seatInterface->setFocusedKeyboardSurface(serverSurface2);
+    QVERIFY(selectionOfferedClient2Spy.wait());
+    auto offer = selectionOfferedClient2Spy.first().first().value<DataOffer *>();
+    QCOMPARE(offer->offeredMimeTypes().count(), 1);
+
+    // going back and forth does not create new offers
+    m_seatInterface->setFocusedKeyboardSurface(serverSurface1);
+    m_seatInterface->setFocusedKeyboardSurface(serverSurface2);
+    QVERIFY(keyboardEnteredClient2Spy.wait());
+    QCOMPARE(selectionOfferedClient2Spy.count(), 1);
+
+    // but a new selection does
+    QScopedPointer<DataSource> dataSource2(m_client2.ddm->createDataSource());
+    dataSource2->offer(QStringLiteral("text/html"));
+    m_client2.dataDevice->setSelection(keyboardEnteredClient2Spy.last().first().value<quint32>(), dataSource2.data());
+    QVERIFY(selectionOfferedClient2Spy.wait());
+    QCOMPARE(selectionOfferedClient2Spy.count(), 2);
+}
+
+class ClipboardManagerSource : public AbstractDataSource
+{
+    Q_OBJECT
+public:
+    explicit ClipboardManagerSource(QObject *parent = nullptr)
+        : AbstractDataSource(parent)
+    {
+    }
+
+    void requestData(const QString &mimeType, qint32 fd) override
+    {
+        Q_UNUSED(mimeType)
+        close(fd);
+    }
+    void cancel() override
+    {
+    }
+    QStringList mimeTypes() const override
+    {
+        return {QStringLiteral("text/plain"),
+                QStringLiteral("text/plain;charset=utf-8"),
+                QStringLiteral("text/html"),
+                QStringLiteral("application/x-kde-onlyReplaceEmpty"),
+                QStringLiteral("image/png")};
+    }
+};
+
+void SelectionTest::testFocusChurn()
+{
+    // this benchmark simulates a clipboard manager re-setting the selection while the keyboard focus
+    // moves between 50 clients
+    QVector<Connection> connections(50);
+    QVector<Surface *> surfaces;
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+    for (Connection &c : connections) {
+        QVERIFY(setupConnection(&c));
+        surfaces << c.compositor->createSurface(this);
+    }
+    QTRY_COMPARE(surfaceCreatedSpy.count(), connections.count());
+    QVector<SurfaceInterface *> serverSurfaces;
+    for (const QList<QVariant> &arguments : qAsConst(surfaceCreatedSpy)) {
+        serverSurfaces << arguments.first().value<SurfaceInterface *>();
+    }
+
+    ClipboardManagerSource sources[2];
+    int focusChanges = 0;
+    QBENCHMARK {
+        for (SurfaceInterface *surface : qAsConst(serverSurfaces)) {
+            if (focusChanges++ % 10 == 0) {
+                m_seatInterface->setSelection(&sources[(focusChanges / 10) % 2]);
+            }
+            m_seatInterface->setFocusedKeyboardSurface(surface);
+            // lets the display flush the clients like the compositor's event loop would
+            QCoreApplication::processEvents();
+        }
+    }
+
+    m_seatInterface->setFocusedKeyboardSurface(nullptr);
+    m_seatInterface->setSelection(nullptr);
+    qDeleteAll(surfaces);
+    for (Connection &c : connections) {
+        cleanupConnection(&c);
+    }
+}
+
 QTEST_GUILESS_MAIN(SelectionTest)
 #include "test_selection.moc"
@@ -32,6 +32,10 @@ private Q_SLOTS:
     void testCreateBufferFromImageWithAlpha();
     void testCreateBufferFromData();
     void testReuseBuffer();
+    void testCreateBufferFromUnpremultipliedImage();
+    void testCreateBufferFromOtherFormat_data();
+    void testCreateBufferFromOtherFormat();
+    void testCreateBufferWithDamage();
 
 private:
     KWaylandServer::Display *m_display;
@@ -204,5 +208,96 @@ void TestShmPool::testReuseBuffer()
     QVERIFY(buffer4 != buffer3);
 }
 
+void TestShmPool::testCreateBufferFromUnpremultipliedImage()
+{
+    QVERIFY(m_shmPool->isValid());
+    QImage img(24, 24, QImage::Format_ARGB32);
+    img.fill(QColor(255, 0, 0, 100));
+    img.setPixel(0, 0, qRgba(0, 255, 0, 0));
+    img.setPixel(1, 0, qRgba(0, 0, 255, 255));
+    auto buffer = m_shmPool->createBuffer(img).toStrongRef();
+    QVERIFY(buffer);
+    QCOMPARE(buffer->format(), KWayland::Client::Buffer::Format::ARGB32);
+    QImage img2(buffer->address(), img.width(), img.height(), QImage::Format_ARGB32_Premultiplied);
+    QCOMPARE(img2, img.convertToFormat(QImage::Format_ARGB32_Premultiplied));
+}
+
+void TestShmPool::testCreateBufferFromOtherFormat_data()
+{
+    QTest::addColumn<int>("format");
+    QTest::addColumn<bool>("withDamage");
+
+    QTest::newRow("rgb888") << int(QImage::Format_RGB888) << false;
+    QTest::newRow("rgb888/damage") << int(QImage::Format_RGB888) << true;
+    QTest::newRow("rgb16") << int(QImage::Format_RGB16) << false;
+    QTest::newRow("rgb16/damage") << int(QImage::Format_RGB16) << true;
+    QTest::newRow("rgba8888") << int(QImage::Format_RGBA8888) << false;
+}
+
+void TestShmPool::testCreateBufferFromOtherFormat()
+{
+    // this test verifies that images with less than 32 bits per pixel get a buffer large enough for the converted image
+    QVERIFY(m_shmPool->isValid());
+    QFETCH(int, format);
+    QImage img(23, 24, QImage::Format(format));
+    img.fill(Qt::red);
+    img.setPixel(0, 0, qRgb(0, 255, 0));
+    img.setPixel(22, 23, qRgb(0, 0, 255));
+    QFETCH(bool, withDamage);
+    auto buffer = (withDamage ? m_shmPool->createBuffer(img, img.rect()) : m_shmPool->createBuffer(img)).toStrongRef();
+    QVERIFY(buffer);
+    QCOMPARE(buffer->format(), KWayland::Client::Buffer::Format::ARGB32);
+    QCOMPARE(buffer->size(), img.size());
+    QCOMPARE(buffer->stride(), img.width() * 4);
+    QImage img2(buffer->address(), img.width(), img.height(), buffer->stride(), QImage::Format_ARGB32_Premultiplied);
+    QCOMPARE(img2, img.convertToFormat(QImage::Format_ARGB32_Premultiplied));
+}
+
+void TestShmPool::testCreateBufferWithDamage()
+{
+    // this test verifies that reused buffers only get the damage since they were used last copied
+    QVERIFY(m_shmPool->isValid());
+    QImage img(24, 24, QImage::Format_ARGB32_Premultiplied);
+    img.fill(Qt::black);
+    auto buffer = m_shmPool->createBuffer(img, img.rect()).toStrongRef();
+    QVERIFY(buffer);
+    QCOMPARE(buffer->age(), 0);
+    auto buffer2 = m_shmPool->createBuffer(img, img.rect()).toStrongRef();
+    QVERIFY(buffer2);
+    QVERIFY(buffer2 != buffer);
+    QCOMPARE(buffer2->age(), 0);
+
+    // the first buffer is two frames old
+    buffer->setReleased(true);
+    img.fillRect(QRect(2, 2, 4, 4), Qt::red);
+    auto buffer3 = m_shmPool->createBuffer(img, QRect(2, 2, 4, 4)).toStrongRef();
+    QCOMPARE(buffer3, buffer);
+    QCOMPARE(buffer3->age(), 2);
+    QCOMPARE(QImage(buffer3->address(), img.width(), img.height(), QImage::Format_ARGB32_Premultiplied), img);
+
+    // the second buffer gets the damage of both frames, the rest is left untouched
+    buffer2->setReleased(true);
+    reinterpret_cast<QRgb *>(buffer2->address())[0] = qRgba(1, 2, 3, 255);
+    img.fillRect(QRect(10, 10, 4, 4), Qt::blue);
+    auto buffer4 = m_shmPool->createBuffer(img, QRect(10, 10, 4, 4)).toStrongRef();
+    QCOMPARE(buffer4, buffer2);
+    QCOMPARE(buffer4->age(), 2);
+    const QImage img2(buffer4->address(), img.width(), img.height(), QImage::Format_ARGB32_Premultiplied);
+    QCOMPARE(img2.pixel(0, 0), qRgba(1, 2, 3, 255));
+    QCOMPARE(img2.copy(2, 2, 4, 4), img.copy(2, 2, 4, 4));
+    QCOMPARE(img2.copy(10, 10, 4, 4), img.copy(10, 10, 4, 4));
+
+    // the damage of a buffer used directly is unknown
+    auto buffer5 = m_shmPool->getBuffer(img.size(), img.bytesPerLine()).toStrongRef();
+    QVERIFY(buffer5);
+    QCOMPARE(buffer5->age(), 0);
+    buffer4->setReleased(true);
+    reinterpret_cast<QRgb *>(buffer4->address())[0] = qRgba(1, 2, 3, 255);
+    auto buffer6 = m_shmPool->createBuffer(img, QRegion()).toStrongRef();
+    QCOMPARE(buffer6, buffer2);
+    QCOMPARE(buffer6->age(), 2);
+    QCOMPARE(QImage(buffer6->address(), img.width(), img.height(), QImage::Format_ARGB32_Premultiplied), img);
+}
+
 QTEST_GUILESS_MAIN(TestShmPool)
 #include "test_shm_pool.moc"
@@ -0,0 +1,162 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+// Qt
+#include <QtTest>
+// KWin
+#include "../../src/client/connection_thread.h"
+#include "../../src/client/event_queue.h"
+#include "../../src/server/display.h"
+// Wayland
+#include <wayland-client-protocol.h>
+
+using KWayland::Client::ConnectionThread;
+using KWayland::Client::EventQueue;
+
+class TestConnectionThread : public QObject
+{
+    Q_OBJECT
+public:
+    explicit TestConnectionThread(QObject *parent = nullptr);
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void testEventQueueDispatch_data();
+    void testEventQueueDispatch();
+    void testDispatchThroughput_data();
+    void testDispatchThroughput();
+
+private:
+    void connectToServer(ConnectionThread::ReadMode mode);
+    int syncOnQueue(int count);
+
+    KWaylandServer::Display *m_display = nullptr;
+    ConnectionThread *m_connection = nullptr;
+    EventQueue *m_queue = nullptr;
+    QThread *m_thread = nullptr;
+};
+
+static const QString s_socketName = QStringLiteral("kwayland-test-connection-thread-0");
+
+TestConnectionThread::TestConnectionThread(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void TestConnectionThread::init()
+{
+    using namespace KWaylandServer;
+    delete m_display;
+    m_display = new Display(this);
+    m_display->addSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+}
+
+void TestConnectionThread::connectToServer(ConnectionThread::ReadMode mode)
+{
+    m_connection = new ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+    m_connection->setReadMode(mode);
+    QCOMPARE(m_connection->readMode(), mode);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new EventQueue(this);
+    m_queue->setup(m_connection);
+    QVERIFY(m_queue->isValid());
+}
+
+void TestConnectionThread::cleanup()
+{
+    delete m_queue;
+    m_queue = nullptr;
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    delete m_connection;
+    m_connection = nullptr;
+
+    delete m_display;
+    m_display = nullptr;
+}
+
+static void syncDone(void *data, wl_callback *callback, uint32_t serial)
+{
+    Q_UNUSED(serial)
+    ++(*reinterpret_cast<int *>(data));
+    wl_callback_destroy(callback);
+}
+
+static const wl_callback_listener s_syncListener = {syncDone};
+
+int TestConnectionThread::syncOnQueue(int count)
+{
+    wl_display *display = m_connection->display();
+    auto wrapper = reinterpret_cast<wl_display *>(wl_proxy_create_wrapper(display));
+    m_queue->addProxy(wrapper);
+
+    int done = 0;
+    for (int i = 0; i < count; ++i) {
+        wl_callback *callback = wl_display_sync(wrapper);
+        wl_callback_add_listener(callback, &s_syncListener, &done);
+    }
+    wl_proxy_wrapper_destroy(wrapper);
+    wl_display_flush(display);
+
+    QElapsedTimer timer;
+    timer.start();
+    while (done < count && timer.elapsed() < 5000) {
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents, 100);
+    }
+    return done;
+}
+
+void TestConnectionThread::testEventQueueDispatch_data()
+{
+    QTest::addColumn<ConnectionThread::ReadMode>("mode");
+
+    QTest::newRow("socketNotifier") << ConnectionThread::ReadMode::SocketNotifier;
+    QTest::newRow("dedicatedThread") << ConnectionThread::ReadMode::DedicatedThread;
+}
+
+void TestConnectionThread::testEventQueueDispatch()
+{
+    // an EventQueue in a different thread than the connection gets dispatched without eventsRead
+    QFETCH(ConnectionThread::ReadMode, mode);
+    connectToServer(mode);
+    QVERIFY(m_queue);
+
+    QCOMPARE(syncOnQueue(1), 1);
+    QCOMPARE(syncOnQueue(100), 100);
+}
+
+void TestConnectionThread::testDispatchThroughput_data()
+{
+    testEventQueueDispatch_data();
+}
+
+void TestConnectionThread::testDispatchThroughput()
+{
+    QFETCH(ConnectionThread::ReadMode, mode);
+    connectToServer(mode);
+    QVERIFY(m_queue);
+
+    QBENCHMARK {
+        QCOMPARE(syncOnQueue(1000), 1000);
+    }
+}
+
+QTEST_GUILESS_MAIN(TestConnectionThread)
+#include "test_wayland_connectionthread.moc"
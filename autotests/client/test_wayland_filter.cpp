@@ -18,8 +18,11 @@
 #include "../../src/client/registry.h"
 #include "../../src/client/surface.h"
 
+#include <wayland-client.h>
 #include <wayland-server.h>
 
+#include <sys/resource.h>
+
 using namespace KWayland::Client;
 
 class TestDisplay;
@@ -34,6 +37,8 @@ private Q_SLOTS:
     void cleanup();
     void testFilter_data();
     void testFilter();
+    void testFilterCache();
+    void testRegistryEnumeration();
 
 private:
     TestDisplay *m_display;
@@ -51,6 +56,7 @@ public:
     TestDisplay(QObject *parent);
     bool allowInterface(KWaylandServer::ClientConnection *client, const QByteArray &interfaceName) override;
     QList<wl_client *> m_allowedClients;
+    QAtomicInt m_allowInterfaceCalls;
 };
 
 TestDisplay::TestDisplay(QObject *parent)
@@ -60,6 +66,7 @@ TestDisplay::TestDisplay(QObject *parent)
 
 bool TestDisplay::allowInterface(KWaylandServer::ClientConnection *client, const QByteArray &interfaceName)
 {
+    m_allowInterfaceCalls.ref();
     if (interfaceName == "org_kde_kwin_blur_manager") {
         return m_allowedClients.contains(*client);
     }
@@ -145,5 +152,90 @@ void TestFilter::testFilter()
     thread->wait();
 }
 
+static void enumerateRegistry(wl_display *client)
+{
+    // no listener on the registry, the announced globals are just dropped
+    wl_registry *registry = wl_display_get_registry(client);
+    wl_display_roundtrip(client);
+    wl_registry_destroy(registry);
+}
+
+void TestFilter::testFilterCache()
+{
+    // the display is threaded so that the test can block in wl_display_roundtrip
+    QScopedPointer<TestDisplay> display(new TestDisplay(nullptr));
+    display->addSocketName(QStringLiteral("kwayland-test-wayland-filter-cache"));
+    new KWaylandServer::CompositorInterface(display.data(), display.data());
+    new KWaylandServer::BlurManagerInterface(display.data(), display.data());
+    QVERIFY(display->startThreaded());
+
+    wl_display *client = wl_display_connect("kwayland-test-wayland-filter-cache");
+    QVERIFY(client);
+    enumerateRegistry(client);
+    const int calls = display->m_allowInterfaceCalls.loadAcquire();
+    QVERIFY(calls >= 2);
+
+    // the decisions are reused for the same client
+    enumerateRegistry(client);
+    QCOMPARE(display->m_allowInterfaceCalls.loadAcquire(), calls);
+
+    // but not after the policy changed
+    display->invalidateFilter();
+    enumerateRegistry(client);
+    QCOMPARE(display->m_allowInterfaceCalls.loadAcquire(), calls * 2);
+
+    // nor for another client
+    wl_display *otherClient = wl_display_connect("kwayland-test-wayland-filter-cache");
+    QVERIFY(otherClient);
+    enumerateRegistry(otherClient);
+    QCOMPARE(display->m_allowInterfaceCalls.loadAcquire(), calls * 3);
+
+    wl_display_disconnect(otherClient);
+    wl_display_disconnect(client);
+}
+
+void TestFilter::testRegistryEnumeration()
+{
+    const int clientCount = 500;
+    // every client needs a socket on both ends
+    rlimit limit;
+    QCOMPARE(getrlimit(RLIMIT_NOFILE, &limit), 0);
+    if (limit.rlim_cur < rlim_t(clientCount * 2 + 64)) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+        if (limit.rlim_cur < rlim_t(clientCount * 2 + 64)) {
+            QSKIP("Not enough file descriptors available");
+        }
+    }
+
+    QScopedPointer<TestDisplay> display(new TestDisplay(nullptr));
+    display->addSocketName(QStringLiteral("kwayland-test-wayland-filter-enumeration"));
+    new KWaylandServer::CompositorInterface(display.data(), display.data());
+    new KWaylandServer::BlurManagerInterface(display.data(), display.data());
+    // about as many globals as a typical compositor announces, they are never bound
+    const wl_interface *interfaces[] = {&wl_output_interface, &wl_seat_interface, &wl_shm_interface, &wl_subcompositor_interface, &wl_data_device_manager_interface};
+    for (int i = 0; i < 70; ++i) {
+        wl_global_create(*display, interfaces[i % 5], 1, nullptr, [](wl_client *, void *, uint32_t, uint32_t) {});
+    }
+    QVERIFY(display->startThreaded());
+
+    QVector<wl_display *> clients;
+    for (int i = 0; i < clientCount; ++i) {
+        wl_display *client = wl_display_connect("kwayland-test-wayland-filter-enumeration");
+        QVERIFY(client);
+        clients << client;
+    }
+
+    QBENCHMARK {
+        for (wl_display *client : qAsConst(clients)) {
+            enumerateRegistry(client);
+        }
+    }
+
+    for (wl_display *client : qAsConst(clients)) {
+        wl_display_disconnect(client);
+    }
+}
+
 QTEST_GUILESS_MAIN(TestFilter)
 #include "test_wayland_filter.moc"
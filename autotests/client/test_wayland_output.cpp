@@ -29,6 +29,7 @@ private Q_SLOTS:
     void testRegistry();
     void testModeChange();
     void testScaleChange();
+    void testUpdate();
 
     void testSubPixel_data();
     void testSubPixel();
@@ -271,6 +272,50 @@ void TestWaylandOutput::testScaleChange()
     QCOMPARE(output.scale(), 4);
 }
 
+void TestWaylandOutput::testUpdate()
+{
+    KWayland::Client::Registry registry;
+    QSignalSpy announced(&registry, &KWayland::Client::Registry::outputAnnounced);
+    registry.create(m_connection->display());
+    QVERIFY(registry.isValid());
+    registry.setup();
+    wl_display_flush(m_connection->display());
+    QVERIFY(announced.wait());
+
+    KWayland::Client::Output output;
+    QSignalSpy outputChanged(&output, &KWayland::Client::Output::changed);
+    QVERIFY(outputChanged.isValid());
+    output.setup(registry.bindOutput(announced.first().first().value<quint32>(), announced.first().last().value<quint32>()));
+    wl_display_flush(m_connection->display());
+    QVERIFY(outputChanged.wait());
+
+    // all changes of an update are sent with a single done
+    outputChanged.clear();
+    QSignalSpy serverScaleChanged(m_serverOutput, &KWaylandServer::OutputInterface::scaleChanged);
+    QVERIFY(serverScaleChanged.isValid());
+    m_serverOutput->beginUpdate();
+    m_serverOutput->setScale(2);
+    m_serverOutput->setMode(QSize(1280, 1024), 90000);
+    m_serverOutput->setTransform(KWaylandServer::OutputInterface::Transform::Rotated90);
+    QCOMPARE(serverScaleChanged.count(), 1);
+    m_serverOutput->commitUpdate();
+    QVERIFY(outputChanged.wait());
+    QCOMPARE(output.scale(), 2);
+    QCOMPARE(output.pixelSize(), QSize(1280, 1024));
+    QCOMPARE(output.refreshRate(), 90000);
+    QCOMPARE(output.transform(), KWayland::Client::Output::Transform::Rotated90);
+    QVERIFY(!outputChanged.wait(100));
+    QCOMPARE(outputChanged.count(), 1);
+
+    // an update which ends in the state the clients know about sends nothing
+    m_serverOutput->beginUpdate();
+    m_serverOutput->setScale(1);
+    m_serverOutput->setScale(2);
+    m_serverOutput->commitUpdate();
+    QVERIFY(!outputChanged.wait(100));
+    QCOMPARE(outputChanged.count(), 1);
+}
+
 void TestWaylandOutput::testSubPixel_data()
 {
     using namespace KWayland::Client;
@@ -0,0 +1,183 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+// Qt
+#include <QtTest>
+// KWin
+#include "../../src/client/connection_thread.h"
+#include "../../src/client/event_queue.h"
+#include "../../src/client/outputdevice_v2.h"
+#include "../../src/client/registry.h"
+#include "../../src/server/display.h"
+#include "../../src/server/outputdevice_v2_interface.h"
+
+using namespace KWayland::Client;
+using namespace KWaylandServer;
+
+class TestWaylandOutputDeviceV2 : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void testUpdate();
+    void testSetSameModes();
+
+private:
+    Display *m_display = nullptr;
+    OutputDeviceV2Interface *m_serverOutputDevice = nullptr;
+
+    ConnectionThread *m_connection = nullptr;
+    EventQueue *m_queue = nullptr;
+    Registry *m_registry = nullptr;
+    OutputDeviceV2 *m_outputDevice = nullptr;
+    QThread *m_thread = nullptr;
+};
+
+static const QString s_socketName = QStringLiteral("kwin-test-wayland-output-device-v2-0");
+
+static QList<OutputDeviceModeV2Interface *> createModes()
+{
+    return {
+        new OutputDeviceModeV2Interface(QSize(800, 600), 60000, OutputDeviceModeV2Interface::ModeFlag::Preferred),
+        new OutputDeviceModeV2Interface(QSize(1024, 768), 60000, OutputDeviceModeV2Interface::ModeFlags()),
+        new OutputDeviceModeV2Interface(QSize(1280, 1024), 90000, OutputDeviceModeV2Interface::ModeFlag::Current),
+    };
+}
+
+void TestWaylandOutputDeviceV2::init()
+{
+    m_display = new Display(this);
+    m_display->addSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+
+    m_serverOutputDevice = new OutputDeviceV2Interface(m_display, this);
+    m_serverOutputDevice->setModes(createModes());
+    m_serverOutputDevice->setGlobalPosition(QPoint(100, 100));
+
+    m_connection = new ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new EventQueue(this);
+    m_queue->setup(m_connection);
+
+    m_registry = new Registry(this);
+    QSignalSpy interfacesAnnouncedSpy(m_registry, &Registry::interfacesAnnounced);
+    m_registry->setEventQueue(m_queue);
+    m_registry->create(m_connection);
+    QVERIFY(m_registry->isValid());
+    m_registry->setup();
+    QVERIFY(interfacesAnnouncedSpy.wait());
+
+    m_outputDevice = new OutputDeviceV2(this);
+    QSignalSpy doneSpy(m_outputDevice, &OutputDeviceV2::done);
+    m_outputDevice->setup(m_registry->bindOutputDeviceV2(m_registry->interface(Registry::Interface::OutputDeviceV2).name,
+                                                         m_registry->interface(Registry::Interface::OutputDeviceV2).version));
+    QVERIFY(doneSpy.wait());
+    QCOMPARE(m_outputDevice->modes().count(), 3);
+}
+
+void TestWaylandOutputDeviceV2::cleanup()
+{
+#define CLEANUP(variable)                                                                                                                                      \
+    if (variable) {                                                                                                                                            \
+        delete variable;                                                                                                                                       \
+        variable = nullptr;                                                                                                                                    \
+    }
+    CLEANUP(m_outputDevice)
+    CLEANUP(m_registry)
+    CLEANUP(m_queue)
+    if (m_connection) {
+        m_connection->deleteLater();
+        m_connection = nullptr;
+    }
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    CLEANUP(m_serverOutputDevice)
+    CLEANUP(m_display)
+#undef CLEANUP
+}
+
+void TestWaylandOutputDeviceV2::testUpdate()
+{
+    // this test verifies that all changes of an update are sent with a single done
+    QSignalSpy doneSpy(m_outputDevice, &OutputDeviceV2::done);
+    QSignalSpy enabledChangedSpy(m_outputDevice, &OutputDeviceV2::enabledChanged);
+    QSignalSpy overscanChangedSpy(m_outputDevice, &OutputDeviceV2::overscanChanged);
+
+    m_serverOutputDevice->beginUpdate();
+    m_serverOutputDevice->setScale(2);
+    m_serverOutputDevice->setGlobalPosition(QPoint(200, 100));
+    m_serverOutputDevice->setTransform(OutputDeviceV2Interface::Transform::Rotated90);
+    m_serverOutputDevice->setEnabled(false);
+    m_serverOutputDevice->setOverscan(20);
+    QVERIFY(m_serverOutputDevice->setCurrentMode(QSize(1024, 768), 60000));
+    m_serverOutputDevice->commitUpdate();
+
+    QVERIFY(doneSpy.wait());
+    QCOMPARE(m_outputDevice->scaleF(), 2.0);
+    QCOMPARE(m_outputDevice->globalPosition(), QPoint(200, 100));
+    QCOMPARE(m_outputDevice->transform(), OutputDeviceV2::Transform::Rotated90);
+    QCOMPARE(m_outputDevice->enabled(), OutputDeviceV2::Enablement::Disabled);
+    QCOMPARE(m_outputDevice->overscan(), 20u);
+    QCOMPARE(m_outputDevice->pixelSize(), QSize(1024, 768));
+    QCOMPARE(enabledChangedSpy.count(), 1);
+    QCOMPARE(overscanChangedSpy.count(), 1);
+    QVERIFY(!doneSpy.wait(100));
+    QCOMPARE(doneSpy.count(), 1);
+
+    // changes which are reverted within the update are not sent
+    m_serverOutputDevice->beginUpdate();
+    m_serverOutputDevice->setScale(1);
+    m_serverOutputDevice->setOverscan(0);
+    m_serverOutputDevice->setScale(2);
+    m_serverOutputDevice->setOverscan(20);
+    m_serverOutputDevice->commitUpdate();
+    QVERIFY(!doneSpy.wait(100));
+    QCOMPARE(doneSpy.count(), 1);
+}
+
+void TestWaylandOutputDeviceV2::testSetSameModes()
+{
+    // this test verifies that setting modes with unchanged parameters keeps the client's mode objects
+    QSignalSpy modeAddedSpy(m_outputDevice, &OutputDeviceV2::modeAdded);
+    QSignalSpy doneSpy(m_outputDevice, &OutputDeviceV2::done);
+    const auto clientModes = m_outputDevice->modes();
+
+    auto modes = createModes();
+    m_serverOutputDevice->setModes(modes);
+    QVERIFY(!doneSpy.wait(100));
+    QVERIFY(modeAddedSpy.isEmpty());
+    QCOMPARE(m_outputDevice->modes(), clientModes);
+
+    // the new objects represent the modes the client knows about
+    QVERIFY(m_serverOutputDevice->setCurrentMode(QSize(800, 600), 60000));
+    QVERIFY(doneSpy.wait());
+    QCOMPARE(m_outputDevice->currentMode(), clientModes.first());
+    QVERIFY(modes.first()->flags().testFlag(OutputDeviceModeV2Interface::ModeFlag::Current));
+
+    // only the added mode is announced
+    modes = createModes();
+    modes << new OutputDeviceModeV2Interface(QSize(1920, 1080), 60000, OutputDeviceModeV2Interface::ModeFlags());
+    m_serverOutputDevice->setModes(modes);
+    QVERIFY(doneSpy.wait());
+    QCOMPARE(modeAddedSpy.count(), 1);
+    QCOMPARE(m_outputDevice->modes().count(), 4);
+    QCOMPARE(m_outputDevice->pixelSize(), QSize(1280, 1024));
+}
+
+QTEST_GUILESS_MAIN(TestWaylandOutputDeviceV2)
+#include "test_wayland_outputdevice_v2.moc"
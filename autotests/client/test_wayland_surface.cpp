@@ -9,6 +9,7 @@
 #include <QtTest>
 // KWin
 #include "../../src/server/clientbuffer.h"
+#include "../../src/server/clientconnection.h"
 #include "../../src/server/compositor_interface.h"
 #include "../../src/server/display.h"
 #include "../../src/server/idleinhibit_v1_interface.h"
@@ -39,6 +40,9 @@ private Q_SLOTS:
 
     void testStaticAccessor();
     void testDamage();
+    void testBatchedDamage();
+    void testBatchedDamageBenchmark_data();
+    void testBatchedDamageBenchmark();
     void testFrameCallback();
     void testAttachBuffer();
     void testMultipleSurfaces();
@@ -50,6 +54,7 @@ private Q_SLOTS:
     void testDestroyAttachedBuffer();
     void testDestroyWithPendingCallback();
     void testOutput();
+    void testMoveAcrossOutputs();
     void testDisconnect();
     void testInhibit();
 
@@ -333,6 +338,122 @@ void TestWaylandSurface::testDamage()
     QVERIFY(serverSurface->isMapped());
 }
 
+void TestWaylandSurface::testBatchedDamage()
+{
+    // this test verifies that batched damage is sent with the commit and merged into the allowed number of rects
+    QSignalSpy serverSurfaceCreated(m_compositorInterface, &KWaylandServer::CompositorInterface::surfaceCreated);
+    QVERIFY(serverSurfaceCreated.isValid());
+    QScopedPointer<KWayland::Client::Surface> s(m_compositor->createSurface());
+    QVERIFY(serverSurfaceCreated.wait());
+    KWaylandServer::SurfaceInterface *serverSurface = serverSurfaceCreated.first().first().value<KWaylandServer::SurfaceInterface *>();
+    QVERIFY(serverSurface);
+    QSignalSpy damageSpy(serverSurface, &KWaylandServer::SurfaceInterface::damaged);
+    QVERIFY(damageSpy.isValid());
+
+    QImage img(QSize(100, 100), QImage::Format_ARGB32_Premultiplied);
+    img.fill(Qt::black);
+    auto b = m_shm->createBuffer(img);
+    s->setMaximumDamageRects(2);
+    QCOMPARE(s->maximumDamageRects(), 2);
+    KWaylandServer::ClientConnection *client = serverSurface->client();
+    QVERIFY(client);
+    quint64 requests = client->requestCount();
+    s->attachBuffer(b);
+    s->damage(QRect(0, 0, 10, 10));
+    s->damage(QRect(20, 0, 10, 10));
+    s->damage(QRect(80, 0, 10, 10));
+    s->damageBuffer(QRect(80, 80, 10, 10));
+    s->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(damageSpy.wait());
+    // the two close rects are merged, the far one and the buffer damage are sent on their own
+    QCOMPARE(serverSurface->damage(), QRegion(0, 0, 30, 10).united(QRect(80, 0, 10, 10)).united(QRect(80, 80, 10, 10)));
+    // attach, two damage, one damage_buffer and commit
+    QCOMPARE(client->requestCount() - requests, quint64(5));
+
+    // without batching the damage is sent as is
+    s->setMaximumDamageRects(0);
+    img = QImage(QSize(100, 100), QImage::Format_ARGB32_Premultiplied);
+    img.fill(Qt::black);
+    b = m_shm->createBuffer(img);
+    requests = client->requestCount();
+    s->attachBuffer(b);
+    s->damage(QRegion(0, 0, 10, 10).united(QRect(20, 0, 10, 10)).united(QRect(80, 0, 10, 10)));
+    damageSpy.clear();
+    s->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(damageSpy.wait());
+    QCOMPARE(serverSurface->damage(), QRegion(0, 0, 10, 10).united(QRect(20, 0, 10, 10)).united(QRect(80, 0, 10, 10)));
+    // attach, three damage and commit
+    QCOMPARE(client->requestCount() - requests, quint64(5));
+}
+
+void TestWaylandSurface::testBatchedDamageBenchmark_data()
+{
+    QTest::addColumn<QRegion>("damage");
+    QTest::addColumn<int>("maximumRects");
+
+    // a text view repainting its glyphs
+    QRegion text;
+    for (int line = 0; line < 20; ++line) {
+        for (int glyph = 0; glyph < 30; ++glyph) {
+            text += QRect(10 + glyph * 9, 10 + line * 18, 8, 14);
+        }
+    }
+    // a grid of icons, e.g. a tray or a launcher
+    QRegion icons;
+    for (int row = 0; row < 8; ++row) {
+        for (int column = 0; column < 12; ++column) {
+            icons += QRect(column * 40 + 4, row * 40 + 4, 32, 32);
+        }
+    }
+    // a single button
+    const QRegion button(200, 200, 80, 24);
+
+    QTest::newRow("text") << text << 0;
+    QTest::newRow("text/batched") << text << 16;
+    QTest::newRow("icons") << icons << 0;
+    QTest::newRow("icons/batched") << icons << 16;
+    QTest::newRow("button") << button << 0;
+    QTest::newRow("button/batched") << button << 16;
+}
+
+void TestWaylandSurface::testBatchedDamageBenchmark()
+{
+    // this test measures sending typical widget damage and applying it in the server
+    QFETCH(QRegion, damage);
+    QFETCH(int, maximumRects);
+    QSignalSpy serverSurfaceCreated(m_compositorInterface, &KWaylandServer::CompositorInterface::surfaceCreated);
+    QVERIFY(serverSurfaceCreated.isValid());
+    QScopedPointer<KWayland::Client::Surface> s(m_compositor->createSurface());
+    QVERIFY(serverSurfaceCreated.wait());
+    KWaylandServer::SurfaceInterface *serverSurface = serverSurfaceCreated.first().first().value<KWaylandServer::SurfaceInterface *>();
+    QVERIFY(serverSurface);
+    QSignalSpy committedSpy(serverSurface, &KWaylandServer::SurfaceInterface::committed);
+    QVERIFY(committedSpy.isValid());
+
+    QImage img(QSize(512, 512), QImage::Format_ARGB32_Premultiplied);
+    img.fill(Qt::black);
+    auto b = m_shm->createBuffer(img);
+    s->setMaximumDamageRects(maximumRects);
+    KWaylandServer::ClientConnection *client = serverSurface->client();
+    QVERIFY(client);
+    const quint64 requests = client->requestCount();
+    quint64 commits = 0;
+
+    QBENCHMARK {
+        s->attachBuffer(b);
+        s->damage(damage);
+        s->commit(KWayland::Client::Surface::CommitFlag::None);
+        QVERIFY(committedSpy.wait());
+        ++commits;
+    }
+
+    // the damage may only grow
+    QCOMPARE(serverSurface->damage().intersected(damage), damage);
+    // besides attach and commit each frame sends one damage request per rect
+    const int sentRects = maximumRects > 0 ? qMin(maximumRects, damage.rectCount()) : damage.rectCount();
+    QCOMPARE(client->requestCount() - requests, commits * (sentRects + 2));
+}
+
 void TestWaylandSurface::testFrameCallback()
 {
     QSignalSpy serverSurfaceCreated(m_compositorInterface, &KWaylandServer::CompositorInterface::surfaceCreated);
@@ -1061,6 +1182,63 @@ void TestWaylandSurface::testOutput()
     QCOMPARE(serverSurface->outputs(), QVector<OutputInterface *>());
 }
 
+void TestWaylandSurface::testMoveAcrossOutputs()
+{
+    // this benchmark drags a window across a wall of 3x2 outputs, updating the outputs it is on
+    using namespace KWayland::Client;
+    using namespace KWaylandServer;
+    QScopedPointer<Surface> s(m_compositor->createSurface());
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto serverSurface = surfaceCreatedSpy.first().first().value<SurfaceInterface *>();
+    QVERIFY(serverSurface);
+
+    Registry registry;
+    registry.setEventQueue(m_queue);
+    QSignalSpy allAnnounced(&registry, &Registry::interfacesAnnounced);
+    QVERIFY(allAnnounced.isValid());
+    registry.create(m_connection);
+    registry.setup();
+    QVERIFY(allAnnounced.wait());
+    QSignalSpy outputAnnouncedSpy(&registry, &Registry::outputAnnounced);
+    QVERIFY(outputAnnouncedSpy.isValid());
+
+    const QSize outputSize(1920, 1080);
+    QVector<OutputInterface *> serverOutputs;
+    for (int row = 0; row < 2; ++row) {
+        for (int column = 0; column < 3; ++column) {
+            auto output = new OutputInterface(m_display, m_display);
+            output->setMode(outputSize);
+            output->setGlobalPosition(QPoint(column * outputSize.width(), row * outputSize.height()));
+            serverOutputs << output;
+        }
+    }
+    QTRY_COMPARE(outputAnnouncedSpy.count(), serverOutputs.count());
+    QVector<Output *> clientOutputs;
+    for (const auto &announced : qAsConst(outputAnnouncedSpy)) {
+        clientOutputs << registry.createOutput(announced.first().value<quint32>(), announced.last().value<quint32>(), this);
+    }
+    m_connection->flush();
+    m_display->dispatchEvents();
+
+    QVector<OutputInterface *> outputs;
+    QBENCHMARK {
+        for (int x = -400; x < outputSize.width() * 3; x += 8) {
+            m_display->outputsIntersecting(QRect(x, 780, 800, 600), &outputs);
+            serverSurface->setOutputs(outputs);
+        }
+    }
+
+    // the window ends up on the right column
+    const QVector<OutputInterface *> expected{serverOutputs[2], serverOutputs[5]};
+    QCOMPARE(serverSurface->outputs(), expected);
+    QTRY_COMPARE(s->outputs().count(), 2);
+
+    qDeleteAll(clientOutputs);
+    qDeleteAll(serverOutputs);
+}
+
 void TestWaylandSurface::testInhibit()
 {
     using namespace KWayland::Client;
@@ -0,0 +1,212 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+// Qt
+#include <QtTest>
+// WaylandServer
+#include "../../src/server/datatransfersource.h"
+#include "../../src/server/display.h"
+// system
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace KWaylandServer;
+
+class TestDataTransferSource : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void testTransfer_data();
+    void testTransfer();
+    void testCancel();
+    void testReceiverGone();
+    void testThroughput();
+
+private:
+    QByteArray receive(const QString &mimeType);
+
+    Display *m_display = nullptr;
+    DataTransferSource *m_source = nullptr;
+};
+
+void TestDataTransferSource::init()
+{
+    m_display = new Display(this);
+    m_display->addSocketName(QStringLiteral("kwayland-test-datatransfersource-0"));
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+    m_source = new DataTransferSource(m_display);
+}
+
+void TestDataTransferSource::cleanup()
+{
+    delete m_source;
+    m_source = nullptr;
+    delete m_display;
+    m_display = nullptr;
+}
+
+QByteArray TestDataTransferSource::receive(const QString &mimeType)
+{
+    int pipeFds[2] = {0, 0};
+    if (pipe2(pipeFds, O_CLOEXEC | O_NONBLOCK) != 0) {
+        return QByteArray();
+    }
+    m_source->requestData(mimeType, pipeFds[1]);
+
+    // the source writes from the Display's event loop, which runs in this thread
+    QByteArray content;
+    QByteArray buffer(1024 * 1024, Qt::Uninitialized);
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < 10000) {
+        const ssize_t count = read(pipeFds[0], buffer.data(), buffer.size());
+        if (count == 0) {
+            break;
+        }
+        if (count > 0) {
+            content.append(buffer.constData(), count);
+        } else {
+            QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents, 10);
+        }
+    }
+    close(pipeFds[0]);
+    return content;
+}
+
+void TestDataTransferSource::testTransfer_data()
+{
+    QTest::addColumn<int>("kind");
+    QTest::addColumn<int>("size");
+
+    QTest::newRow("data/empty") << 0 << 0;
+    QTest::newRow("data") << 0 << 3 * 1024 * 1024;
+    QTest::newRow("file") << 1 << 3 * 1024 * 1024;
+    QTest::newRow("producer") << 2 << 3 * 1024 * 1024;
+}
+
+void TestDataTransferSource::testTransfer()
+{
+    QFETCH(int, kind);
+    QFETCH(int, size);
+    QByteArray content(size, Qt::Uninitialized);
+    for (int i = 0; i < size; ++i) {
+        content[i] = char(i % 251);
+    }
+    const QString mimeType = QStringLiteral("application/octet-stream");
+
+    QSignalSpy mimeTypeOfferedSpy(m_source, &AbstractDataSource::mimeTypeOffered);
+    QVERIFY(mimeTypeOfferedSpy.isValid());
+    int producerCalls = 0;
+    switch (kind) {
+    case 0:
+        m_source->setData(mimeType, content);
+        break;
+    case 1: {
+        const int memfd = memfd_create("test", MFD_CLOEXEC);
+        QVERIFY(memfd != -1);
+        QCOMPARE(write(memfd, content.constData(), content.size()), ssize_t(content.size()));
+        m_source->setFileData(mimeType, memfd);
+        close(memfd);
+        break;
+    }
+    case 2:
+        m_source->setProducer(mimeType, [content, &producerCalls](const QString &) {
+            producerCalls++;
+            return content;
+        });
+        break;
+    }
+    QCOMPARE(mimeTypeOfferedSpy.count(), 1);
+    QCOMPARE(m_source->mimeTypes(), QStringList{mimeType});
+
+    QSignalSpy transferStartedSpy(m_source, &DataTransferSource::transferStarted);
+    QVERIFY(transferStartedSpy.isValid());
+    QCOMPARE(receive(mimeType), content);
+    QCOMPARE(receive(mimeType), content);
+    QCOMPARE(transferStartedSpy.count(), 2);
+    QVERIFY(m_source->transfers().isEmpty());
+    QCOMPARE(producerCalls, kind == 2 ? 1 : 0);
+
+    // unknown mime types are not transferred
+    QCOMPARE(receive(QStringLiteral("text/plain")), QByteArray());
+    QCOMPARE(transferStartedSpy.count(), 2);
+}
+
+void TestDataTransferSource::testCancel()
+{
+    const QString mimeType = QStringLiteral("text/plain");
+    m_source->setData(mimeType, QByteArray(4 * 1024 * 1024, 'a'));
+
+    QSignalSpy transferStartedSpy(m_source, &DataTransferSource::transferStarted);
+    QVERIFY(transferStartedSpy.isValid());
+    int pipeFds[2] = {0, 0};
+    QCOMPARE(pipe2(pipeFds, O_CLOEXEC | O_NONBLOCK), 0);
+    m_source->requestData(mimeType, pipeFds[1]);
+    QCOMPARE(transferStartedSpy.count(), 1);
+
+    // nobody reads, so the transfer can't complete
+    DataTransfer *transfer = transferStartedSpy.first().first().value<DataTransfer *>();
+    QCOMPARE(transfer->state(), DataTransfer::State::Running);
+    QCOMPARE(transfer->size(), qint64(4 * 1024 * 1024));
+    QVERIFY(transfer->bytesWritten() < transfer->size());
+    QCOMPARE(m_source->transfers(), QList<DataTransfer *>{transfer});
+
+    QSignalSpy finishedSpy(transfer, &DataTransfer::finished);
+    QVERIFY(finishedSpy.isValid());
+    QSignalSpy destroyedSpy(transfer, &QObject::destroyed);
+    QVERIFY(destroyedSpy.isValid());
+    m_source->cancelTransfers();
+    QCOMPARE(finishedSpy.count(), 1);
+    QCOMPARE(transfer->state(), DataTransfer::State::Cancelled);
+    QVERIFY(m_source->transfers().isEmpty());
+    QVERIFY(destroyedSpy.wait());
+
+    // the receiver sees the end of the content
+    QByteArray buffer(4 * 1024 * 1024, Qt::Uninitialized);
+    while (read(pipeFds[0], buffer.data(), buffer.size()) > 0) { }
+    QCOMPARE(read(pipeFds[0], buffer.data(), buffer.size()), ssize_t(0));
+    close(pipeFds[0]);
+}
+
+void TestDataTransferSource::testReceiverGone()
+{
+    const QString mimeType = QStringLiteral("text/plain");
+    m_source->setData(mimeType, QByteArray(4 * 1024 * 1024, 'a'));
+
+    QSignalSpy transferStartedSpy(m_source, &DataTransferSource::transferStarted);
+    QVERIFY(transferStartedSpy.isValid());
+    int pipeFds[2] = {0, 0};
+    QCOMPARE(pipe2(pipeFds, O_CLOEXEC | O_NONBLOCK), 0);
+    m_source->requestData(mimeType, pipeFds[1]);
+    DataTransfer *transfer = transferStartedSpy.first().first().value<DataTransfer *>();
+    QSignalSpy finishedSpy(transfer, &DataTransfer::finished);
+    QVERIFY(finishedSpy.isValid());
+
+    // neither SIGPIPE nor the failed write must hurt
+    close(pipeFds[0]);
+    QVERIFY(finishedSpy.wait());
+    QCOMPARE(transfer->state(), DataTransfer::State::Failed);
+}
+
+void TestDataTransferSource::testThroughput()
+{
+    const QString mimeType = QStringLiteral("application/octet-stream");
+    const QByteArray content(100 * 1024 * 1024, 'k');
+    m_source->setData(mimeType, content);
+
+    QSignalSpy transferStartedSpy(m_source, &DataTransferSource::transferStarted);
+    QVERIFY(transferStartedSpy.isValid());
+    QBENCHMARK {
+        QCOMPARE(receive(mimeType).size(), content.size());
+    }
+    QVERIFY(!transferStartedSpy.isEmpty());
+}
+
+QTEST_GUILESS_MAIN(TestDataTransferSource)
+#include "test_datatransfersource.moc"
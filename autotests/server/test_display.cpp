@@ -11,6 +11,7 @@
 #include "../../src/server/output_interface.h"
 #include "../../src/server/outputmanagement_v2_interface.h"
 // Wayland
+#include <wayland-client.h>
 #include <wayland-server.h>
 // system
 #include <sys/socket.h>
@@ -30,6 +31,8 @@ private Q_SLOTS:
     void testConnectNoSocket();
     void testOutputManagement();
     void testAutoSocketName();
+    void testStartThreaded();
+    void testClientDispatchBudget();
 };
 
 void TestWaylandServerDisplay::testSocketName()
@@ -209,5 +212,65 @@ void TestWaylandServerDisplay::testAutoSocketName()
     QCOMPARE(socketNameChangedSpy1.count(), 1);
 }
 
+void TestWaylandServerDisplay::testStartThreaded()
+{
+    // a display with a parent can't be moved to another thread
+    QObject parent;
+    Display *childDisplay = new Display(&parent);
+    QVERIFY(!childDisplay->startThreaded());
+    QVERIFY(!childDisplay->isRunning());
+    QVERIFY(!childDisplay->isThreaded());
+    QCOMPARE(childDisplay->thread(), QThread::currentThread());
+
+    QScopedPointer<Display> display(new Display);
+    QVERIFY(display->addSocketName(QStringLiteral("kwin-wayland-server-display-test-threaded")));
+    QVERIFY(display->startThreaded());
+    QVERIFY(display->isRunning());
+    QVERIFY(display->isThreaded());
+    QVERIFY(display->thread() != QThread::currentThread());
+
+    // the main thread is blocked in the roundtrip, so the event loop thread has to answer it
+    wl_display *client = wl_display_connect("kwin-wayland-server-display-test-threaded");
+    QVERIFY(client);
+    QVERIFY(wl_display_roundtrip(client) >= 0);
+    wl_display_disconnect(client);
+
+    display.reset();
+}
+
+void TestWaylandServerDisplay::testClientDispatchBudget()
+{
+    Display display;
+    QCOMPARE(display.clientRequestBudget(), 0u);
+    QCOMPARE(display.clientTimeBudget(), 0);
+    QVERIFY(!display.deferOverBudgetClients());
+    display.setClientDispatchBudget(5, 0);
+    display.setDeferOverBudgetClients(true);
+    QCOMPARE(display.clientRequestBudget(), 5u);
+    QVERIFY(display.deferOverBudgetClients());
+
+    QVERIFY(display.addSocketName(QStringLiteral("kwin-wayland-server-display-test-budget")));
+    display.start();
+    QVERIFY(display.isRunning());
+    QSignalSpy overBudgetSpy(&display, &Display::clientOverBudget);
+    QVERIFY(overBudgetSpy.isValid());
+
+    wl_display *client = wl_display_connect("kwin-wayland-server-display-test-budget");
+    QVERIFY(client);
+    for (int i = 0; i < 10; ++i) {
+        wl_callback_destroy(wl_display_sync(client));
+    }
+    QVERIFY(wl_display_flush(client) > 0);
+
+    QTRY_COMPARE(overBudgetSpy.count(), 1);
+    ClientConnection *connection = overBudgetSpy.first().at(0).value<ClientConnection *>();
+    QVERIFY(connection);
+    QCOMPARE(overBudgetSpy.first().at(1).value<quint32>(), 10u);
+    QCOMPARE(connection->requestCount(), 10u);
+    QVERIFY(connection->dispatchTime() >= overBudgetSpy.first().at(2).value<qint64>());
+
+    wl_display_disconnect(client);
+}
+
 QTEST_GUILESS_MAIN(TestWaylandServerDisplay)
 #include "test_display.moc"
@@ -0,0 +1,333 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include <QThread>
+#include <QtTest>
+
+#include "../../src/server/display.h"
+#include "../../src/server/drm_fourcc.h"
+#include "../../src/server/linuxdmabufv1clientbuffer.h"
+
+#include "../../src/client/connection_thread.h"
+#include "../../src/client/event_queue.h"
+#include "../../src/client/registry.h"
+
+#include "qwayland-linux-dmabuf-unstable-v1.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace KWaylandServer;
+
+class LinuxDmaBuf : public QtWayland::zwp_linux_dmabuf_v1
+{
+};
+
+class BufferParams : public QtWayland::zwp_linux_buffer_params_v1
+{
+public:
+    BufferParams(::zwp_linux_buffer_params_v1 *params)
+        : QtWayland::zwp_linux_buffer_params_v1(params)
+    {
+    }
+
+    ~BufferParams() override
+    {
+        destroy();
+    }
+
+    ::wl_buffer *created = nullptr;
+    bool failed = false;
+
+protected:
+    void zwp_linux_buffer_params_v1_created(struct ::wl_buffer *buffer) override
+    {
+        created = buffer;
+    }
+
+    void zwp_linux_buffer_params_v1_failed() override
+    {
+        failed = true;
+    }
+};
+
+class MockRenderer : public LinuxDmaBufV1ClientBufferIntegration::RendererInterface
+{
+public:
+    LinuxDmaBufV1ClientBuffer *importBuffer(const QVector<LinuxDmaBufV1Plane> &planes, quint32 format, const QSize &size, quint32 flags) override
+    {
+        ++imports;
+        return new LinuxDmaBufV1ClientBuffer(size, format, flags, planes);
+    }
+
+    LinuxDmaBufV1ClientBuffer *
+    reuseImport(LinuxDmaBufV1ClientBuffer *imported, const QVector<LinuxDmaBufV1Plane> &planes, quint32 format, const QSize &size, quint32 flags) override
+    {
+        ++reuses;
+        lastReused = imported;
+        return new LinuxDmaBufV1ClientBuffer(size, format, flags, planes);
+    }
+
+    QFuture<LinuxDmaBufV1ClientBuffer *> importBufferAsync(const QVector<LinuxDmaBufV1Plane> &planes, quint32 format, const QSize &size, quint32 flags) override
+    {
+        if (!async) {
+            return RendererInterface::importBufferAsync(planes, format, size, flags);
+        }
+        PendingImport import{planes, format, size, flags, {}};
+        import.result.reportStarted();
+        pendingImports << import;
+        return import.result.future();
+    }
+
+    /**
+     * Finishes the oldest asynchronous import, the buffer is returned if it succeeded.
+     */
+    LinuxDmaBufV1ClientBuffer *finishImport(bool success)
+    {
+        PendingImport import = pendingImports.takeFirst();
+        LinuxDmaBufV1ClientBuffer *buffer = nullptr;
+        if (success) {
+            ++imports;
+            buffer = new LinuxDmaBufV1ClientBuffer(import.size, import.format, import.flags, import.planes);
+            import.result.reportResult(buffer);
+        }
+        import.result.reportFinished();
+        return buffer;
+    }
+
+    struct PendingImport {
+        QVector<LinuxDmaBufV1Plane> planes;
+        quint32 format;
+        QSize size;
+        quint32 flags;
+        QFutureInterface<LinuxDmaBufV1ClientBuffer *> result;
+    };
+
+    int imports = 0;
+    int reuses = 0;
+    LinuxDmaBufV1ClientBuffer *lastReused = nullptr;
+    bool async = false;
+    QVector<PendingImport> pendingImports;
+};
+
+class TestLinuxDmaBufInterface : public QObject
+{
+    Q_OBJECT
+
+public:
+    ~TestLinuxDmaBufInterface() override;
+
+private Q_SLOTS:
+    void initTestCase();
+    void testImportCache();
+    void testAsyncImport();
+
+private:
+    ::wl_buffer *createBuffer(int fd);
+
+    KWayland::Client::ConnectionThread *m_connection;
+    KWayland::Client::EventQueue *m_queue;
+
+    QThread *m_thread;
+    Display m_display;
+    LinuxDmaBufV1ClientBufferIntegration *m_integration;
+    MockRenderer m_renderer;
+    LinuxDmaBuf *m_dmabuf = nullptr;
+};
+
+static const QString s_socketName = QStringLiteral("kwin-wayland-server-linuxdmabuf-test-0");
+static const QSize s_bufferSize(64, 64);
+static const quint32 s_stride = 64 * 4;
+
+void TestLinuxDmaBufInterface::initTestCase()
+{
+    m_display.addSocketName(s_socketName);
+    m_display.start();
+    QVERIFY(m_display.isRunning());
+
+    m_integration = new LinuxDmaBufV1ClientBufferIntegration(&m_display);
+    m_integration->setRendererInterface(&m_renderer);
+
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &KWayland::Client::ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new KWayland::Client::EventQueue(this);
+    m_queue->setup(m_connection);
+    QVERIFY(m_queue->isValid());
+
+    auto registry = new KWayland::Client::Registry(this);
+    connect(registry, &KWayland::Client::Registry::interfaceAnnounced, this, [this, registry](const QByteArray &interface, quint32 id, quint32 version) {
+        if (interface == QByteArrayLiteral("zwp_linux_dmabuf_v1")) {
+            m_dmabuf = new LinuxDmaBuf();
+            // the feedback of version 4 is not needed here
+            m_dmabuf->init(*registry, id, qMin(version, 3u));
+        }
+    });
+    QSignalSpy allAnnouncedSpy(registry, &KWayland::Client::Registry::interfacesAnnounced);
+    registry->setEventQueue(m_queue);
+    registry->create(m_connection->display());
+    QVERIFY(registry->isValid());
+    registry->setup();
+    QVERIFY(allAnnouncedSpy.wait());
+    QVERIFY(m_dmabuf);
+}
+
+TestLinuxDmaBufInterface::~TestLinuxDmaBufInterface()
+{
+    if (m_dmabuf) {
+        delete m_dmabuf;
+        m_dmabuf = nullptr;
+    }
+    if (m_queue) {
+        delete m_queue;
+        m_queue = nullptr;
+    }
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    m_connection->deleteLater();
+    m_connection = nullptr;
+}
+
+::wl_buffer *TestLinuxDmaBufInterface::createBuffer(int fd)
+{
+    BufferParams params(m_dmabuf->create_params());
+    params.add(fd, 0, 0, s_stride, DRM_FORMAT_MOD_LINEAR >> 32, DRM_FORMAT_MOD_LINEAR & 0xffffffff);
+    ::wl_buffer *buffer = params.create_immed(s_bufferSize.width(), s_bufferSize.height(), DRM_FORMAT_ARGB8888, 0);
+    m_connection->flush();
+    return buffer;
+}
+
+/**
+ * Creates a memfd standing in for a dmabuf of s_bufferSize.
+ */
+static int createPlane()
+{
+    const int fd = memfd_create("test-dmabuf", MFD_CLOEXEC);
+    if (fd != -1 && ftruncate(fd, s_stride * s_bufferSize.height()) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void TestLinuxDmaBufInterface::testImportCache()
+{
+    // this test verifies that buffers for the same dmabufs reuse the import of the first one
+    m_integration->setImportCacheEnabled(true);
+    const int firstPlane = createPlane();
+    QVERIFY(firstPlane != -1);
+    const int secondPlane = createPlane();
+    QVERIFY(secondPlane != -1);
+
+    ::wl_buffer *first = createBuffer(firstPlane);
+    QTRY_COMPARE(m_renderer.imports, 1);
+    QCOMPARE(m_integration->importCacheMisses(), quint64(1));
+    QCOMPARE(m_integration->importCacheHits(), quint64(0));
+
+    // the same dmabuf wrapped in another wl_buffer
+    ::wl_buffer *second = createBuffer(firstPlane);
+    QTRY_COMPARE(m_renderer.reuses, 1);
+    QVERIFY(m_renderer.lastReused);
+    QCOMPARE(m_integration->importCacheHits(), quint64(1));
+    QCOMPARE(m_renderer.imports, 1);
+
+    // another dmabuf is imported
+    ::wl_buffer *third = createBuffer(secondPlane);
+    QTRY_COMPARE(m_renderer.imports, 2);
+    QCOMPARE(m_integration->importCacheMisses(), quint64(2));
+
+    // the entry is dropped with the last buffer referencing it
+    wl_buffer_destroy(first);
+    QSignalSpy destroyedSpy(m_renderer.lastReused, &QObject::destroyed);
+    QVERIFY(destroyedSpy.isValid());
+    wl_buffer_destroy(second);
+    m_connection->flush();
+    QVERIFY(destroyedSpy.wait());
+    ::wl_buffer *fourth = createBuffer(firstPlane);
+    QTRY_COMPARE(m_renderer.imports, 3);
+    QCOMPARE(m_renderer.reuses, 1);
+    QCOMPARE(m_integration->importCacheMisses(), quint64(3));
+
+    // without the cache every buffer is imported
+    m_integration->setImportCacheEnabled(false);
+    ::wl_buffer *fifth = createBuffer(firstPlane);
+    QTRY_COMPARE(m_renderer.imports, 4);
+    QCOMPARE(m_renderer.reuses, 1);
+    QCOMPARE(m_integration->importCacheMisses(), quint64(3));
+
+    wl_buffer_destroy(third);
+    wl_buffer_destroy(fourth);
+    wl_buffer_destroy(fifth);
+    m_connection->flush();
+    close(firstPlane);
+    close(secondPlane);
+}
+
+void TestLinuxDmaBufInterface::testAsyncImport()
+{
+    // this test verifies that buffers created with the create request are announced once imported
+    m_integration->setImportCacheEnabled(false);
+    m_renderer.async = true;
+    const int imports = m_renderer.imports;
+    const int plane = createPlane();
+    QVERIFY(plane != -1);
+
+    QScopedPointer<BufferParams> params(new BufferParams(m_dmabuf->create_params()));
+    params->add(plane, 0, 0, s_stride, DRM_FORMAT_MOD_LINEAR >> 32, DRM_FORMAT_MOD_LINEAR & 0xffffffff);
+    params->create(s_bufferSize.width(), s_bufferSize.height(), DRM_FORMAT_ARGB8888, 0);
+    m_connection->flush();
+    QTRY_COMPARE(m_renderer.pendingImports.count(), 1);
+    QVERIFY(!params->created);
+
+    QVERIFY(m_renderer.finishImport(true));
+    QTRY_VERIFY(params->created);
+    QVERIFY(!params->failed);
+    QCOMPARE(m_renderer.imports, imports + 1);
+    wl_buffer_destroy(params->created);
+
+    // a failed import is reported to the client
+    params.reset(new BufferParams(m_dmabuf->create_params()));
+    params->add(plane, 0, 0, s_stride, DRM_FORMAT_MOD_LINEAR >> 32, DRM_FORMAT_MOD_LINEAR & 0xffffffff);
+    params->create(s_bufferSize.width(), s_bufferSize.height(), DRM_FORMAT_ARGB8888, 0);
+    m_connection->flush();
+    QTRY_COMPARE(m_renderer.pendingImports.count(), 1);
+    QVERIFY(!m_renderer.finishImport(false));
+    QTRY_VERIFY(params->failed);
+    QVERIFY(!params->created);
+
+    // the buffer is dropped if the params are destroyed while importing
+    params.reset(new BufferParams(m_dmabuf->create_params()));
+    params->add(plane, 0, 0, s_stride, DRM_FORMAT_MOD_LINEAR >> 32, DRM_FORMAT_MOD_LINEAR & 0xffffffff);
+    params->create(s_bufferSize.width(), s_bufferSize.height(), DRM_FORMAT_ARGB8888, 0);
+    m_connection->flush();
+    QTRY_COMPARE(m_renderer.pendingImports.count(), 1);
+    params.reset();
+    m_connection->flush();
+    QTest::qWait(100);
+    LinuxDmaBufV1ClientBuffer *buffer = m_renderer.finishImport(true);
+    QVERIFY(buffer);
+    QSignalSpy destroyedSpy(buffer, &QObject::destroyed);
+    QVERIFY(destroyedSpy.isValid());
+    QVERIFY(destroyedSpy.wait());
+
+    m_renderer.async = false;
+    m_connection->flush();
+    close(plane);
+}
+
+QTEST_GUILESS_MAIN(TestLinuxDmaBufInterface)
+
+#include "test_linuxdmabuf_interface.moc"
@@ -41,8 +41,14 @@ public:
         Q_EMIT created(node);
     }
 
+    void zkde_screencast_stream_unstable_v1_closed() override
+    {
+        Q_EMIT closed();
+    }
+
 Q_SIGNALS:
     void created(quint32 node);
+    void closed();
 };
 
 class ScreencastV1 : public QObject, public QtWayland::zkde_screencast_unstable_v1
@@ -55,9 +61,9 @@ public:
     {
     }
 
-    ScreencastStreamV1 *createWindowStream(const QString &uuid)
+    ScreencastStreamV1 *createWindowStream(const QString &uuid, uint32_t pointer = 2)
     {
-        return new ScreencastStreamV1(stream_window(uuid, 2), this);
+        return new ScreencastStreamV1(stream_window(uuid, pointer), this);
     }
 };
 
@@ -75,8 +81,14 @@ public:
 private Q_SLOTS:
     void initTestCase();
     void testCreate();
+    void testFramePacing();
+    void testClosedStream();
+    void testCursorMetadata();
+    void testCursorHidden();
 
 private:
+    ScreencastStreamV1 *createStream(uint32_t pointer);
+
     KWayland::Client::ConnectionThread *m_connection;
     KWayland::Client::EventQueue *m_queue = nullptr;
     ScreencastV1 *m_screencast = nullptr;
@@ -92,6 +104,8 @@ static const QString s_socketName = QStringLiteral("kwin-wayland-server-screenca
 
 void TestScreencastV1Interface::initTestCase()
 {
+    qRegisterMetaType<KWaylandServer::ScreencastStreamV1Interface::CursorChanges>();
+
     delete m_display;
     m_display = new KWaylandServer::Display(this);
     m_display->addSocketName(s_socketName);
@@ -181,6 +195,179 @@ void TestScreencastV1Interface::testCreate()
     QVERIFY(spyStop.count() || spyStop.wait());
 }
 
+ScreencastStreamV1 *TestScreencastV1Interface::createStream(uint32_t pointer)
+{
+    m_triggered = nullptr;
+    auto stream = m_screencast->createWindowStream("3", pointer);
+    QSignalSpy createdSpy(stream, &ScreencastStreamV1::created);
+    if (!createdSpy.wait()) {
+        return nullptr;
+    }
+    return stream;
+}
+
+void TestScreencastV1Interface::testFramePacing()
+{
+    // this test verifies that frames are only wanted when requested and at the target frame rate
+    auto stream = createStream(2);
+    QVERIFY(stream);
+    QVERIFY(m_triggered);
+    QSignalSpy frameWantedSpy(m_triggered, &KWaylandServer::ScreencastStreamV1Interface::frameWanted);
+    QVERIFY(frameWantedSpy.isValid());
+    QVERIFY(!m_triggered->isFrameWanted());
+
+    m_triggered->requestFrame();
+    QCOMPARE(frameWantedSpy.count(), 1);
+    QVERIFY(m_triggered->isFrameWanted());
+    // requesting again before the frame was sent changes nothing
+    m_triggered->requestFrame();
+    QCOMPARE(frameWantedSpy.count(), 1);
+    m_triggered->frameSent();
+    QVERIFY(!m_triggered->isFrameWanted());
+
+    // the next frame is delayed until the target frame rate allows it
+    m_triggered->setTargetFrameRate(10);
+    QCOMPARE(m_triggered->targetFrameRate(), 10.0);
+    m_triggered->requestFrame();
+    QCOMPARE(frameWantedSpy.count(), 1);
+    QVERIFY(!m_triggered->isFrameWanted());
+    QVERIFY(frameWantedSpy.wait());
+    QCOMPARE(frameWantedSpy.count(), 2);
+    QVERIFY(m_triggered->isFrameWanted());
+    m_triggered->frameSent();
+
+    // a frame sent in between stops the pending request
+    m_triggered->requestFrame();
+    m_triggered->frameSent();
+    QVERIFY(!frameWantedSpy.wait(200));
+    QCOMPARE(frameWantedSpy.count(), 2);
+
+    QSignalSpy finishedSpy(m_triggered, &KWaylandServer::ScreencastStreamV1Interface::finished);
+    stream->close();
+    QVERIFY(finishedSpy.wait());
+}
+
+void TestScreencastV1Interface::testClosedStream()
+{
+    // this test verifies that a stream closed by the compositor wants no more frames
+    auto stream = createStream(2);
+    QVERIFY(stream);
+    QVERIFY(m_triggered);
+    QSignalSpy frameWantedSpy(m_triggered, &KWaylandServer::ScreencastStreamV1Interface::frameWanted);
+    QVERIFY(frameWantedSpy.isValid());
+    QSignalSpy closedSpy(stream, &ScreencastStreamV1::closed);
+    QVERIFY(closedSpy.isValid());
+
+    m_triggered->setTargetFrameRate(5);
+    m_triggered->requestFrame();
+    QCOMPARE(frameWantedSpy.count(), 1);
+    m_triggered->frameSent();
+    // the request waits for the pace timer, closing has to stop it
+    m_triggered->requestFrame();
+    m_triggered->sendClosed();
+    QVERIFY(closedSpy.wait());
+    QVERIFY(!frameWantedSpy.wait(300));
+    QCOMPARE(frameWantedSpy.count(), 1);
+    QVERIFY(!m_triggered->isFrameWanted());
+
+    m_triggered->frameSent();
+    m_triggered->requestFrame();
+    QCOMPARE(frameWantedSpy.count(), 1);
+
+    QSignalSpy destroyedSpy(m_triggered, &QObject::destroyed);
+    stream->close();
+    QVERIFY(destroyedSpy.wait());
+}
+
+void TestScreencastV1Interface::testCursorMetadata()
+{
+    // this test verifies that the cursor is tracked relative to the region of the stream
+    auto stream = createStream(KWaylandServer::ScreencastV1Interface::Metadata);
+    QVERIFY(stream);
+    QVERIFY(m_triggered);
+    QCOMPARE(m_triggered->cursorMode(), KWaylandServer::ScreencastV1Interface::Metadata);
+    QCOMPARE(m_triggered->sourceType(), KWaylandServer::ScreencastStreamV1Interface::SourceType::Window);
+    QCOMPARE(m_triggered->windowUuid(), QStringLiteral("3"));
+    QVERIFY(!m_triggered->output());
+    using CursorChange = KWaylandServer::ScreencastStreamV1Interface::CursorChange;
+    using CursorChanges = KWaylandServer::ScreencastStreamV1Interface::CursorChanges;
+    QSignalSpy cursorChangedSpy(m_triggered, &KWaylandServer::ScreencastStreamV1Interface::cursorChanged);
+    QVERIFY(cursorChangedSpy.isValid());
+
+    m_triggered->setRegion(QRect(100, 100, 200, 100));
+    QCOMPARE(m_triggered->region(), QRect(100, 100, 200, 100));
+    QCOMPARE(cursorChangedSpy.count(), 1);
+    QCOMPARE(cursorChangedSpy.last().first().value<CursorChanges>(), CursorChanges(CursorChange::Position));
+    QVERIFY(!m_triggered->isCursorVisible());
+
+    // without an image the hotspot has to be inside of the region
+    m_triggered->setCursorPosition(QPointF(150, 120));
+    QCOMPARE(cursorChangedSpy.count(), 2);
+    QCOMPARE(cursorChangedSpy.last().first().value<CursorChanges>(), CursorChange::Position | CursorChange::Visibility);
+    QVERIFY(m_triggered->isCursorVisible());
+    QCOMPARE(m_triggered->cursorPosition(), QPointF(50, 20));
+
+    m_triggered->setCursorPosition(QPointF(150, 120));
+    QCOMPARE(cursorChangedSpy.count(), 2);
+
+    // leaving the region only changes the visibility, moving outside of it changes nothing
+    m_triggered->setCursorPosition(QPointF(500, 500));
+    QCOMPARE(cursorChangedSpy.count(), 3);
+    QCOMPARE(cursorChangedSpy.last().first().value<CursorChanges>(), CursorChanges(CursorChange::Visibility));
+    QVERIFY(!m_triggered->isCursorVisible());
+    m_triggered->setCursorPosition(QPointF(510, 500));
+    QCOMPARE(cursorChangedSpy.count(), 3);
+
+    // with an image the cursor is visible as soon as the image intersects the region
+    QImage image(32, 32, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::red);
+    m_triggered->setCursorImage(image, QPoint(16, 16));
+    QCOMPARE(cursorChangedSpy.count(), 4);
+    QCOMPARE(cursorChangedSpy.last().first().value<CursorChanges>(), CursorChanges(CursorChange::Shape));
+    QCOMPARE(m_triggered->cursorImage(), image);
+    QCOMPARE(m_triggered->cursorHotspot(), QPoint(16, 16));
+    m_triggered->setCursorImage(image, QPoint(16, 16));
+    QCOMPARE(cursorChangedSpy.count(), 4);
+
+    m_triggered->setCursorPosition(QPointF(310, 150));
+    QCOMPARE(cursorChangedSpy.count(), 5);
+    QCOMPARE(cursorChangedSpy.last().first().value<CursorChanges>(), CursorChange::Position | CursorChange::Visibility);
+    QVERIFY(m_triggered->isCursorVisible());
+    QCOMPARE(m_triggered->cursorPosition(), QPointF(210, 50));
+
+    // moving the region moves the cursor relative to it
+    m_triggered->setRegion(QRect(300, 100, 200, 100));
+    QCOMPARE(cursorChangedSpy.count(), 6);
+    QCOMPARE(cursorChangedSpy.last().first().value<CursorChanges>(), CursorChanges(CursorChange::Position));
+    QCOMPARE(m_triggered->cursorPosition(), QPointF(10, 50));
+    QVERIFY(m_triggered->isCursorVisible());
+
+    QSignalSpy finishedSpy(m_triggered, &KWaylandServer::ScreencastStreamV1Interface::finished);
+    stream->close();
+    QVERIFY(finishedSpy.wait());
+}
+
+void TestScreencastV1Interface::testCursorHidden()
+{
+    // this test verifies that the cursor is not tracked without metadata
+    auto stream = createStream(KWaylandServer::ScreencastV1Interface::Hidden);
+    QVERIFY(stream);
+    QVERIFY(m_triggered);
+    QSignalSpy cursorChangedSpy(m_triggered, &KWaylandServer::ScreencastStreamV1Interface::cursorChanged);
+    QVERIFY(cursorChangedSpy.isValid());
+
+    m_triggered->setRegion(QRect(0, 0, 100, 100));
+    m_triggered->setCursorPosition(QPointF(50, 50));
+    m_triggered->setCursorImage(QImage(16, 16, QImage::Format_ARGB32_Premultiplied), QPoint());
+    QVERIFY(cursorChangedSpy.isEmpty());
+    QVERIFY(!m_triggered->isCursorVisible());
+    QVERIFY(m_triggered->cursorImage().isNull());
+
+    QSignalSpy finishedSpy(m_triggered, &KWaylandServer::ScreencastStreamV1Interface::finished);
+    stream->close();
+    QVERIFY(finishedSpy.wait());
+}
+
 QTEST_GUILESS_MAIN(TestScreencastV1Interface)
 
 #include "test_screencast.moc"
@@ -0,0 +1,155 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+// Qt
+#include <QThread>
+#include <QtTest>
+// WaylandServer
+#include "../../src/server/utils/triplebuffer.h"
+// system
+#include <atomic>
+
+using namespace KWaylandServer;
+
+class TestTripleBuffer : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testNothingPublished();
+    void testPublishFetch();
+    void testFetchTwice();
+    void testSupersede();
+    void testProducerDoesNotTouchFront();
+    void testTwoThreads();
+};
+
+void TestTripleBuffer::testNothingPublished()
+{
+    // this test verifies that there is nothing to fetch before the first publish
+    TripleBuffer<int> buffer;
+    QVERIFY(!buffer.hasPending());
+    QVERIFY(!buffer.fetch());
+}
+
+void TestTripleBuffer::testPublishFetch()
+{
+    // this test verifies that a published value ends up in the front slot
+    TripleBuffer<int> buffer;
+    buffer.back() = 1;
+    QVERIFY(buffer.publish());
+    QVERIFY(buffer.hasPending());
+    QVERIFY(buffer.fetch());
+    QVERIFY(!buffer.hasPending());
+    QCOMPARE(buffer.front(), 1);
+
+    buffer.back() = 2;
+    QVERIFY(buffer.publish());
+    QVERIFY(buffer.fetch());
+    QCOMPARE(buffer.front(), 2);
+}
+
+void TestTripleBuffer::testFetchTwice()
+{
+    // this test verifies that fetching again without a new publish keeps the fetched value
+    TripleBuffer<int> buffer;
+    buffer.back() = 1;
+    QVERIFY(buffer.publish());
+    QVERIFY(buffer.fetch());
+    QVERIFY(!buffer.fetch());
+    QCOMPARE(buffer.front(), 1);
+    QVERIFY(!buffer.hasPending());
+}
+
+void TestTripleBuffer::testSupersede()
+{
+    // this test verifies that a value the consumer did not fetch is replaced by the next one
+    TripleBuffer<int> buffer;
+    buffer.back() = 1;
+    QVERIFY(buffer.publish());
+    buffer.back() = 2;
+    QVERIFY(!buffer.publish());
+    buffer.back() = 3;
+    QVERIFY(!buffer.publish());
+    QVERIFY(buffer.fetch());
+    QCOMPARE(buffer.front(), 3);
+    QVERIFY(!buffer.fetch());
+    QCOMPARE(buffer.front(), 3);
+
+    // once fetched, publishing reports no superseded value again
+    buffer.back() = 4;
+    QVERIFY(buffer.publish());
+}
+
+void TestTripleBuffer::testProducerDoesNotTouchFront()
+{
+    // this test verifies that the producer never writes to the slot the consumer reads
+    TripleBuffer<int> buffer;
+    buffer.back() = 1;
+    QVERIFY(buffer.publish());
+    QVERIFY(buffer.fetch());
+    for (int i = 2; i < 10; ++i) {
+        buffer.back() = i;
+        QCOMPARE(buffer.front(), 1);
+        buffer.publish();
+        QCOMPARE(buffer.front(), 1);
+    }
+    QVERIFY(buffer.fetch());
+    QCOMPARE(buffer.front(), 9);
+}
+
+void TestTripleBuffer::testTwoThreads()
+{
+    // this test verifies that with a producer and a consumer thread no frame is torn or goes backwards
+    struct Frame {
+        quint64 serial = 0;
+        quint64 values[32] = {};
+    };
+    TripleBuffer<Frame> buffer;
+    const quint64 frames = 200000;
+    std::atomic<bool> done{false};
+
+    QScopedPointer<QThread> producer(QThread::create([&buffer, &done, frames] {
+        for (quint64 serial = 1; serial <= frames; ++serial) {
+            Frame &frame = buffer.back();
+            frame.serial = serial;
+            for (quint64 &value : frame.values) {
+                value = serial;
+            }
+            buffer.publish();
+        }
+        done.store(true, std::memory_order_release);
+    }));
+    producer->start();
+
+    quint64 last = 0;
+    quint64 fetched = 0;
+    bool torn = false;
+    bool backwards = false;
+    auto consume = [&] {
+        if (!buffer.fetch()) {
+            return;
+        }
+        const Frame &frame = buffer.front();
+        for (quint64 value : frame.values) {
+            torn |= value != frame.serial;
+        }
+        backwards |= frame.serial <= last;
+        last = frame.serial;
+        ++fetched;
+    };
+    while (!done.load(std::memory_order_acquire)) {
+        consume();
+    }
+    consume();
+    QVERIFY(producer->wait());
+
+    QVERIFY(!torn);
+    QVERIFY(!backwards);
+    // the last frame is never lost
+    QCOMPARE(last, frames);
+    QVERIFY(fetched > 0);
+}
+
+QTEST_GUILESS_MAIN(TestTripleBuffer)
+#include "test_triplebuffer.moc"
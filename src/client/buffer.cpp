@@ -6,6 +6,9 @@
 #include "buffer.h"
 #include "buffer_p.h"
 #include "shm_pool.h"
+// Qt
+#include <QRegion>
+#include <QRgb>
 // system
 #include <string.h>
 // wayland
@@ -43,6 +46,44 @@ void Buffer::Private::destroy()
     nativeBuffer.destroy();
 }
 
+void Buffer::Private::copy(const void *src, const QRect &rect, bool premultiply)
+{
+    const QRect clipped = rect.intersected(QRect(QPoint(0, 0), size));
+    if (clipped.isEmpty()) {
+        return;
+    }
+    // both formats use four bytes per pixel
+    const size_t start = size_t(clipped.y()) * stride + size_t(clipped.x()) * 4;
+    const uchar *in = reinterpret_cast<const uchar *>(src) + start;
+    uchar *out = q->address() + start;
+    if (!premultiply) {
+        if (clipped.width() == size.width()) {
+            memcpy(out, in, size_t(clipped.height()) * stride);
+            return;
+        }
+        for (int y = 0; y < clipped.height(); ++y, in += stride, out += stride) {
+            memcpy(out, in, size_t(clipped.width()) * 4);
+        }
+        return;
+    }
+    for (int y = 0; y < clipped.height(); ++y, in += stride, out += stride) {
+        const QRgb *inPixels = reinterpret_cast<const QRgb *>(in);
+        QRgb *outPixels = reinterpret_cast<QRgb *>(out);
+        for (int x = 0; x < clipped.width(); ++x) {
+            // the common opaque and fully transparent pixels don't need the multiplications
+            const QRgb pixel = inPixels[x];
+            const uint alpha = qAlpha(pixel);
+            if (alpha == 255) {
+                outPixels[x] = pixel;
+            } else if (alpha == 0) {
+                outPixels[x] = 0;
+            } else {
+                outPixels[x] = qPremultiply(pixel);
+            }
+        }
+    }
+}
+
 void Buffer::Private::releasedCallback(void *data, wl_buffer *buffer)
 {
     auto b = reinterpret_cast<Buffer::Private *>(data);
@@ -62,6 +103,13 @@ void Buffer::copy(const void *src)
     memcpy(address(), src, d->size.height() * d->stride);
 }
 
+void Buffer::copy(const void *src, const QRegion &damage)
+{
+    for (const QRect &rect : damage) {
+        d->copy(src, rect);
+    }
+}
+
 uchar *Buffer::address()
 {
     return reinterpret_cast<uchar *>(d->shm->poolAddress()) + d->offset;
@@ -117,6 +165,11 @@ Buffer::Format Buffer::format() const
     return d->format;
 }
 
+int Buffer::age() const
+{
+    return d->age;
+}
+
 quint32 Buffer::getId(wl_buffer *b)
 {
     return wl_proxy_get_id(reinterpret_cast<wl_proxy *>(b));
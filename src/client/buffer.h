@@ -13,6 +13,7 @@
 #include <DWayland/Client/kwaylandclient_export.h>
 
 struct wl_buffer;
+class QRegion;
 
 namespace KWayland
 {
@@ -43,6 +44,16 @@ public:
      * Copies the data from @p src into the Buffer.
      **/
     void copy(const void *src);
+    /**
+     * Copies the data inside @p damage from @p src into the Buffer. The rest of the Buffer
+     * keeps its previous content. @p src has to use the size and stride of the Buffer.
+     *
+     * Together with age this allows to only update the parts of a reused Buffer which
+     * changed since it was last used.
+     * @see age
+     * @since 5.24
+     **/
+    void copy(const void *src, const QRegion &damage);
     /**
      * Sets the Buffer as @p released.
      * This is automatically invoked when the Wayland server sends the release event.
@@ -89,6 +100,17 @@ public:
      * @returns The image format used by this Buffer.
      **/
     Format format() const;
+    /**
+     * The age of the Buffer's content, like EGL_EXT_buffer_age: the number of buffers the
+     * ShmPool handed out since this Buffer was handed out the last time, counting this one.
+     * An age of @c 1 means the Buffer holds the previous frame, @c 2 the frame before it, and
+     * so on. A newly created Buffer has an age of @c 0, its content is undefined.
+     *
+     * To update a reused Buffer, the damage of the last age frames has to be repainted.
+     * This only holds if all frames drawn from the ShmPool are for the same surface.
+     * @since 5.24
+     **/
+    int age() const;
 
     operator wl_buffer *();
     operator wl_buffer *() const;
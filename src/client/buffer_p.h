@@ -20,6 +20,11 @@ public:
     Private(Buffer *q, ShmPool *parent, wl_buffer *nativeBuffer, const QSize &size, int32_t stride, size_t offset, Format format);
     ~Private();
     void destroy();
+    /**
+     * Copies @p rect from @p src, which has the size and stride of the buffer. ARGB32 pixels
+     * are premultiplied while copying if @p premultiply is @c true.
+     */
+    void copy(const void *src, const QRect &rect, bool premultiply = false);
 
     ShmPool *shm;
     WaylandPointer<wl_buffer, wl_buffer_destroy> nativeBuffer;
@@ -29,6 +34,9 @@ public:
     size_t offset;
     bool used;
     Format format;
+    // the ShmPool frame in which the buffer was handed out the last time
+    quint64 frame = 0;
+    int age = 0;
 
 private:
     Buffer *q;
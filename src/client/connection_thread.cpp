@@ -4,6 +4,7 @@
     SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
 */
 #include "connection_thread.h"
+#include "event_queue.h"
 #include "logging.h"
 // Qt
 #include <QAbstractEventDispatcher>
@@ -13,10 +14,18 @@
 #include <QGuiApplication>
 #include <QMutex>
 #include <QMutexLocker>
+#include <QPointer>
 #include <QSocketNotifier>
+#include <QThread>
+#include <QVarLengthArray>
 #include <qpa/qplatformnativeinterface.h>
 // Wayland
 #include <wayland-client-protocol.h>
+// system
+#include <errno.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
 
 namespace KWayland
 {
@@ -29,20 +38,52 @@ public:
     ~Private();
     void doInitConnection();
     void setupSocketNotifier();
+    void setupReaderThread();
+    void stopReaderThread();
     void setupSocketFileWatcher();
+    void readEvents();
+    void scheduleDispatch();
+    void dispatchPending();
+    bool handleError();
+
+    /**
+     * Reads events in a dedicated thread. The reader uses its own, always empty,
+     * wl_event_queue to prepare the read so that it never has to dispatch anything
+     * itself. Once events are read the threads owning the queues are woken up.
+     **/
+    class Reader : public QThread
+    {
+    public:
+        Reader(wl_display *display, ConnectionThread::Private *connection);
+        ~Reader() override;
+        void stop();
+
+    protected:
+        void run() override;
+
+    private:
+        wl_display *m_display;
+        ConnectionThread::Private *m_connection;
+        int m_wakeFd;
+    };
 
     wl_display *display = nullptr;
     int fd = -1;
     QString socketName;
     QDir runtimeDir;
     QScopedPointer<QSocketNotifier> socketNotifier;
+    QScopedPointer<Reader> reader;
     QScopedPointer<QFileSystemWatcher> socketWatcher;
+    ReadMode readMode = ReadMode::SocketNotifier;
+    QAtomicInt dispatchScheduled;
+    QVector<EventQueue *> eventQueues;
     bool serverDied = false;
     bool foreign = false;
     QMetaObject::Connection eventDispatcherConnection;
     int error = 0;
     static QVector<ConnectionThread *> connections;
     static QRecursiveMutex mutex;
+    static QMutex queueMutex;
 
 private:
     ConnectionThread *q;
@@ -50,6 +91,76 @@ private:
 
 QVector<ConnectionThread *> ConnectionThread::Private::connections = QVector<ConnectionThread *>{};
 QRecursiveMutex ConnectionThread::Private::mutex;
+QMutex ConnectionThread::Private::queueMutex;
+
+ConnectionThread::Private::Reader::Reader(wl_display *display, ConnectionThread::Private *connection)
+    : m_display(display)
+    , m_connection(connection)
+    , m_wakeFd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))
+{
+}
+
+ConnectionThread::Private::Reader::~Reader()
+{
+    stop();
+    if (m_wakeFd != -1) {
+        close(m_wakeFd);
+    }
+}
+
+void ConnectionThread::Private::Reader::stop()
+{
+    if (!isRunning()) {
+        return;
+    }
+    const quint64 value = 1;
+    if (write(m_wakeFd, &value, sizeof(value)) != sizeof(value)) {
+        qCWarning(KWAYLAND_CLIENT) << "Failed to wake up the Wayland reader thread";
+    }
+    wait();
+}
+
+void ConnectionThread::Private::Reader::run()
+{
+    if (m_wakeFd == -1) {
+        qCWarning(KWAYLAND_CLIENT) << "Failed to create wake up fd for the Wayland reader thread";
+        return;
+    }
+    wl_event_queue *readQueue = wl_display_create_queue(m_display);
+    pollfd fds[2] = {{wl_display_get_fd(m_display), POLLIN, 0}, {m_wakeFd, POLLIN, 0}};
+    while (true) {
+        if (wl_display_prepare_read_queue(m_display, readQueue) != 0) {
+            // no proxy is ever assigned to the read queue, but be defensive
+            wl_display_dispatch_queue_pending(m_display, readQueue);
+            continue;
+        }
+        fds[0].revents = 0;
+        fds[1].revents = 0;
+        if (poll(fds, 2, -1) == -1) {
+            wl_display_cancel_read(m_display);
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        if (fds[1].revents & POLLIN) {
+            wl_display_cancel_read(m_display);
+            break;
+        }
+        if (wl_display_read_events(m_display) == -1) {
+            QMetaObject::invokeMethod(
+                m_connection->q,
+                [connection = m_connection] {
+                    connection->handleError();
+                },
+                Qt::QueuedConnection);
+            break;
+        }
+        m_connection->scheduleDispatch();
+        m_connection->q->dispatchEventQueues();
+    }
+    wl_event_queue_destroy(readQueue);
+}
 
 ConnectionThread::Private::Private(ConnectionThread *q)
     : socketName(QString::fromUtf8(qgetenv("WAYLAND_DISPLAY")))
@@ -71,6 +182,7 @@ ConnectionThread::Private::~Private()
         QMutexLocker lock(&mutex);
         connections.removeOne(q);
     }
+    stopReaderThread();
     if (display && !foreign) {
         wl_display_flush(display);
         wl_display_disconnect(display);
@@ -96,7 +208,11 @@ void ConnectionThread::Private::doInitConnection()
     }
 
     // setup socket notifier
-    setupSocketNotifier();
+    if (readMode == ReadMode::DedicatedThread) {
+        setupReaderThread();
+    } else {
+        setupSocketNotifier();
+    }
     setupSocketFileWatcher();
     Q_EMIT q->connected();
 }
@@ -106,22 +222,87 @@ void ConnectionThread::Private::setupSocketNotifier()
     const int fd = wl_display_get_fd(display);
     socketNotifier.reset(new QSocketNotifier(fd, QSocketNotifier::Read));
     QObject::connect(socketNotifier.data(), &QSocketNotifier::activated, q, [this]() {
-        if (!display) {
+        readEvents();
+    });
+}
+
+void ConnectionThread::Private::setupReaderThread()
+{
+    reader.reset(new Reader(display, this));
+    reader->setObjectName(QStringLiteral("WaylandReader"));
+    reader->start();
+}
+
+void ConnectionThread::Private::stopReaderThread()
+{
+    reader.reset();
+}
+
+void ConnectionThread::Private::readEvents()
+{
+    if (!display) {
+        return;
+    }
+    // events already queued for the default queue need to be dispatched before we may read
+    while (wl_display_prepare_read(display) != 0) {
+        if (wl_display_dispatch_pending(display) == -1) {
+            // no read was prepared, so read_events may not be called; the next readable
+            // notification tries again unless the connection is gone
+            handleError();
             return;
         }
-        if (wl_display_dispatch(display) == -1) {
-            error = wl_display_get_error(display);
-            if (error != 0) {
-                if (display) {
-                    free(display);
-                    display = nullptr;
-                }
-                Q_EMIT q->errorOccurred();
-                return;
-            }
-        }
-        Q_EMIT q->eventsRead();
-    });
+    }
+    wl_display_flush(display);
+    // the socket notifier signalled readability, read_events won't block
+    if (wl_display_read_events(display) == -1 && handleError()) {
+        return;
+    }
+    if (wl_display_dispatch_pending(display) == -1 && handleError()) {
+        return;
+    }
+    q->dispatchEventQueues();
+    Q_EMIT q->eventsRead();
+}
+
+void ConnectionThread::Private::scheduleDispatch()
+{
+    if (!dispatchScheduled.testAndSetOrdered(0, 1)) {
+        return;
+    }
+    QMetaObject::invokeMethod(
+        q,
+        [this] {
+            dispatchPending();
+        },
+        Qt::QueuedConnection);
+}
+
+void ConnectionThread::Private::dispatchPending()
+{
+    dispatchScheduled.storeRelease(0);
+    if (!display) {
+        return;
+    }
+    if (wl_display_dispatch_pending(display) == -1 && handleError()) {
+        return;
+    }
+    Q_EMIT q->eventsRead();
+}
+
+bool ConnectionThread::Private::handleError()
+{
+    if (!display) {
+        return true;
+    }
+    error = wl_display_get_error(display);
+    if (error == 0) {
+        return false;
+    }
+    stopReaderThread();
+    free(display);
+    display = nullptr;
+    Q_EMIT q->errorOccurred();
+    return true;
 }
 
 void ConnectionThread::Private::setupSocketFileWatcher()
@@ -137,6 +318,7 @@ void ConnectionThread::Private::setupSocketFileWatcher()
         }
         qCWarning(KWAYLAND_CLIENT) << "Connection to server went away";
         serverDied = true;
+        stopReaderThread();
         if (display) {
             free(display);
             display = nullptr;
@@ -189,6 +371,12 @@ ConnectionThread::ConnectionThread(wl_display *display, QObject *parent)
 ConnectionThread::~ConnectionThread()
 {
     disconnect(d->eventDispatcherConnection);
+    d->stopReaderThread();
+    QMutexLocker lock(&Private::queueMutex);
+    for (EventQueue *queue : qAsConst(d->eventQueues)) {
+        queue->setConnection(nullptr);
+    }
+    d->eventQueues.clear();
 }
 
 ConnectionThread *ConnectionThread::fromApplication(QObject *parent)
@@ -234,6 +422,20 @@ void ConnectionThread::setSocketFd(int fd)
     d->fd = fd;
 }
 
+void ConnectionThread::setReadMode(ReadMode mode)
+{
+    if (d->display) {
+        // already initialized
+        return;
+    }
+    d->readMode = mode;
+}
+
+ConnectionThread::ReadMode ConnectionThread::readMode() const
+{
+    return d->readMode;
+}
+
 wl_display *ConnectionThread::display()
 {
     return d->display;
@@ -286,5 +488,43 @@ QVector<ConnectionThread *> ConnectionThread::connections()
     return Private::connections;
 }
 
+void ConnectionThread::addEventQueue(EventQueue *queue)
+{
+    QMutexLocker lock(&Private::queueMutex);
+    Q_ASSERT(!queue->connection());
+    queue->setConnection(this);
+    d->eventQueues.append(queue);
+}
+
+void ConnectionThread::removeEventQueue(EventQueue *queue)
+{
+    QMutexLocker lock(&Private::queueMutex);
+    if (ConnectionThread *connection = queue->connection()) {
+        connection->d->eventQueues.removeOne(queue);
+        queue->setConnection(nullptr);
+    }
+}
+
+void ConnectionThread::dispatchEventQueues()
+{
+    // queues living in the current thread are dispatched directly, all others get woken up
+    QVarLengthArray<QPointer<EventQueue>, 8> localQueues;
+    {
+        QMutexLocker lock(&Private::queueMutex);
+        for (EventQueue *queue : qAsConst(d->eventQueues)) {
+            if (queue->thread() == QThread::currentThread()) {
+                localQueues.append(queue);
+            } else {
+                queue->scheduleDispatch();
+            }
+        }
+    }
+    for (const QPointer<EventQueue> &queue : qAsConst(localQueues)) {
+        if (queue) {
+            queue->dispatch();
+        }
+    }
+}
+
 }
 }
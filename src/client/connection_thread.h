@@ -40,6 +40,8 @@ namespace KWayland
  **/
 namespace Client
 {
+class EventQueue;
+
 /**
  * @short Creates and manages the connection to a Wayland server.
  *
@@ -71,9 +73,14 @@ namespace Client
  * connection->initConnection();
  * @endcode
  *
- * This class is also responsible for dispatching events. Whenever new data is available on
- * the Wayland socket, it will be dispatched and the signal @link ::eventsRead @endlink is emitted.
- * This allows further event queues in other threads to also dispatch their events.
+ * This class is also responsible for reading and dispatching events. Whenever new data is
+ * available on the Wayland socket, it is read with the wl_display_prepare_read/wl_display_read_events
+ * protocol, the default queue gets dispatched and the signal @link ::eventsRead @endlink is emitted.
+ * EventQueues set up for this connection are dispatched right away if they live in the same thread,
+ * otherwise their owning thread gets woken up once to dispatch them.
+ *
+ * By default events are read from a QSocketNotifier in the thread the ConnectionThread lives in.
+ * Alternatively a dedicated I/O thread can be used, see @link ::setReadMode @endlink.
  *
  * Furthermore this class flushes the Wayland connection whenever the QAbstractEventDispatcher
  * is about to block.
@@ -107,6 +114,25 @@ class KWAYLANDCLIENT_EXPORT ConnectionThread : public QObject
 {
     Q_OBJECT
 public:
+    /**
+     * Describes how events are read from the Wayland socket.
+     * @see setReadMode
+     * @since 5.24
+     **/
+    enum class ReadMode {
+        /**
+         * Events are read by a QSocketNotifier in the thread the ConnectionThread lives in.
+         **/
+        SocketNotifier,
+        /**
+         * Events are read by a dedicated I/O thread owned by the ConnectionThread.
+         * The I/O thread never dispatches, it only wakes up the threads owning the
+         * default queue and the EventQueues.
+         **/
+        DedicatedThread,
+    };
+    Q_ENUM(ReadMode)
+
     explicit ConnectionThread(QObject *parent = nullptr);
     ~ConnectionThread() override;
 
@@ -160,6 +186,22 @@ public:
      **/
     void setSocketFd(int fd);
 
+    /**
+     * Sets the @p mode used to read events from the Wayland socket.
+     * Only applies if called before calling initConnection. The default is
+     * ReadMode::SocketNotifier.
+     *
+     * @see readMode
+     * @since 5.24
+     **/
+    void setReadMode(ReadMode mode);
+    /**
+     * @returns how events are read from the Wayland socket.
+     * @see setReadMode
+     * @since 5.24
+     **/
+    ReadMode readMode() const;
+
     /**
      * Trigger a blocking roundtrip to the Wayland server. Ensures that all events are processed
      * before returning to the event loop.
@@ -219,7 +261,9 @@ Q_SIGNALS:
      **/
     void failed();
     /**
-     * Emitted whenever new events are ready to be read.
+     * Emitted whenever new events have been read and the default queue got dispatched.
+     * EventQueues set up for this ConnectionThread do not need this signal, they are
+     * dispatched automatically.
      **/
     void eventsRead();
     /**
@@ -252,6 +296,11 @@ private Q_SLOTS:
     void doInitConnection();
 
 private:
+    friend class EventQueue;
+    void addEventQueue(EventQueue *queue);
+    static void removeEventQueue(EventQueue *queue);
+    void dispatchEventQueues();
+
     class Private;
     QScopedPointer<Private> d;
 };
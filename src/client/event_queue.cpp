@@ -18,6 +18,9 @@ class Q_DECL_HIDDEN EventQueue::Private
 public:
     wl_display *display = nullptr;
     WaylandPointer<wl_event_queue, wl_event_queue_destroy> queue;
+    // guarded by the ConnectionThread's queue mutex
+    ConnectionThread *connection = nullptr;
+    QAtomicInt dispatchScheduled;
 };
 
 EventQueue::EventQueue(QObject *parent)
@@ -33,12 +36,14 @@ EventQueue::~EventQueue()
 
 void EventQueue::release()
 {
+    ConnectionThread::removeEventQueue(this);
     d->queue.release();
     d->display = nullptr;
 }
 
 void EventQueue::destroy()
 {
+    ConnectionThread::removeEventQueue(this);
     d->queue.destroy();
     d->display = nullptr;
 }
@@ -60,7 +65,32 @@ void EventQueue::setup(wl_display *display)
 void EventQueue::setup(ConnectionThread *connection)
 {
     setup(connection->display());
-    connect(connection, &ConnectionThread::eventsRead, this, &EventQueue::dispatch, Qt::QueuedConnection);
+    connection->addEventQueue(this);
+}
+
+void EventQueue::scheduleDispatch()
+{
+    // coalesce wake ups, one pending dispatch is enough to consume everything read so far
+    if (!d->dispatchScheduled.testAndSetOrdered(0, 1)) {
+        return;
+    }
+    QMetaObject::invokeMethod(
+        this,
+        [this] {
+            d->dispatchScheduled.storeRelease(0);
+            dispatch();
+        },
+        Qt::QueuedConnection);
+}
+
+void EventQueue::setConnection(ConnectionThread *connection)
+{
+    d->connection = connection;
+}
+
+ConnectionThread *EventQueue::connection() const
+{
+    return d->connection;
 }
 
 void EventQueue::dispatch()
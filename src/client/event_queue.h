@@ -70,9 +70,9 @@ public:
     /**
      * Creates the event queue for the @p connection.
      *
-     * This method also connects the eventsRead signal of the ConnectionThread
-     * to the dispatch method. Events will be automatically dispatched without
-     * the need to call dispatch manually.
+     * This method also registers the EventQueue with the ConnectionThread.
+     * Events will be automatically dispatched in the thread the EventQueue
+     * lives in without the need to call dispatch manually.
      * @see dispatch
      **/
     void setup(ConnectionThread *connection);
@@ -125,6 +125,11 @@ public Q_SLOTS:
     void dispatch();
 
 private:
+    friend class ConnectionThread;
+    void scheduleDispatch();
+    void setConnection(ConnectionThread *connection);
+    ConnectionThread *connection() const;
+
     class Private;
     QScopedPointer<Private> d;
 };
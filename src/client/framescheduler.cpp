@@ -0,0 +1,144 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include "framescheduler.h"
+#include "surface.h"
+
+#include <QPointer>
+
+namespace KWayland
+{
+namespace Client
+{
+// longer intervals mean the surface was not animating
+static const quint32 s_maxFrameInterval = 1000;
+
+class Q_DECL_HIDDEN FrameScheduler::Private
+{
+public:
+    Private(FrameScheduler *q, Surface *surface);
+
+    void render();
+    void handleFrameRendered();
+
+    QPointer<Surface> surface;
+    bool scheduled = false;
+    bool callbackPending = false;
+    // whether renderRequested is emitted for a frame callback
+    bool renderingForCallback = false;
+    // whether the pending frame was committed right after the previous frame was rendered
+    bool consecutiveFrame = false;
+    bool hasCallbackTime = false;
+    quint32 lastCallbackTime = 0;
+    qreal presentationInterval = 0;
+
+private:
+    FrameScheduler *q;
+};
+
+FrameScheduler::Private::Private(FrameScheduler *q, Surface *surface)
+    : surface(surface)
+    , q(q)
+{
+}
+
+void FrameScheduler::Private::render()
+{
+    scheduled = false;
+    Q_EMIT q->renderRequested();
+}
+
+void FrameScheduler::Private::handleFrameRendered()
+{
+    if (!callbackPending) {
+        return;
+    }
+    callbackPending = false;
+
+    const quint32 time = surface->frameCallbackTime();
+    if (consecutiveFrame && hasCallbackTime) {
+        // the timestamps wrap around, unsigned arithmetic takes care of that
+        const quint32 interval = time - lastCallbackTime;
+        if (interval > 0 && interval <= s_maxFrameInterval) {
+            // the timestamps only have millisecond precision, averaging recovers fractions
+            presentationInterval = presentationInterval > 0 ? (presentationInterval * 7 + interval) / 8 : interval;
+        }
+    }
+    lastCallbackTime = time;
+    hasCallbackTime = true;
+
+    if (scheduled) {
+        renderingForCallback = true;
+        render();
+        renderingForCallback = false;
+    }
+}
+
+FrameScheduler::FrameScheduler(Surface *surface, QObject *parent)
+    : QObject(parent)
+    , d(new Private(this, surface))
+{
+    connect(surface, &Surface::frameRendered, this, [this] {
+        d->handleFrameRendered();
+    });
+}
+
+FrameScheduler::~FrameScheduler() = default;
+
+Surface *FrameScheduler::surface() const
+{
+    return d->surface;
+}
+
+void FrameScheduler::scheduleFrame()
+{
+    if (d->scheduled) {
+        return;
+    }
+    d->scheduled = true;
+    if (d->callbackPending) {
+        // rendered once the compositor is done with the previous frame
+        return;
+    }
+    QMetaObject::invokeMethod(
+        this,
+        [this] {
+            if (d->scheduled && !d->callbackPending) {
+                d->render();
+            }
+        },
+        Qt::QueuedConnection);
+}
+
+bool FrameScheduler::isFrameScheduled() const
+{
+    return d->scheduled;
+}
+
+bool FrameScheduler::isFrameCallbackPending() const
+{
+    return d->callbackPending;
+}
+
+void FrameScheduler::commit()
+{
+    if (!d->surface || !d->surface->isValid()) {
+        return;
+    }
+    if (d->callbackPending) {
+        d->surface->commit(Surface::CommitFlag::None);
+        return;
+    }
+    d->surface->commit(Surface::CommitFlag::FrameCallback);
+    d->callbackPending = true;
+    d->consecutiveFrame = d->renderingForCallback;
+}
+
+qreal FrameScheduler::presentationInterval() const
+{
+    return d->presentationInterval;
+}
+
+}
+}
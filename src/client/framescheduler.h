@@ -0,0 +1,95 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include <QObject>
+
+#include <DWayland/Client/kwaylandclient_export.h>
+
+namespace KWayland
+{
+namespace Client
+{
+class Surface;
+
+/**
+ * @short Paces the rendering of a Surface by the compositor's frame callbacks.
+ *
+ * Instead of repainting on every change, an application calls scheduleFrame whenever
+ * its content changed and paints in response to renderRequested. Any number of requests
+ * between two frames are coalesced into one renderRequested. While a committed frame has
+ * not been rendered by the compositor yet, renderRequested is held back until the frame
+ * callback arrives, so the application paints at most once per frame of the compositor
+ * and does not wake it for frames which would never be shown.
+ *
+ * The frame has to be committed with commit, which registers the frame callback. The
+ * Surface must not get frame callbacks set up otherwise while a FrameScheduler is used.
+ *
+ * @code
+ * FrameScheduler *scheduler = new FrameScheduler(surface, this);
+ * connect(scheduler, &FrameScheduler::renderRequested, this, [this, scheduler, surface] {
+ *     surface->attachBuffer(paint());
+ *     surface->damage(dirtyRegion());
+ *     scheduler->commit();
+ * });
+ * // whenever something changed
+ * scheduler->scheduleFrame();
+ * @endcode
+ *
+ * @since 5.24
+ **/
+class KWAYLANDCLIENT_EXPORT FrameScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FrameScheduler(Surface *surface, QObject *parent = nullptr);
+    ~FrameScheduler() override;
+
+    /**
+     * @returns The Surface whose frames get scheduled.
+     **/
+    Surface *surface() const;
+
+    /**
+     * Requests a new frame. renderRequested gets emitted once the compositor is ready for
+     * it, but not before the event loop is reached again.
+     * @see renderRequested
+     **/
+    void scheduleFrame();
+    /**
+     * @returns @c true if a frame was requested and renderRequested was not emitted yet.
+     **/
+    bool isFrameScheduled() const;
+    /**
+     * @returns @c true if a committed frame was not rendered by the compositor yet.
+     **/
+    bool isFrameCallbackPending() const;
+
+    /**
+     * Commits the Surface and registers the frame callback the next frame waits for.
+     * If the previous frame was not rendered yet, the Surface is committed without one.
+     **/
+    void commit();
+
+    /**
+     * @returns The interval between frames of the compositor in milliseconds, as measured
+     * from the timestamps of frame callbacks for consecutive frames. @c 0 until known.
+     **/
+    qreal presentationInterval() const;
+
+Q_SIGNALS:
+    /**
+     * Emitted when a requested frame should be painted and committed with commit.
+     * @see scheduleFrame
+     **/
+    void renderRequested();
+
+private:
+    class Private;
+    QScopedPointer<Private> d;
+};
+
+}
+}
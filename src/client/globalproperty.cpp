@@ -7,7 +7,8 @@
 #include "surface.h"
 #include "wayland_pointer_p.h"
 // Qt
-
+#include <QDataStream>
+#include <QHash>
 // wayland
 #include "wayland-dde-globalproperty-client-protocol.h"
 #include "wayland-client-protocol.h"
@@ -26,6 +27,8 @@ public:
 
     WaylandPointer<dde_globalproperty, dde_globalproperty_destroy> ddeglobalproperty;
     EventQueue *queue = nullptr;
+    // the ids of the keys registered with the compositor for the binary encoding
+    QHash<QString, quint16> keyIds;
 
 private:
     GlobalProperty *q;
@@ -94,6 +97,70 @@ void GlobalProperty::setProperty(const QString &module, const QString &function,
     setProperty(module, function, *surface, type, data);
 }
 
+// see the record format in the compositor's GlobalPropertyInterface
+enum class PropertyRecord : quint8 {
+    DefineKey = 0,
+    Bool = 1,
+    Int = 2,
+    Double = 3,
+    String = 4,
+    Remove = 5,
+    Int64 = 6,
+    UInt64 = 7,
+};
+
+// marks the data as binary, JSON sent with the same type is still accepted
+static const QLatin1String s_binaryMagic("dwpb:");
+
+void GlobalProperty::setProperties(const QString &module, const QString &function, Surface *surface, const QVariantMap &properties)
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    for (auto it = properties.constBegin(); it != properties.constEnd(); ++it) {
+        auto id = d->keyIds.constFind(it.key());
+        if (id == d->keyIds.constEnd()) {
+            const QByteArray name = it.key().toUtf8();
+            id = d->keyIds.insert(it.key(), quint16(d->keyIds.count()));
+            stream << quint8(PropertyRecord::DefineKey) << *id << quint16(name.size());
+            stream.writeRawData(name.constData(), name.size());
+        }
+
+        const QVariant &value = it.value();
+        switch (value.userType()) {
+        case QMetaType::UnknownType:
+            stream << quint8(PropertyRecord::Remove) << *id;
+            break;
+        case QMetaType::Bool:
+            stream << quint8(PropertyRecord::Bool) << *id << quint8(value.toBool());
+            break;
+        case QMetaType::Int:
+        case QMetaType::Short:
+        case QMetaType::UShort:
+            stream << quint8(PropertyRecord::Int) << *id << qint32(value.toInt());
+            break;
+        case QMetaType::UInt:
+        case QMetaType::LongLong:
+            stream << quint8(PropertyRecord::Int64) << *id << value.toLongLong();
+            break;
+        case QMetaType::ULongLong:
+            stream << quint8(PropertyRecord::UInt64) << *id << value.toULongLong();
+            break;
+        case QMetaType::Double:
+        case QMetaType::Float:
+            stream << quint8(PropertyRecord::Double) << *id << value.toDouble();
+            break;
+        default: {
+            const QByteArray text = value.toString().toUtf8();
+            stream << quint8(PropertyRecord::String) << *id << quint32(text.size());
+            stream.writeRawData(text.constData(), text.size());
+            break;
+        }
+        }
+    }
+    setProperty(module, function, surface, 1, s_binaryMagic + QString::fromLatin1(data.toBase64()));
+}
+
 QString GlobalProperty::getProperty(const QString &module, const QString &function)
 {
     return QString();
@@ -9,6 +9,7 @@
 #include <QPointer>
 #include <QString>
 #include <QMap>
+#include <QVariant>
 
 #include <DWayland/Client/kwaylandclient_export.h>
 
@@ -55,6 +56,13 @@ public:
 
     void setProperty(const QString &module, const QString &function, wl_surface *surface, const int32_t &type, const QString &data);
     void setProperty(const QString &module, const QString &function, Surface *surface, const int32_t &type, const QString &data);
+    /**
+     * Sets @p properties of @p surface with a compact binary encoding instead of JSON. The key
+     * names are sent only the first time they are used with this GlobalProperty, afterwards they
+     * are referred to by ids. An invalid QVariant removes a property.
+     * @since 5.24
+     */
+    void setProperties(const QString &module, const QString &function, Surface *surface, const QVariantMap &properties);
     QString getProperty(const QString &module, const QString &function);
 
     /**
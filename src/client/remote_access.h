@@ -183,6 +183,10 @@ public:
 
 
 Q_SIGNALS:
+    /**
+     * Emitted once the server sent the parameters of the buffer. A buffer the server revoked
+     * before it got fetched never gets its parameters, it still has to be released.
+     **/
     void parametersObtained();
 
 private:
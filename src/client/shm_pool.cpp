@@ -11,8 +11,10 @@
 // Qt
 #include <QDebug>
 #include <QImage>
+#include <QRegion>
 #include <QTemporaryFile>
 // system
+#include <limits>
 #include <sys/mman.h>
 #include <unistd.h>
 // wayland
@@ -29,6 +31,18 @@ public:
     bool createPool();
     bool resizePool(int32_t newSize);
     QList<QSharedPointer<Buffer>>::iterator getBuffer(const QSize &size, int32_t stride, Buffer::Format format);
+    /**
+     * Records @p damage as the damage of the frame of the Buffer handed out last.
+     */
+    void addDamage(const QRegion &damage);
+    /**
+     * @returns The region of @p buffer which has to be updated for a frame with @p damage.
+     */
+    QRegion staleRegion(const Buffer *buffer, const QRegion &damage) const;
+    /**
+     * Copies @p region of @p image, which has to be in one of the formats of toBufferImage.
+     */
+    void copyImage(Buffer *buffer, const QImage &image, const QRegion &region);
     WaylandPointer<wl_shm, wl_shm_destroy> shm;
     WaylandPointer<wl_shm_pool, wl_shm_pool_destroy> pool;
     void *poolData = nullptr;
@@ -38,6 +52,10 @@ public:
     int offset = 0;
     QList<QSharedPointer<Buffer>> buffers;
     EventQueue *queue = nullptr;
+    // counts the buffers handed out, used for the age of buffers
+    quint64 frame = 0;
+    // the damage of the last frames, the most recent one last
+    QVector<QRegion> damageHistory;
 
 private:
     ShmPool *q;
@@ -150,23 +168,63 @@ bool ShmPool::Private::resizePool(int32_t newSize)
     return true;
 }
 
+// older frames are not tracked, buffers which were unused for longer get copied completely
+static const int s_maxDamageHistory = 8;
+
+void ShmPool::Private::addDamage(const QRegion &damage)
+{
+    damageHistory.append(damage);
+    if (damageHistory.count() > s_maxDamageHistory) {
+        damageHistory.removeFirst();
+    }
+}
+
+QRegion ShmPool::Private::staleRegion(const Buffer *buffer, const QRegion &damage) const
+{
+    const QRect bufferRect(QPoint(0, 0), buffer->size());
+    const int age = buffer->age();
+    if (age == 0 || age - 1 > damageHistory.count()) {
+        return bufferRect;
+    }
+    QRegion region = damage;
+    for (int i = damageHistory.count() - age + 1; i < damageHistory.count(); ++i) {
+        region += damageHistory.at(i);
+    }
+    return region & bufferRect;
+}
+
+void ShmPool::Private::copyImage(Buffer *buffer, const QImage &image, const QRegion &region)
+{
+    // premultiplying while copying avoids a converted copy of the whole image
+    const bool premultiply = image.format() == QImage::Format_ARGB32;
+    for (const QRect &rect : region) {
+        buffer->d->copy(image.constBits(), rect, premultiply);
+    }
+}
+
 namespace
 {
-static Buffer::Format toBufferFormat(const QImage &image)
+/**
+ * @returns @p image converted to a format which can be copied into a Buffer as is, the
+ * buffer has to be created with the stride of the returned image.
+ */
+static QImage toBufferImage(const QImage &image)
 {
     switch (image.format()) {
     case QImage::Format_ARGB32_Premultiplied:
-        return Buffer::Format::ARGB32;
     case QImage::Format_RGB32:
-        return Buffer::Format::RGB32;
     case QImage::Format_ARGB32:
-        qCWarning(KWAYLAND_CLIENT) << "Unsupported image format: " << image.format() << ". expect slow performance. Use QImage::Format_ARGB32_Premultiplied";
-        return Buffer::Format::ARGB32;
+        return image;
     default:
         qCWarning(KWAYLAND_CLIENT) << "Unsupported image format: " << image.format() << ". expect slow performance.";
-        return Buffer::Format::ARGB32;
+        return image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
     }
 }
+
+static Buffer::Format toBufferFormat(const QImage &image)
+{
+    return image.format() == QImage::Format_RGB32 ? Buffer::Format::RGB32 : Buffer::Format::ARGB32;
+}
 }
 
 Buffer::Ptr ShmPool::createBuffer(const QImage &image)
@@ -174,17 +232,30 @@ Buffer::Ptr ShmPool::createBuffer(const QImage &image)
     if (image.isNull() || !d->valid) {
         return QWeakPointer<Buffer>();
     }
-    auto format = toBufferFormat(image);
-    auto it = d->getBuffer(image.size(), image.bytesPerLine(), format);
+    const QImage source = toBufferImage(image);
+    auto format = toBufferFormat(source);
+    auto it = d->getBuffer(source.size(), source.bytesPerLine(), format);
     if (it == d->buffers.end()) {
         return QWeakPointer<Buffer>();
     }
-    if (format == Buffer::Format::ARGB32 && image.format() != QImage::Format_ARGB32_Premultiplied) {
-        auto imageCopy = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
-        (*it)->copy(imageCopy.bits());
-    } else {
-        (*it)->copy(image.bits());
+    d->addDamage(source.rect());
+    d->copyImage(it->data(), source, source.rect());
+    return QWeakPointer<Buffer>(*it);
+}
+
+Buffer::Ptr ShmPool::createBuffer(const QImage &image, const QRegion &damage)
+{
+    if (image.isNull() || !d->valid) {
+        return QWeakPointer<Buffer>();
+    }
+    const QImage source = toBufferImage(image);
+    auto it = d->getBuffer(source.size(), source.bytesPerLine(), toBufferFormat(source));
+    if (it == d->buffers.end()) {
+        return QWeakPointer<Buffer>();
     }
+    const QRegion clippedDamage = damage & source.rect();
+    d->copyImage(it->data(), source, d->staleRegion(it->data(), clippedDamage));
+    d->addDamage(clippedDamage);
     return QWeakPointer<Buffer>(*it);
 }
 
@@ -197,6 +268,7 @@ Buffer::Ptr ShmPool::createBuffer(const QSize &size, int32_t stride, const void
     if (it == d->buffers.end()) {
         return QWeakPointer<Buffer>();
     }
+    d->addDamage(QRect(QPoint(0, 0), size));
     (*it)->copy(src);
     return QWeakPointer<Buffer>(*it);
 }
@@ -221,6 +293,8 @@ Buffer::Ptr ShmPool::getBuffer(const QSize &size, int32_t stride, Buffer::Format
     if (it == d->buffers.end()) {
         return QWeakPointer<Buffer>();
     }
+    // the caller may change anything
+    d->addDamage(QRect(QPoint(0, 0), size));
     return QWeakPointer<Buffer>(*it);
 }
 
@@ -235,6 +309,9 @@ QList<QSharedPointer<Buffer>>::iterator ShmPool::Private::getBuffer(const QSize
             continue;
         }
         buffer->setReleased(false);
+        ++frame;
+        buffer->d->age = int(qMin<quint64>(frame - buffer->d->frame, std::numeric_limits<int>::max()));
+        buffer->d->frame = frame;
         return it;
     }
     const int32_t byteCount = s.height() * stride;
@@ -252,6 +329,7 @@ QList<QSharedPointer<Buffer>>::iterator ShmPool::Private::getBuffer(const QSize
         queue->addProxy(native);
     }
     Buffer *buffer = new Buffer(q, native, s, stride, offset, format);
+    buffer->d->frame = ++frame;
     offset += byteCount;
     auto it = buffers.insert(buffers.end(), QSharedPointer<Buffer>(buffer));
     return it;
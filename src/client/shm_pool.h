@@ -12,6 +12,7 @@
 #include <DWayland/Client/kwaylandclient_export.h>
 
 class QImage;
+class QRegion;
 class QSize;
 
 struct wl_shm;
@@ -180,6 +181,23 @@ public:
      * @see getBuffer
      **/
     Buffer::Ptr createBuffer(const QImage &image);
+    /**
+     * Like createBuffer, but only copies the parts of @p image which differ from the content
+     * of the provided Buffer. @p damage is the region of @p image which changed since the
+     * image passed for the previous Buffer. If a reused Buffer is returned, only @p damage
+     * and the damage of the frames since the Buffer was used the last time is copied.
+     *
+     * This requires that all Buffers of this ShmPool are used for the frames of the same
+     * surface, the Buffer::age of the returned Buffer tells the damage of which frames was
+     * considered. Images using QImage::Format_ARGB32 are premultiplied while being copied.
+     *
+     * @param image The image which should be copied into the Buffer
+     * @param damage The region of @p image which changed since the previous frame
+     * @return Buffer with the content of @p image in success case, a @c null Buffer::Ptr otherwise
+     * @see Buffer::age
+     * @since 5.24
+     **/
+    Buffer::Ptr createBuffer(const QImage &image, const QRegion &damage);
     /**
      * Provides a Buffer with @p size, @p stride and @p format.
      *
@@ -12,6 +12,9 @@
 #include <QRegion>
 #include <QVector>
 #include <qpa/qplatformnativeinterface.h>
+// system
+#include <algorithm>
+#include <limits>
 // Wayland
 #include <wayland-client-protocol.h>
 
@@ -27,10 +30,15 @@ public:
 
     WaylandPointer<wl_surface, wl_surface_destroy> surface;
     bool frameCallbackInstalled = false;
+    quint32 frameCallbackTime = 0;
     QSize size;
     bool foreign = false;
     qint32 scale = 1;
     QVector<Output *> outputs;
+    // collected until the next commit if the damage is batched
+    int maximumDamageRects = 0;
+    QRegion pendingDamage;
+    QRegion pendingBufferDamage;
 
     void setup(wl_surface *s);
 
@@ -50,6 +58,93 @@ private:
 
 QList<Surface *> Surface::Private::s_surfaces = QList<Surface *>();
 
+static qint64 area(const QRect &rect)
+{
+    return qint64(rect.width()) * rect.height();
+}
+
+/**
+ * The area the bounding rect of @p a and @p b covers in addition to them.
+ */
+static qint64 mergeCost(const QRect &a, const QRect &b)
+{
+    return area(a | b) - area(a) - area(b) + area(a & b);
+}
+
+/**
+ * Reduces @p region to at most @p maximum rects, greedily merging the pair of rects
+ * which adds the least area. Each rect remembers its cheapest partner, so only the rects
+ * affected by a merge need to be looked at again.
+ */
+static QVector<QRect> simplifyDamage(const QRegion &region, int maximum)
+{
+    QVector<QRect> rects(region.begin(), region.end());
+    if (rects.count() <= maximum) {
+        return rects;
+    }
+    QVector<int> partners(rects.count());
+    QVector<qint64> partnerCosts(rects.count());
+    auto updatePartner = [&rects, &partners, &partnerCosts](int i) {
+        partners[i] = -1;
+        partnerCosts[i] = std::numeric_limits<qint64>::max();
+        for (int j = 0; j < rects.count(); ++j) {
+            if (j == i) {
+                continue;
+            }
+            const qint64 cost = mergeCost(rects.at(i), rects.at(j));
+            if (cost < partnerCosts.at(i)) {
+                partners[i] = j;
+                partnerCosts[i] = cost;
+            }
+        }
+    };
+    for (int i = 0; i < rects.count(); ++i) {
+        updatePartner(i);
+    }
+
+    while (rects.count() > maximum) {
+        int i = std::min_element(partnerCosts.constBegin(), partnerCosts.constEnd()) - partnerCosts.constBegin();
+        const int j = partners.at(i);
+        const int last = rects.count() - 1;
+        rects[i] |= rects.at(j);
+
+        // j gets replaced by the last rect
+        for (int k = 0; k < rects.count(); ++k) {
+            if (partners.at(k) == i || partners.at(k) == j) {
+                partners[k] = -1;
+            } else if (partners.at(k) == last) {
+                partners[k] = j;
+            }
+        }
+        rects[j] = rects.at(last);
+        partners[j] = partners.at(last);
+        partnerCosts[j] = partnerCosts.at(last);
+        rects.removeLast();
+        partners.removeLast();
+        partnerCosts.removeLast();
+        if (i == last) {
+            i = j;
+        }
+
+        updatePartner(i);
+        for (int k = 0; k < rects.count(); ++k) {
+            if (k == i) {
+                continue;
+            }
+            if (partners.at(k) == -1) {
+                updatePartner(k);
+                continue;
+            }
+            const qint64 cost = mergeCost(rects.at(k), rects.at(i));
+            if (cost < partnerCosts.at(k)) {
+                partners[k] = i;
+                partnerCosts[k] = cost;
+            }
+        }
+    }
+    return rects;
+}
+
 Surface::Private::Private(Surface *q)
     : q(q)
 {
@@ -132,11 +227,11 @@ void Surface::Private::setup(wl_surface *s)
 
 void Surface::Private::frameCallback(void *data, wl_callback *callback, uint32_t time)
 {
-    Q_UNUSED(time)
     auto s = reinterpret_cast<Surface::Private *>(data);
     if (callback) {
         wl_callback_destroy(callback);
     }
+    s->frameCallbackTime = time;
     s->handleFrameCallback();
 }
 
@@ -195,17 +290,27 @@ void Surface::setupFrameCallback()
     d->setupFrameCallback();
 }
 
+quint32 Surface::frameCallbackTime() const
+{
+    return d->frameCallbackTime;
+}
+
 void Surface::commit(Surface::CommitFlag flag)
 {
     Q_ASSERT(isValid());
     if (flag == CommitFlag::FrameCallback) {
         setupFrameCallback();
     }
+    flushDamage();
     wl_surface_commit(d->surface);
 }
 
 void Surface::damage(const QRegion &region)
 {
+    if (d->maximumDamageRects > 0) {
+        d->pendingDamage += region;
+        return;
+    }
     for (const QRect &rect : region) {
         damage(rect);
     }
@@ -214,11 +319,19 @@ void Surface::damage(const QRegion &region)
 void Surface::damage(const QRect &rect)
 {
     Q_ASSERT(isValid());
+    if (d->maximumDamageRects > 0) {
+        d->pendingDamage += rect;
+        return;
+    }
     wl_surface_damage(d->surface, rect.x(), rect.y(), rect.width(), rect.height());
 }
 
 void Surface::damageBuffer(const QRegion &region)
 {
+    if (d->maximumDamageRects > 0) {
+        d->pendingBufferDamage += region;
+        return;
+    }
     for (const QRect &r : region) {
         damageBuffer(r);
     }
@@ -227,9 +340,49 @@ void Surface::damageBuffer(const QRegion &region)
 void Surface::damageBuffer(const QRect &rect)
 {
     Q_ASSERT(isValid());
+    if (d->maximumDamageRects > 0) {
+        d->pendingBufferDamage += rect;
+        return;
+    }
     wl_surface_damage_buffer(d->surface, rect.x(), rect.y(), rect.width(), rect.height());
 }
 
+void Surface::setMaximumDamageRects(int count)
+{
+    count = qMax(0, count);
+    if (d->maximumDamageRects == count) {
+        return;
+    }
+    if (count == 0 && isValid()) {
+        flushDamage();
+    }
+    d->maximumDamageRects = count;
+}
+
+int Surface::maximumDamageRects() const
+{
+    return d->maximumDamageRects;
+}
+
+void Surface::flushDamage()
+{
+    Q_ASSERT(isValid());
+    if (!d->pendingDamage.isEmpty()) {
+        const QVector<QRect> rects = simplifyDamage(d->pendingDamage, d->maximumDamageRects);
+        for (const QRect &rect : rects) {
+            wl_surface_damage(d->surface, rect.x(), rect.y(), rect.width(), rect.height());
+        }
+        d->pendingDamage = QRegion();
+    }
+    if (!d->pendingBufferDamage.isEmpty()) {
+        const QVector<QRect> rects = simplifyDamage(d->pendingBufferDamage, d->maximumDamageRects);
+        for (const QRect &rect : rects) {
+            wl_surface_damage_buffer(d->surface, rect.x(), rect.y(), rect.width(), rect.height());
+        }
+        d->pendingBufferDamage = QRegion();
+    }
+}
+
 void Surface::attachBuffer(wl_buffer *buffer, const QPoint &offset)
 {
     Q_ASSERT(isValid());
@@ -115,6 +115,13 @@ public:
      * @see commit
      **/
     void setupFrameCallback();
+    /**
+     * @returns The timestamp in milliseconds the server passed with the last frame callback.
+     * The timestamps have an undefined base, only the difference between two is meaningful.
+     * @see frameRendered
+     * @since 5.24
+     **/
+    quint32 frameCallbackTime() const;
     /**
      * Flags to be added to commit.
      * @li None: no flag
@@ -154,6 +161,35 @@ public:
      * @since 5.59
      **/
     void damageBuffer(const QRegion &region);
+    /**
+     * Sets the maximum number of rects the damage of a frame gets sent with.
+     *
+     * By default, damage and damageBuffer send each rect right away. With a @p count greater
+     * than @c 0 the damage is collected until the next commit. Damage with more than @p count
+     * rects gets simplified first, merging the rects which add the least area that was not
+     * damaged. Complex regions then need far fewer requests, at the cost of some over-damage.
+     *
+     * If the Surface is committed other than through commit, e.g. by the EGL stack,
+     * flushDamage has to be called before.
+     *
+     * @param count The maximum number of rects, or @c 0 to send the damage unchanged
+     * @see flushDamage
+     * @since 5.24
+     **/
+    void setMaximumDamageRects(int count);
+    /**
+     * @returns The maximum number of rects the damage gets sent with, @c 0 if unbatched.
+     * @see setMaximumDamageRects
+     * @since 5.24
+     **/
+    int maximumDamageRects() const;
+    /**
+     * Sends the damage collected since the last commit.
+     * This happens automatically in commit.
+     * @see setMaximumDamageRects
+     * @since 5.24
+     **/
+    void flushDamage();
     /**
      * Attaches the @p buffer to this Surface for the next frame.
      * @param buffer The buffer to attach to this Surface
@@ -5,6 +5,7 @@
 */
 #include "clientconnection.h"
 #include "display.h"
+#include "display_p.h"
 #include "utils/executable_path.h"
 // Qt
 #include <QFileInfo>
@@ -145,4 +146,31 @@ QString ClientConnection::executablePath() const
     return d->executablePath;
 }
 
+bool ClientConnection::isBacklogged() const
+{
+    if (!d->client) {
+        return false;
+    }
+    const ClientState *state = DisplayPrivate::get(d->display)->clientState(d->client);
+    return state && state->backlogged;
+}
+
+quint64 ClientConnection::requestCount() const
+{
+    if (!d->client) {
+        return 0;
+    }
+    const ClientState *state = DisplayPrivate::get(d->display)->clientState(d->client);
+    return state ? state->requestCount : 0;
+}
+
+qint64 ClientConnection::dispatchTime() const
+{
+    if (!d->client) {
+        return 0;
+    }
+    const ClientState *state = DisplayPrivate::get(d->display)->clientState(d->client);
+    return state ? state->dispatchTime : 0;
+}
+
 }
@@ -31,6 +31,14 @@ class Display;
 class KWAYLANDSERVER_EXPORT ClientConnection : public QObject
 {
     Q_OBJECT
+    /**
+     * The number of requests received from this client.
+     */
+    Q_PROPERTY(quint64 requestCount READ requestCount)
+    /**
+     * The time in nanoseconds spent handling the requests of this client.
+     */
+    Q_PROPERTY(qint64 dispatchTime READ dispatchTime)
 public:
     virtual ~ClientConnection();
 
@@ -92,6 +100,26 @@ public:
      */
     QString executablePath() const;
 
+    /**
+     * Whether the last flush could not write all events because the client does not read
+     * from its socket. Pending events get written once the socket becomes writable.
+     *
+     * @see Display::clientBackloggedChanged
+     */
+    bool isBacklogged() const;
+
+    /**
+     * @returns the number of requests received from this client
+     * @see Display::setClientDispatchBudget
+     */
+    quint64 requestCount() const;
+    /**
+     * @returns the time in nanoseconds spent handling the requests of this client. Only
+     * requests dispatched through Display::dispatchEvents are taken into account.
+     * @see Display::setClientDispatchBudget
+     */
+    qint64 dispatchTime() const;
+
     /**
      * Cast operator the native wl_client this ClientConnection represents.
      */
@@ -30,6 +30,11 @@ public:
     QPointer<DataControlSourceV1Interface> selection;
     QPointer<DataControlSourceV1Interface> primarySelection;
     QPointer<DataControlSourceV1Interface> cachedSelection;
+    // the selection generations of the seat the client holds offers for, 0 if unknown
+    quint32 selectionGeneration = 0;
+    quint32 primarySelectionGeneration = 0;
+    QPointer<DataControlOfferV1Interface> selectionOffer;
+    QPointer<DataControlOfferV1Interface> primarySelectionOffer;
 
 protected:
     void zwlr_data_control_device_v1_destroy_resource(Resource *resource) override;
@@ -168,7 +173,9 @@ void DataControlDeviceV1Interface::sendSelection(AbstractDataSource *other)
         sendClearSelection();
         return;
     }
+    d->selectionGeneration = 0;
     DataControlOfferV1Interface *offer = d->createDataOffer(other);
+    d->selectionOffer = offer;
     if (!offer) {
         return;
     }
@@ -177,6 +184,8 @@ void DataControlDeviceV1Interface::sendSelection(AbstractDataSource *other)
 
 void DataControlDeviceV1Interface::sendClearSelection()
 {
+    d->selectionGeneration = 0;
+    d->selectionOffer = nullptr;
     d->send_selection(nullptr);
 }
 
@@ -186,7 +195,9 @@ void DataControlDeviceV1Interface::sendPrimarySelection(KWaylandServer::Abstract
         sendClearPrimarySelection();
         return;
     }
+    d->primarySelectionGeneration = 0;
     DataControlOfferV1Interface *offer = d->createDataOffer(other);
+    d->primarySelectionOffer = offer;
     if (!offer) {
         return;
     }
@@ -195,7 +206,27 @@ void DataControlDeviceV1Interface::sendPrimarySelection(KWaylandServer::Abstract
 
 void DataControlDeviceV1Interface::sendClearPrimarySelection()
 {
+    d->primarySelectionGeneration = 0;
+    d->primarySelectionOffer = nullptr;
     d->send_primary_selection(nullptr);
 }
 
+void DataControlDeviceV1Interface::updateSelection(AbstractDataSource *source, quint32 generation)
+{
+    if (d->selectionGeneration == generation && (!source || d->selectionOffer)) {
+        return;
+    }
+    sendSelection(source);
+    d->selectionGeneration = generation;
+}
+
+void DataControlDeviceV1Interface::updatePrimarySelection(AbstractDataSource *source, quint32 generation)
+{
+    if (d->primarySelectionGeneration == generation && (!source || d->primarySelectionOffer)) {
+        return;
+    }
+    sendPrimarySelection(source);
+    d->primarySelectionGeneration = generation;
+}
+
 }
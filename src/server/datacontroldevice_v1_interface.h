@@ -54,7 +54,14 @@ Q_SIGNALS:
 
 private:
     friend class DataControlDeviceManagerV1InterfacePrivate;
+    friend class SeatInterfacePrivate;
     explicit DataControlDeviceV1Interface(SeatInterface *seat, wl_resource *resource);
+    /**
+     * Sends @p source as the (primary) selection unless this device still holds the offer of
+     * the selection @p generation of the seat.
+     */
+    void updateSelection(AbstractDataSource *source, quint32 generation);
+    void updatePrimarySelection(AbstractDataSource *source, quint32 generation);
 
     QScopedPointer<DataControlDeviceV1InterfacePrivate> d;
 };
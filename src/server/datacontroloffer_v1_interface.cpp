@@ -6,6 +6,8 @@
 #include "datacontroloffer_v1_interface.h"
 #include "datacontroldevice_v1_interface.h"
 #include "datacontrolsource_v1_interface.h"
+#include "datasourcemimetypes_p.h"
+#include "selectioncache_p.h"
 // Qt
 #include <QPointer>
 #include <QStringList>
@@ -55,7 +57,7 @@ void DataControlOfferV1InterfacePrivate::zwlr_data_control_offer_v1_receive(Reso
         close(fd);
         return;
     }
-    source->requestData(mimeType, fd);
+    SelectionCache::requestData(source, mimeType, fd);
 }
 
 DataControlOfferV1Interface::DataControlOfferV1Interface(AbstractDataSource *source, wl_resource *resource)
@@ -73,8 +75,8 @@ DataControlOfferV1Interface::~DataControlOfferV1Interface() = default;
 void DataControlOfferV1Interface::sendAllOffers()
 {
     Q_ASSERT(d->source);
-    for (const QString &mimeType : d->source->mimeTypes()) {
-        d->send_offer(mimeType);
+    for (const QByteArray &mimeType : DataSourceMimeTypes::get(d->source)->encoded()) {
+        zwlr_data_control_offer_v1_send_offer(d->resource()->handle, mimeType.constData());
     }
 }
 
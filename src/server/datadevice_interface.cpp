@@ -17,6 +17,8 @@
 #include "surface_interface.h"
 #include "surfacerole_p.h"
 
+#include <QTimer>
+
 namespace KWaylandServer
 {
 class DragAndDropIconPrivate : public SurfaceRole
@@ -71,6 +73,40 @@ DataDeviceInterfacePrivate::DataDeviceInterfacePrivate(SeatInterface *seat, Data
 {
 }
 
+void DataDeviceInterfacePrivate::sendMotion(const QPointF &pos)
+{
+    drag.motion = pos;
+    drag.motionPending = true;
+    const int interval = SeatInterfacePrivate::get(seat)->dragMotionInterval;
+    if (interval <= 0 || !drag.lastMotion.isValid() || drag.lastMotion.elapsed() >= interval) {
+        flushMotion();
+        return;
+    }
+    if (!motionTimer) {
+        motionTimer = new QTimer(q);
+        motionTimer->setSingleShot(true);
+        QObject::connect(motionTimer, &QTimer::timeout, q, [this] {
+            flushMotion();
+        });
+    }
+    if (!motionTimer->isActive()) {
+        motionTimer->start(interval - drag.lastMotion.elapsed());
+    }
+}
+
+void DataDeviceInterfacePrivate::flushMotion()
+{
+    if (motionTimer) {
+        motionTimer->stop();
+    }
+    if (!drag.motionPending || !drag.surface) {
+        return;
+    }
+    drag.motionPending = false;
+    drag.lastMotion.start();
+    send_motion(seat->timestamp(), wl_fixed_from_double(drag.motion.x()), wl_fixed_from_double(drag.motion.y()));
+}
+
 void DataDeviceInterfacePrivate::data_device_start_drag(Resource *resource,
                                                         wl_resource *sourceResource,
                                                         wl_resource *originResource,
@@ -188,7 +224,9 @@ DataSourceInterface *DataDeviceInterface::selection() const
 
 void DataDeviceInterface::sendSelection(AbstractDataSource *other)
 {
+    d->selectionGeneration = 0;
     auto r = d->createDataOffer(other);
+    d->selectionOffer = r;
     if (!r) {
         return;
     }
@@ -197,11 +235,28 @@ void DataDeviceInterface::sendSelection(AbstractDataSource *other)
 
 void DataDeviceInterface::sendClearSelection()
 {
+    d->selectionGeneration = 0;
+    d->selectionOffer = nullptr;
     d->send_selection(nullptr);
 }
 
+void DataDeviceInterface::updateSelection(AbstractDataSource *source, quint32 generation)
+{
+    if (d->selectionGeneration == generation && (!source || d->selectionOffer)) {
+        return;
+    }
+    if (source) {
+        sendSelection(source);
+    } else {
+        sendClearSelection();
+    }
+    d->selectionGeneration = generation;
+}
+
 void DataDeviceInterface::drop()
 {
+    // the target has to know where the drop happens
+    d->flushMotion();
     d->send_drop();
     if (d->drag.posConnection) {
         disconnect(d->drag.posConnection);
@@ -225,6 +280,8 @@ void DataDeviceInterface::updateDragTarget(SurfaceInterface *surface, quint32 se
         disconnect(d->drag.destroyConnection);
         d->drag.destroyConnection = QMetaObject::Connection();
         d->drag.surface = nullptr;
+        d->drag.motionPending = false;
+        d->drag.lastMotion.invalidate();
         if (d->drag.sourceActionConnection) {
             disconnect(d->drag.sourceActionConnection);
             d->drag.sourceActionConnection = QMetaObject::Connection();
@@ -250,8 +307,7 @@ void DataDeviceInterface::updateDragTarget(SurfaceInterface *surface, quint32 se
     d->drag.surface = surface;
     if (d->seat->isDragPointer()) {
         d->drag.posConnection = connect(d->seat, &SeatInterface::pointerPosChanged, this, [this] {
-            const QPointF pos = d->seat->dragSurfaceTransformation().map(d->seat->pointerPos());
-            d->send_motion(d->seat->timestamp(), wl_fixed_from_double(pos.x()), wl_fixed_from_double(pos.y()));
+            d->sendMotion(d->seat->dragSurfaceTransformation().map(d->seat->pointerPos()));
         });
     } else if (d->seat->isDragTouch()) {
         d->drag.posConnection = connect(d->seat, &SeatInterface::touchMoved, this, [this](qint32 id, quint32 serial, const QPointF &globalPosition) {
@@ -260,8 +316,7 @@ void DataDeviceInterface::updateDragTarget(SurfaceInterface *surface, quint32 se
                 // different touch down has been moved
                 return;
             }
-            const QPointF pos = d->seat->dragSurfaceTransformation().map(globalPosition);
-            d->send_motion(d->seat->timestamp(), wl_fixed_from_double(pos.x()), wl_fixed_from_double(pos.y()));
+            d->sendMotion(d->seat->dragSurfaceTransformation().map(globalPosition));
         });
     }
     d->drag.destroyConnection = connect(d->drag.surface, &QObject::destroyed, this, [this] {
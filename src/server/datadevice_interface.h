@@ -107,7 +107,14 @@ Q_SIGNALS:
 
 private:
     friend class DataDeviceManagerInterfacePrivate;
+    friend class SeatInterfacePrivate;
     explicit DataDeviceInterface(SeatInterface *seat, wl_resource *resource);
+    /**
+     * Sends @p source as the selection unless this device still holds the offer of the
+     * selection @p generation of the seat.
+     */
+    void updateSelection(AbstractDataSource *source, quint32 generation);
+
     QScopedPointer<DataDeviceInterfacePrivate> d;
     friend class DataDeviceInterfacePrivate;
 };
@@ -7,10 +7,13 @@
 
 #pragma once
 
+#include <QElapsedTimer>
 #include <QPointer>
 
 #include "qwayland-server-wayland.h"
 
+class QTimer;
+
 namespace KWaylandServer
 {
 class AbstractDataSource;
@@ -29,10 +32,18 @@ public:
     DataDeviceInterfacePrivate(SeatInterface *seat, DataDeviceInterface *_q, wl_resource *resource);
 
     DataOfferInterface *createDataOffer(AbstractDataSource *source);
+    /**
+     * Sends a drag motion to @p pos, coalesced according to the drag motion interval of the seat.
+     */
+    void sendMotion(const QPointF &pos);
+    void flushMotion();
 
     SeatInterface *seat;
     DataDeviceInterface *q;
     QPointer<DataSourceInterface> selection;
+    // the selection generation of the seat the client holds an offer for, 0 if unknown
+    quint32 selectionGeneration = 0;
+    QPointer<DataOfferInterface> selectionOffer;
     QPointer<SurfaceInterface> proxyRemoteSurface;
 
     struct Drag {
@@ -42,8 +53,13 @@ public:
         QMetaObject::Connection sourceActionConnection;
         QMetaObject::Connection targetActionConnection;
         quint32 serial = 0;
+        // the latest position not sent yet
+        QPointF motion;
+        bool motionPending = false;
+        QElapsedTimer lastMotion;
     };
     Drag drag;
+    QTimer *motionTimer = nullptr;
 
 protected:
     void data_device_destroy_resource(Resource *resource) override;
@@ -7,6 +7,8 @@
 #include "dataoffer_interface.h"
 #include "datadevice_interface.h"
 #include "datasource_interface.h"
+#include "datasourcemimetypes_p.h"
+#include "selectioncache_p.h"
 
 // Qt
 #include <QPointer>
@@ -62,7 +64,7 @@ void DataOfferInterfacePrivate::data_offer_receive(Resource *resource, const QSt
         close(fd);
         return;
     }
-    source->requestData(mime_type, fd);
+    SelectionCache::requestData(source, mime_type, fd);
 }
 
 void DataOfferInterfacePrivate::data_offer_destroy(QtWaylandServer::wl_data_offer::Resource *resource)
@@ -168,8 +170,8 @@ DataOfferInterface::~DataOfferInterface() = default;
 
 void DataOfferInterface::sendAllOffers()
 {
-    for (const QString &mimeType : d->source->mimeTypes()) {
-        d->send_offer(mimeType);
+    for (const QByteArray &mimeType : DataSourceMimeTypes::get(d->source)->encoded()) {
+        wl_data_offer_send_offer(d->resource()->handle, mimeType.constData());
     }
 }
 
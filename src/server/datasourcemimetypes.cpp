@@ -0,0 +1,45 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include "datasourcemimetypes_p.h"
+#include "abstract_data_source.h"
+
+namespace KWaylandServer
+{
+DataSourceMimeTypes::DataSourceMimeTypes(AbstractDataSource *source)
+    : QObject(source)
+{
+    const QStringList mimeTypes = source->mimeTypes();
+    m_encoded.reserve(mimeTypes.count());
+    for (const QString &mimeType : mimeTypes) {
+        add(mimeType);
+    }
+    connect(source, &AbstractDataSource::mimeTypeOffered, this, &DataSourceMimeTypes::add);
+}
+
+DataSourceMimeTypes *DataSourceMimeTypes::get(AbstractDataSource *source)
+{
+    DataSourceMimeTypes *mimeTypes = source->findChild<DataSourceMimeTypes *>(QString(), Qt::FindDirectChildrenOnly);
+    if (!mimeTypes) {
+        mimeTypes = new DataSourceMimeTypes(source);
+    }
+    return mimeTypes;
+}
+
+void DataSourceMimeTypes::invalidate(AbstractDataSource *source)
+{
+    delete source->findChild<DataSourceMimeTypes *>(QString(), Qt::FindDirectChildrenOnly);
+}
+
+void DataSourceMimeTypes::add(const QString &mimeType)
+{
+    QByteArray encoded = mimeType.toUtf8();
+    if (m_set.contains(encoded)) {
+        return;
+    }
+    m_set.insert(encoded);
+    m_encoded << encoded;
+}
+
+}
@@ -0,0 +1,51 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include <QByteArray>
+#include <QObject>
+#include <QSet>
+#include <QVector>
+
+namespace KWaylandServer
+{
+class AbstractDataSource;
+
+/**
+ * The mime types of an AbstractDataSource, encoded once and shared by all offers created for
+ * the source instead of converting its mimeTypes() for each offer. It lives as a child of the
+ * source and follows mime types offered later on.
+ */
+class DataSourceMimeTypes : public QObject
+{
+    Q_OBJECT
+public:
+    static DataSourceMimeTypes *get(AbstractDataSource *source);
+    /**
+     * Drops the encoded mime types of @p source, e.g. after it withdrew one.
+     */
+    static void invalidate(AbstractDataSource *source);
+
+    /**
+     * The mime types as UTF-8 in the order they were offered.
+     */
+    const QVector<QByteArray> &encoded() const
+    {
+        return m_encoded;
+    }
+    bool contains(const QByteArray &mimeType) const
+    {
+        return m_set.contains(mimeType);
+    }
+
+private:
+    explicit DataSourceMimeTypes(AbstractDataSource *source);
+    void add(const QString &mimeType);
+
+    QVector<QByteArray> m_encoded;
+    QSet<QByteArray> m_set;
+};
+
+}
@@ -0,0 +1,369 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include "datatransfersource.h"
+#include "datasourcemimetypes_p.h"
+#include "display.h"
+#include "logging.h"
+#include "utils/sigpipeblocker.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+
+#include <wayland-server-core.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace KWaylandServer
+{
+// the bytes written to one receiver per event loop iteration, so that a fast
+// receiver does not starve the other clients
+static const qint64 s_writeBudget = 4 * 1024 * 1024;
+
+class DataTransferSourcePrivate
+{
+public:
+    struct Payload {
+        QByteArray data;
+        // -1 unless the content is read from a file
+        int fd = -1;
+        DataTransferSource::Producer producer;
+    };
+
+    DataTransferSourcePrivate(Display *display);
+    ~DataTransferSourcePrivate();
+
+    void releasePayload(const QString &mimeType);
+    void offer(const QString &mimeType, const Payload &payload);
+
+    DataTransferSource *q;
+    Display *display;
+    QStringList mimeTypes;
+    QHash<QString, Payload> payloads;
+    QList<DataTransfer *> transfers;
+};
+
+class DataTransferPrivate
+{
+public:
+    DataTransferPrivate(DataTransfer *q, DataTransferSource *source);
+    ~DataTransferPrivate();
+
+    void start(int receiverFd);
+    void write();
+    void finish(DataTransfer::State newState);
+    void release();
+
+    static int writableCallback(int fd, uint32_t mask, void *data);
+
+    DataTransfer *q;
+    DataTransferSource *source;
+    QString mimeType;
+    DataTransfer::State state = DataTransfer::State::Running;
+    QByteArray data;
+    // -1 unless the content is read from a file
+    int fileFd = -1;
+    int fd = -1;
+    qint64 size = 0;
+    qint64 bytesWritten = 0;
+    wl_event_source *eventSource = nullptr;
+    QElapsedTimer timer;
+    qint64 duration = 0;
+};
+
+DataTransferPrivate::DataTransferPrivate(DataTransfer *q, DataTransferSource *source)
+    : q(q)
+    , source(source)
+{
+}
+
+DataTransferPrivate::~DataTransferPrivate()
+{
+    release();
+}
+
+void DataTransferPrivate::release()
+{
+    if (eventSource) {
+        wl_event_source_remove(eventSource);
+        eventSource = nullptr;
+    }
+    if (fd != -1) {
+        close(fd);
+        fd = -1;
+    }
+    if (fileFd != -1) {
+        close(fileFd);
+        fileFd = -1;
+    }
+    data.clear();
+}
+
+void DataTransferPrivate::start(int receiverFd)
+{
+    fd = receiverFd;
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    timer.start();
+    write();
+}
+
+void DataTransferPrivate::write()
+{
+    SigPipeBlocker blocker;
+    const qint64 previouslyWritten = bytesWritten;
+    while (bytesWritten < size && bytesWritten - previouslyWritten < s_writeBudget) {
+        const size_t count = qMin(size - bytesWritten, s_writeBudget);
+        ssize_t written;
+        if (fileFd != -1) {
+            off_t offset = bytesWritten;
+            written = sendfile(fd, fileFd, &offset, count);
+        } else {
+            written = ::write(fd, data.constData() + bytesWritten, count);
+        }
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written < 0 && errno == EAGAIN) {
+            break;
+        }
+        if (written <= 0) {
+            finish(DataTransfer::State::Failed);
+            return;
+        }
+        bytesWritten += written;
+    }
+
+    if (bytesWritten != previouslyWritten) {
+        Q_EMIT q->progress(bytesWritten, size);
+    }
+    if (bytesWritten == size) {
+        finish(DataTransfer::State::Finished);
+        return;
+    }
+    if (!eventSource) {
+        wl_event_loop *loop = wl_display_get_event_loop(*source->d->display);
+        eventSource = wl_event_loop_add_fd(loop, fd, WL_EVENT_WRITABLE, writableCallback, this);
+    }
+}
+
+int DataTransferPrivate::writableCallback(int fd, uint32_t mask, void *data)
+{
+    Q_UNUSED(fd)
+    auto transfer = static_cast<DataTransferPrivate *>(data);
+    if (mask & (WL_EVENT_HANGUP | WL_EVENT_ERROR)) {
+        transfer->finish(DataTransfer::State::Failed);
+    } else {
+        transfer->write();
+    }
+    return 0;
+}
+
+void DataTransferPrivate::finish(DataTransfer::State newState)
+{
+    if (state != DataTransfer::State::Running) {
+        return;
+    }
+    release();
+    state = newState;
+    duration = timer.nsecsElapsed();
+    if (state == DataTransfer::State::Failed) {
+        qCDebug(KWAYLAND_SERVER) << "Data transfer of" << mimeType << "failed after" << bytesWritten << "of" << size << "bytes";
+    }
+    source->d->transfers.removeOne(q);
+    Q_EMIT q->finished();
+    q->deleteLater();
+}
+
+DataTransfer::DataTransfer(DataTransferSource *source)
+    : QObject(source)
+    , d(new DataTransferPrivate(this, source))
+{
+}
+
+DataTransfer::~DataTransfer() = default;
+
+QString DataTransfer::mimeType() const
+{
+    return d->mimeType;
+}
+
+DataTransfer::State DataTransfer::state() const
+{
+    return d->state;
+}
+
+qint64 DataTransfer::size() const
+{
+    return d->size;
+}
+
+qint64 DataTransfer::bytesWritten() const
+{
+    return d->bytesWritten;
+}
+
+qint64 DataTransfer::elapsed() const
+{
+    return d->state == State::Running ? d->timer.nsecsElapsed() : d->duration;
+}
+
+qint64 DataTransfer::throughput() const
+{
+    const qint64 time = elapsed();
+    if (time <= 0) {
+        return 0;
+    }
+    return qint64(double(d->bytesWritten) * 1000000000.0 / double(time));
+}
+
+void DataTransfer::cancel()
+{
+    d->finish(State::Cancelled);
+}
+
+DataTransferSourcePrivate::DataTransferSourcePrivate(Display *display)
+    : display(display)
+{
+}
+
+DataTransferSourcePrivate::~DataTransferSourcePrivate()
+{
+    for (const Payload &payload : qAsConst(payloads)) {
+        if (payload.fd != -1) {
+            close(payload.fd);
+        }
+    }
+}
+
+void DataTransferSourcePrivate::releasePayload(const QString &mimeType)
+{
+    auto it = payloads.find(mimeType);
+    if (it == payloads.end()) {
+        return;
+    }
+    if (it->fd != -1) {
+        close(it->fd);
+    }
+    payloads.erase(it);
+}
+
+void DataTransferSourcePrivate::offer(const QString &mimeType, const Payload &payload)
+{
+    releasePayload(mimeType);
+    payloads.insert(mimeType, payload);
+    if (!mimeTypes.contains(mimeType)) {
+        mimeTypes << mimeType;
+        Q_EMIT q->mimeTypeOffered(mimeType);
+    }
+}
+
+DataTransferSource::DataTransferSource(Display *display, QObject *parent)
+    : AbstractDataSource(parent)
+    , d(new DataTransferSourcePrivate(display))
+{
+    d->q = this;
+}
+
+DataTransferSource::~DataTransferSource()
+{
+    Q_EMIT aboutToBeDestroyed();
+    const QList<DataTransfer *> transfers = d->transfers;
+    d->transfers.clear();
+    qDeleteAll(transfers);
+}
+
+void DataTransferSource::setData(const QString &mimeType, const QByteArray &data)
+{
+    DataTransferSourcePrivate::Payload payload;
+    payload.data = data;
+    d->offer(mimeType, payload);
+}
+
+void DataTransferSource::setFileData(const QString &mimeType, int fd)
+{
+    DataTransferSourcePrivate::Payload payload;
+    payload.fd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    if (payload.fd == -1) {
+        qCWarning(KWAYLAND_SERVER) << "Could not duplicate the file descriptor for" << mimeType;
+        return;
+    }
+    d->offer(mimeType, payload);
+}
+
+void DataTransferSource::setProducer(const QString &mimeType, const Producer &producer)
+{
+    DataTransferSourcePrivate::Payload payload;
+    payload.producer = producer;
+    d->offer(mimeType, payload);
+}
+
+void DataTransferSource::removeMimeType(const QString &mimeType)
+{
+    d->releasePayload(mimeType);
+    if (d->mimeTypes.removeOne(mimeType)) {
+        DataSourceMimeTypes::invalidate(this);
+    }
+}
+
+QList<DataTransfer *> DataTransferSource::transfers() const
+{
+    return d->transfers;
+}
+
+void DataTransferSource::cancelTransfers()
+{
+    const QList<DataTransfer *> transfers = d->transfers;
+    for (DataTransfer *transfer : transfers) {
+        transfer->cancel();
+    }
+}
+
+void DataTransferSource::requestData(const QString &mimeType, qint32 fd)
+{
+    auto it = d->payloads.find(mimeType);
+    if (it == d->payloads.end()) {
+        close(fd);
+        return;
+    }
+    if (it->producer) {
+        it->data = it->producer(mimeType);
+        it->producer = nullptr;
+    }
+
+    DataTransfer *transfer = new DataTransfer(this);
+    transfer->d->mimeType = mimeType;
+    if (it->fd != -1) {
+        struct stat info;
+        transfer->d->fileFd = fcntl(it->fd, F_DUPFD_CLOEXEC, 0);
+        if (transfer->d->fileFd == -1 || fstat(transfer->d->fileFd, &info) != 0) {
+            qCWarning(KWAYLAND_SERVER) << "Could not access the file providing" << mimeType;
+            delete transfer;
+            close(fd);
+            return;
+        }
+        transfer->d->size = info.st_size;
+    } else {
+        transfer->d->data = it->data;
+        transfer->d->size = it->data.size();
+    }
+    d->transfers << transfer;
+    Q_EMIT transferStarted(transfer);
+    transfer->d->start(fd);
+}
+
+void DataTransferSource::cancel()
+{
+    Q_EMIT cancelled();
+}
+
+QStringList DataTransferSource::mimeTypes() const
+{
+    return d->mimeTypes;
+}
+
+}
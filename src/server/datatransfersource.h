@@ -0,0 +1,173 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include "abstract_data_source.h"
+
+#include <QObject>
+#include <QScopedPointer>
+
+#include <DWayland/Server/kwaylandserver_export.h>
+
+#include <functional>
+
+namespace KWaylandServer
+{
+class DataTransferPrivate;
+class DataTransferSource;
+class DataTransferSourcePrivate;
+class Display;
+
+/**
+ * @brief A single transfer of a DataTransferSource to a receiving file descriptor.
+ *
+ * The content is written with non-blocking writes whenever the receiver is ready, driven by
+ * the event loop of the Display. The DataTransfer deletes itself once it is finished.
+ *
+ * @see DataTransferSource::transferStarted
+ * @since 5.24
+ */
+class KWAYLANDSERVER_EXPORT DataTransfer : public QObject
+{
+    Q_OBJECT
+public:
+    enum class State {
+        /**
+         * The content is being written.
+         */
+        Running,
+        /**
+         * All of the content got written.
+         */
+        Finished,
+        /**
+         * The transfer got cancelled before all of the content was written.
+         */
+        Cancelled,
+        /**
+         * Writing failed, e.g. because the receiver closed its end.
+         */
+        Failed,
+    };
+    Q_ENUM(State)
+
+    ~DataTransfer() override;
+
+    QString mimeType() const;
+    State state() const;
+    /**
+     * @returns The size in bytes of the content to transfer.
+     */
+    qint64 size() const;
+    /**
+     * @returns The number of bytes written to the receiver so far.
+     */
+    qint64 bytesWritten() const;
+    /**
+     * @returns The time in nanoseconds since the transfer started, or its duration once
+     * it's not Running anymore.
+     */
+    qint64 elapsed() const;
+    /**
+     * @returns The average throughput of the transfer in bytes per second.
+     */
+    qint64 throughput() const;
+
+    /**
+     * Stops writing and closes the receiving file descriptor.
+     */
+    void cancel();
+
+Q_SIGNALS:
+    /**
+     * Emitted after content got written to the receiver.
+     */
+    void progress(qint64 bytesWritten, qint64 size);
+    /**
+     * Emitted once the transfer is not Running anymore, check state for the outcome.
+     */
+    void finished();
+
+private:
+    explicit DataTransfer(DataTransferSource *source);
+    friend class DataTransferSource;
+    friend class DataTransferPrivate;
+    QScopedPointer<DataTransferPrivate> d;
+};
+
+/**
+ * @brief An AbstractDataSource for data provided by the compositor itself.
+ *
+ * The content of each mime type can be provided as a QByteArray, a file descriptor, e.g. a
+ * memfd, or a producer which is invoked the first time the content is requested. Requests
+ * are served asynchronously with non-blocking writes driven by the Display's event loop,
+ * so slow receivers never block the compositor. The source has to be destroyed before the
+ * Display.
+ *
+ * @code
+ * auto source = new DataTransferSource(display);
+ * source->setData(QStringLiteral("text/plain"), text.toUtf8());
+ * seat->setSelection(source);
+ * @endcode
+ *
+ * @since 5.24
+ */
+class KWAYLANDSERVER_EXPORT DataTransferSource : public AbstractDataSource
+{
+    Q_OBJECT
+public:
+    using Producer = std::function<QByteArray(const QString &mimeType)>;
+
+    explicit DataTransferSource(Display *display, QObject *parent = nullptr);
+    ~DataTransferSource() override;
+
+    /**
+     * Offers @p mimeType with the content @p data.
+     */
+    void setData(const QString &mimeType, const QByteArray &data);
+    /**
+     * Offers @p mimeType with the content of the file @p fd, e.g. a memfd. The file
+     * descriptor is duplicated, the content is read from the start on each request.
+     */
+    void setFileData(const QString &mimeType, int fd);
+    /**
+     * Offers @p mimeType with content created by @p producer when it's requested the
+     * first time.
+     */
+    void setProducer(const QString &mimeType, const Producer &producer);
+    /**
+     * Withdraws @p mimeType. Transfers in progress are not affected.
+     */
+    void removeMimeType(const QString &mimeType);
+
+    /**
+     * @returns The transfers in progress.
+     */
+    QList<DataTransfer *> transfers() const;
+    /**
+     * Cancels all transfers in progress.
+     */
+    void cancelTransfers();
+
+    void requestData(const QString &mimeType, qint32 fd) override;
+    void cancel() override;
+    QStringList mimeTypes() const override;
+
+Q_SIGNALS:
+    /**
+     * Emitted when a receiver requested the content of a mime type.
+     */
+    void transferStarted(KWaylandServer::DataTransfer *transfer);
+    /**
+     * Emitted when this source is not the selection anymore.
+     */
+    void cancelled();
+
+private:
+    friend class DataTransferPrivate;
+    QScopedPointer<DataTransferSourcePrivate> d;
+};
+
+}
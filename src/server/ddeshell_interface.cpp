@@ -7,6 +7,7 @@
 #include "display.h"
 #include "logging.h"
 #include "surface_interface.h"
+#include "surfaceproperties_p.h"
 #include "utils.h"
 
 #include "qwayland-server-dde-shell.h"
@@ -40,10 +41,21 @@ public:
 
     void setState(dde_shell_state flag, bool set);
     void sendGeometry(const QRect &geom);
+    void beginStateChange();
+    void commitStateChange();
 
 private:
+    void scheduleFlush();
+    void flush();
+
+    // what the client knows about
     quint32 m_state = 0;
     QRect m_geometry;
+    // changes are merged until the end of the event loop iteration or the outermost commitStateChange
+    quint32 m_pendingState = 0;
+    QRect m_pendingGeometry;
+    int m_stateChangeDepth = 0;
+    bool m_flushScheduled = false;
 
     void dde_shell_surface_destroy_resource(Resource *resource) override;
 
@@ -130,29 +142,60 @@ DDEShellSurfaceInterface *DDEShellSurfaceInterface::get(SurfaceInterface *surfac
 
 void DDEShellSurfaceInterfacePrivate::setState(dde_shell_state flag, bool set)
 {
-    quint32 newState = m_state;
     if (set) {
-        newState |= flag;
+        m_pendingState |= flag;
     } else {
-        newState &= ~flag;
-    }
-    if (newState == m_state) {
-        return;
+        m_pendingState &= ~flag;
     }
-    m_state = newState;
-    send_state_changed(m_state);
+    scheduleFlush();
 }
 
 void DDEShellSurfaceInterfacePrivate::sendGeometry(const QRect &geometry)
 {
-    if (m_geometry == geometry) {
-        return;
+    m_pendingGeometry = geometry;
+    scheduleFlush();
+}
+
+void DDEShellSurfaceInterfacePrivate::beginStateChange()
+{
+    ++m_stateChangeDepth;
+}
+
+void DDEShellSurfaceInterfacePrivate::commitStateChange()
+{
+    Q_ASSERT(m_stateChangeDepth > 0);
+    if (--m_stateChangeDepth == 0) {
+        flush();
     }
-    m_geometry = geometry;
-    if (!m_geometry.isValid()) {
+}
+
+void DDEShellSurfaceInterfacePrivate::scheduleFlush()
+{
+    if (m_stateChangeDepth > 0 || m_flushScheduled) {
         return;
     }
-    send_geometry(m_geometry.x(), m_geometry.y(), m_geometry.width(), m_geometry.height());
+    m_flushScheduled = true;
+    QMetaObject::invokeMethod(
+        q,
+        [this] {
+            flush();
+        },
+        Qt::QueuedConnection);
+}
+
+void DDEShellSurfaceInterfacePrivate::flush()
+{
+    m_flushScheduled = false;
+    if (m_pendingState != m_state) {
+        m_state = m_pendingState;
+        send_state_changed(m_state);
+    }
+    if (m_pendingGeometry != m_geometry) {
+        m_geometry = m_pendingGeometry;
+        if (m_geometry.isValid()) {
+            send_geometry(m_geometry.x(), m_geometry.y(), m_geometry.width(), m_geometry.height());
+        }
+    }
 }
 
 DDEShellSurfaceInterfacePrivate::DDEShellSurfaceInterfacePrivate(DDEShellSurfaceInterface *_q, SurfaceInterface *_surface, wl_resource *resource)
@@ -229,17 +272,33 @@ void DDEShellSurfaceInterfacePrivate::dde_shell_surface_set_state(Resource *reso
 void DDEShellSurfaceInterfacePrivate::dde_shell_surface_set_property(Resource *resource, uint32_t property, wl_array *dataArr)
 {
     Q_UNUSED(resource)
+    auto properties = SurfacePropertiesPrivate::get(surface);
     if (property & DDE_SHELL_PROPERTY_NOTITLEBAR) {
+        if (dataArr->size < sizeof(int)) {
+            qCWarning(KWAYLAND_SERVER) << "Ignoring truncated noTitleBar property";
+            return;
+        }
         int *value = static_cast<int *>(dataArr->data);
+        properties->setNoTitleBar(*value);
         Q_EMIT q->noTitleBarPropertyRequested(*value);
     }
     if (property & DDE_SHELL_PROPERTY_WINDOWRADIUS) {
+        if (dataArr->size < 2 * sizeof(float)) {
+            qCWarning(KWAYLAND_SERVER) << "Ignoring truncated windowRadius property";
+            return;
+        }
         float *value = static_cast<float *>(dataArr->data);
         QPointF pnt = QPointF(value[0],value[1]);
+        properties->setWindowRadius(pnt);
         Q_EMIT q->windowRadiusPropertyRequested(pnt);
     }
     if (property & DDE_SHELL_PROPERTY_QUICKTILE) {
+        if (dataArr->size < 2 * sizeof(int)) {
+            qCWarning(KWAYLAND_SERVER) << "Ignoring truncated splitWindow property";
+            return;
+        }
         int *value = static_cast<int *>(dataArr->data);
+        properties->setSplitWindow((SplitType)value[0], value[1]);
         Q_EMIT q->splitWindowRequested((SplitType)value[0], value[1]);
     }
 }
@@ -324,8 +383,19 @@ void DDEShellSurfaceInterface::sendGeometry(const QRect &geom)
     d->sendGeometry(geom);
 }
 
+void DDEShellSurfaceInterface::beginStateChange()
+{
+    d->beginStateChange();
+}
+
+void DDEShellSurfaceInterface::commitStateChange()
+{
+    d->commitStateChange();
+}
+
 void DDEShellSurfaceInterface::sendSplitable(int splitable)
 {
+    // the flags are sent together as one state change
     if (splitable == 0) {
         d->setState(DDE_SHELL_STATE_NO_SPLIT, true);
         d->setState(DDE_SHELL_STATE_TWO_SPLIT, false);
@@ -69,6 +69,22 @@ public:
     void sendGeometry(const QRect &geom);
     void sendSplitable(int splitable);
 
+    /**
+     * State and geometry changes are not sent right away but merged into at most one state
+     * change and one geometry event when control returns to the event loop.
+     *
+     * Changes made between beginStateChange and the matching commitStateChange are sent by
+     * the commit instead. The calls can be nested, the outermost commit sends the changes.
+     * @since 5.24
+     */
+    void beginStateChange();
+    /**
+     * Sends the changes made since beginStateChange.
+     * @see beginStateChange
+     * @since 5.24
+     */
+    void commitStateChange();
+
     void setActive(bool set);
     void setMinimized(bool set);
     void setMaximized(bool set);
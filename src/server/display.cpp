@@ -16,6 +16,10 @@
 #include <QCoreApplication>
 #include <QDebug>
 #include <QRect>
+#include <QTimer>
+
+#include <algorithm>
+#include <errno.h>
 
 namespace KWaylandServer
 {
@@ -35,17 +39,228 @@ void DisplayPrivate::registerSocketName(const QString &socketName)
     Q_EMIT q->socketNamesChanged();
 }
 
+void DisplayPrivate::clientCreatedCallback(wl_listener *listener, void *data)
+{
+    DisplayPrivate *displayPrivate = static_cast<ClientCreatedListener *>(listener)->display;
+    wl_client *client = static_cast<wl_client *>(data);
+
+    ClientState *state = new ClientState;
+    state->notify = clientDestroyedCallback;
+    state->display = displayPrivate;
+    state->client = client;
+    wl_client_add_destroy_listener(client, state);
+}
+
+void DisplayPrivate::clientDestroyedCallback(wl_listener *listener, void *data)
+{
+    Q_UNUSED(data)
+    ClientState *state = static_cast<ClientState *>(listener);
+    wl_list_remove(&state->link);
+    if (state->dirty) {
+        // don't shift the dirty list, it might be flushed right now
+        QVector<ClientState *> &dirtyClients = state->display->dirtyClients;
+        dirtyClients[dirtyClients.indexOf(state)] = nullptr;
+    }
+    if (state->writeNotifier) {
+        state->writeNotifier->setEnabled(false);
+        state->writeNotifier->deleteLater();
+    }
+    if (state->active) {
+        QVector<ClientState *> &activeClients = state->display->activeClients;
+        activeClients[activeClients.indexOf(state)] = nullptr;
+    }
+    if (state->display->dispatchingClient == state) {
+        state->display->dispatchingClient = nullptr;
+    }
+    delete state;
+}
+
+void DisplayPrivate::protocolLoggerCallback(void *data, wl_protocol_logger_type type, const wl_protocol_logger_message *message)
+{
+    DisplayPrivate *displayPrivate = static_cast<DisplayPrivate *>(data);
+    // no state means the client is being destroyed, there is nothing left to flush or account
+    ClientState *state = displayPrivate->clientState(wl_resource_get_client(message->resource));
+    if (!state) {
+        return;
+    }
+    if (type == WL_PROTOCOL_LOGGER_EVENT) {
+        displayPrivate->markClientDirty(state);
+    } else {
+        displayPrivate->accountRequest(state);
+    }
+}
+
+void DisplayPrivate::accountRequest(ClientState *state)
+{
+    state->requestCount++;
+    if (!dispatchTimer.isValid()) {
+        // dispatched outside of Display::dispatchEvents, only count
+        return;
+    }
+
+    // requests are logged right before they get invoked, the time since the previous
+    // request was spent in the request of the client dispatched before
+    const qint64 now = dispatchTimer.nsecsElapsed();
+    if (dispatchingClient) {
+        dispatchingClient->cycleTime += now - lastRequestTime;
+    }
+    lastRequestTime = now;
+    dispatchingClient = state;
+
+    state->cycleRequests++;
+    if (!state->active) {
+        state->active = true;
+        activeClients.append(state);
+    }
+}
+
+void DisplayPrivate::finishDispatchCycle()
+{
+    if (dispatchingClient) {
+        dispatchingClient->cycleTime += dispatchTimer.nsecsElapsed() - lastRequestTime;
+        dispatchingClient = nullptr;
+    }
+    dispatchTimer.invalidate();
+
+    bool overBudget = false;
+    // signal handlers might destroy clients, which nulls their entries
+    for (int i = 0; i < activeClients.count(); ++i) {
+        ClientState *state = activeClients[i];
+        if (!state) {
+            continue;
+        }
+        const quint32 requests = state->cycleRequests;
+        const qint64 time = state->cycleTime;
+        state->dispatchTime += time;
+        state->cycleRequests = 0;
+        state->cycleTime = 0;
+        state->active = false;
+        activeClients[i] = nullptr;
+
+        if ((clientRequestBudget && requests > clientRequestBudget) || (clientTimeBudget && time > clientTimeBudget)) {
+            overBudget = true;
+            Q_EMIT q->clientOverBudget(q->getConnection(state->client), requests, time);
+        }
+    }
+    activeClients.clear();
+
+    if (overBudget && deferOverBudgetClients && socketNotifier) {
+        // let the rest of the application run before reading more requests
+        socketNotifier->setEnabled(false);
+        QTimer::singleShot(0, q, [this]() {
+            if (socketNotifier) {
+                socketNotifier->setEnabled(true);
+            }
+        });
+    }
+}
+
+ClientState *DisplayPrivate::clientState(wl_client *client) const
+{
+    return static_cast<ClientState *>(wl_client_get_destroy_listener(client, clientDestroyedCallback));
+}
+
+void DisplayPrivate::markClientDirty(ClientState *state)
+{
+    // backlogged clients get flushed as soon as their socket becomes writable again
+    if (state->dirty || state->backlogged) {
+        return;
+    }
+    state->dirty = true;
+    dirtyClients.append(state);
+}
+
+void DisplayPrivate::markFrameRendered(wl_client *client, const QVector<OutputInterface *> &outputs)
+{
+    ClientState *state = clientState(client);
+    if (!state) {
+        return;
+    }
+    for (OutputInterface *output : outputs) {
+        if (!state->frameOutputs.contains(output)) {
+            state->frameOutputs.append(output);
+        }
+    }
+}
+
+bool DisplayPrivate::flushClient(ClientState *state)
+{
+    // wl_client_flush doesn't report errors, but leaves errno of the failed sendmsg
+    errno = 0;
+    wl_client_flush(state->client);
+    const bool backlogged = errno == EAGAIN;
+    setClientBacklogged(state, backlogged);
+    return !backlogged;
+}
+
+void DisplayPrivate::flushDirtyClients(OutputInterface *output)
+{
+    int remaining = 0;
+    for (int i = 0; i < dirtyClients.count(); ++i) {
+        ClientState *state = dirtyClients[i];
+        if (!state) {
+            continue;
+        }
+        if (output && !state->frameOutputs.contains(output)) {
+            dirtyClients[remaining++] = state;
+            continue;
+        }
+        state->dirty = false;
+        state->frameOutputs.clear();
+        flushClient(state);
+    }
+    dirtyClients.resize(remaining);
+}
+
+void DisplayPrivate::setClientBacklogged(ClientState *state, bool backlogged)
+{
+    if (state->backlogged == backlogged) {
+        return;
+    }
+    state->backlogged = backlogged;
+    if (!state->writeNotifier) {
+        state->writeNotifier = new QSocketNotifier(wl_client_get_fd(state->client), QSocketNotifier::Write);
+        QObject::connect(state->writeNotifier, &QSocketNotifier::activated, q, [this, state]() {
+            flushClient(state);
+        });
+    }
+    state->writeNotifier->setEnabled(backlogged);
+    Q_EMIT q->clientBackloggedChanged(q->getConnection(state->client), backlogged);
+}
+
 Display::Display(QObject *parent)
     : QObject(parent)
     , d(new DisplayPrivate(this))
 {
     d->display = wl_display_create();
     d->loop = wl_display_get_event_loop(d->display);
+
+    d->clientCreatedListener.notify = DisplayPrivate::clientCreatedCallback;
+    d->clientCreatedListener.display = d.data();
+    wl_display_add_client_created_listener(d->display, &d->clientCreatedListener);
+    d->protocolLogger = wl_display_add_protocol_logger(d->display, DisplayPrivate::protocolLoggerCallback, d.data());
 }
 
 Display::~Display()
 {
+    if (d->eventLoopThread) {
+        // tear down the clients in the thread which dispatches them
+        QMetaObject::invokeMethod(
+            this,
+            [this]() {
+                delete d->socketNotifier;
+                d->socketNotifier = nullptr;
+                disconnect(d->aboutToBlockConnection);
+                wl_display_destroy_clients(d->display);
+            },
+            Qt::BlockingQueuedConnection);
+        d->eventLoopThread->quit();
+        d->eventLoopThread->wait();
+        delete d->eventLoopThread;
+        d->eventLoopThread = nullptr;
+    }
     wl_display_destroy_clients(d->display);
+    wl_protocol_logger_destroy(d->protocolLogger);
     wl_display_destroy(d->display);
 }
 
@@ -100,8 +315,8 @@ bool Display::start()
     d->socketNotifier = new QSocketNotifier(fileDescriptor, QSocketNotifier::Read, this);
     connect(d->socketNotifier, &QSocketNotifier::activated, this, &Display::dispatchEvents);
 
-    QAbstractEventDispatcher *dispatcher = QCoreApplication::eventDispatcher();
-    connect(dispatcher, &QAbstractEventDispatcher::aboutToBlock, this, &Display::flush);
+    QAbstractEventDispatcher *dispatcher = QAbstractEventDispatcher::instance(thread());
+    d->aboutToBlockConnection = connect(dispatcher, &QAbstractEventDispatcher::aboutToBlock, this, &Display::flush);
 
     d->running = true;
     Q_EMIT runningChanged(true);
@@ -109,16 +324,93 @@ bool Display::start()
     return true;
 }
 
+bool Display::startThreaded()
+{
+    if (d->running) {
+        return d->eventLoopThread;
+    }
+    if (parent()) {
+        qCWarning(KWAYLAND_SERVER) << "A Display with a parent cannot be moved to a dedicated thread";
+        return false;
+    }
+
+    d->eventLoopThread = new QThread();
+    d->eventLoopThread->setObjectName(QStringLiteral("WaylandServer"));
+    moveToThread(d->eventLoopThread);
+    d->eventLoopThread->start();
+
+    QThread *callerThread = QThread::currentThread();
+    bool started = false;
+    QMetaObject::invokeMethod(
+        this,
+        [this, callerThread]() {
+            if (start()) {
+                return true;
+            }
+            moveToThread(callerThread);
+            return false;
+        },
+        Qt::BlockingQueuedConnection,
+        &started);
+    if (!started) {
+        d->eventLoopThread->quit();
+        d->eventLoopThread->wait();
+        delete d->eventLoopThread;
+        d->eventLoopThread = nullptr;
+    }
+    return started;
+}
+
+bool Display::isThreaded() const
+{
+    return d->eventLoopThread;
+}
+
 void Display::dispatchEvents()
 {
+    d->dispatchTimer.start();
+    d->lastRequestTime = 0;
     if (wl_event_loop_dispatch(d->loop, 0) != 0) {
         qCWarning(KWAYLAND_SERVER) << "Error on dispatching Wayland event loop";
     }
+    d->finishDispatchCycle();
+}
+
+void Display::setClientDispatchBudget(quint32 maxRequests, qint64 maxTime)
+{
+    d->clientRequestBudget = maxRequests;
+    d->clientTimeBudget = maxTime;
+}
+
+quint32 Display::clientRequestBudget() const
+{
+    return d->clientRequestBudget;
+}
+
+qint64 Display::clientTimeBudget() const
+{
+    return d->clientTimeBudget;
+}
+
+void Display::setDeferOverBudgetClients(bool defer)
+{
+    d->deferOverBudgetClients = defer;
+}
+
+bool Display::deferOverBudgetClients() const
+{
+    return d->deferOverBudgetClients;
 }
 
 void Display::flush()
 {
-    wl_display_flush_clients(d->display);
+    d->flushDirtyClients();
+}
+
+void Display::flushFrame(OutputInterface *output)
+{
+    Q_ASSERT(output);
+    d->flushDirtyClients(output);
 }
 
 void Display::createShm()
@@ -165,13 +457,21 @@ QList< OutputDeviceV2Interface* > Display::outputDevices() const
 QVector<OutputInterface *> Display::outputsIntersecting(const QRect &rect) const
 {
     QVector<OutputInterface *> outputs;
-    for (auto *output : qAsConst(d->outputs)) {
-        const QRect outputGeometry(output->globalPosition(), output->pixelSize() / output->scale());
-        if (rect.intersects(outputGeometry)) {
-            outputs << output;
+    outputsIntersecting(rect, &outputs);
+    return outputs;
+}
+
+void Display::outputsIntersecting(const QRect &rect, QVector<OutputInterface *> *outputs) const
+{
+    outputs->clear();
+    if (!rect.intersects(d->outputsBoundingRect)) {
+        return;
+    }
+    for (const DisplayPrivate::OutputGeometry &entry : qAsConst(d->outputLayout)) {
+        if (rect.intersects(entry.geometry)) {
+            outputs->append(entry.output);
         }
     }
-    return outputs;
 }
 
 QVector<SeatInterface *> Display::seats() const
@@ -182,15 +482,27 @@ QVector<SeatInterface *> Display::seats() const
 ClientConnection *Display::getConnection(wl_client *client)
 {
     Q_ASSERT(client);
-    auto it = std::find_if(d->clients.constBegin(), d->clients.constEnd(), [client](ClientConnection *c) {
-        return c->client() == client;
-    });
-    if (it != d->clients.constEnd()) {
-        return *it;
+    ClientState *state = d->clientState(client);
+    if (state) {
+        if (state->connection) {
+            return state->connection;
+        }
+    } else {
+        // the wl_client is being destroyed, its state is already gone
+        auto it = std::find_if(d->clients.constBegin(), d->clients.constEnd(), [client](ClientConnection *c) {
+            return c->client() == client;
+        });
+        if (it != d->clients.constEnd()) {
+            return *it;
+        }
     }
     // no ConnectionData yet, create it
     auto c = new ClientConnection(client, this);
     d->clients << c;
+    if (state) {
+        // the state is destroyed before the ClientConnection, no need to reset it
+        state->connection = c;
+    }
     connect(c, &ClientConnection::disconnected, this, [this](ClientConnection *c) {
         const int index = d->clients.indexOf(c);
         Q_ASSERT(index != -1);
@@ -284,6 +596,60 @@ ClientBuffer *Display::clientBufferForResource(wl_resource *resource) const
     return nullptr;
 }
 
+static QRect outputGeometry(OutputInterface *output)
+{
+    return QRect(output->globalPosition(), output->pixelSize() / output->scale());
+}
+
+void DisplayPrivate::registerOutput(OutputInterface *output)
+{
+    outputs.append(output);
+    outputLayout.append({output, outputGeometry(output)});
+    outputsBoundingRect |= outputLayout.last().geometry;
+
+    QObject::connect(output, &OutputInterface::globalPositionChanged, q, [this, output] {
+        updateOutputGeometry(output);
+    });
+    QObject::connect(output, &OutputInterface::modeChanged, q, [this, output] {
+        updateOutputGeometry(output);
+    });
+    QObject::connect(output, &OutputInterface::scaleChanged, q, [this, output] {
+        updateOutputGeometry(output);
+    });
+}
+
+void DisplayPrivate::unregisterOutput(OutputInterface *output)
+{
+    outputs.removeOne(output);
+    auto it = std::find_if(outputLayout.begin(), outputLayout.end(), [output](const OutputGeometry &entry) {
+        return entry.output == output;
+    });
+    if (it == outputLayout.end()) {
+        return;
+    }
+    outputLayout.erase(it);
+    outputsBoundingRect = QRect();
+    for (const OutputGeometry &entry : qAsConst(outputLayout)) {
+        outputsBoundingRect |= entry.geometry;
+    }
+}
+
+void DisplayPrivate::updateOutputGeometry(OutputInterface *output)
+{
+    auto it = std::find_if(outputLayout.begin(), outputLayout.end(), [output](const OutputGeometry &entry) {
+        return entry.output == output;
+    });
+    if (it == outputLayout.end()) {
+        // the output got removed already
+        return;
+    }
+    it->geometry = outputGeometry(output);
+    outputsBoundingRect = QRect();
+    for (const OutputGeometry &entry : qAsConst(outputLayout)) {
+        outputsBoundingRect |= entry.geometry;
+    }
+}
+
 void DisplayPrivate::registerClientBuffer(ClientBuffer *buffer)
 {
     resourceToBuffer.insert(buffer->resource(), buffer);
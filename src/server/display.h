@@ -88,8 +88,55 @@ public:
      * function returns @c true; otherwise @c false is returned.
      */
     bool start();
+    /**
+     * Starts the display like start(), but dispatches the Wayland event loop in a dedicated
+     * thread, so that request handling doesn't compete with rendering in the compositor's
+     * main thread. The Display and all its children are moved to that thread. This function
+     * returns @c false if the display could not be started or if it has a parent, which
+     * prevents moving it to another thread.
+     *
+     * All globals should be created before calling this method. Afterwards the Display and
+     * the objects it manages may only be used from the event loop thread. Signals connected
+     * with the default Qt::AutoConnection are delivered queued to receivers in other threads.
+     * State that has to be observed from another thread in a consistent way, like surface
+     * commits, is handed over through lock-free mailboxes, see SurfaceInterface::commitMailbox.
+     *
+     * The Display must be destroyed from the thread that called this method.
+     *
+     * @see isThreaded
+     */
+    bool startThreaded();
+    /**
+     * @returns @c true if the Wayland event loop is dispatched in a dedicated thread.
+     * @see startThreaded
+     */
+    bool isThreaded() const;
     void dispatchEvents();
 
+    /**
+     * Sets the budget a single client may use within one dispatch of the event loop. A client
+     * which sends more than @p maxRequests requests or whose requests take longer than
+     * @p maxTime nanoseconds to be handled causes the clientOverBudget signal to be emitted.
+     * Passing @c 0 disables the respective limit, which is the default.
+     *
+     * @see setDeferOverBudgetClients
+     * @see ClientConnection::requestCount
+     * @see ClientConnection::dispatchTime
+     */
+    void setClientDispatchBudget(quint32 maxRequests, qint64 maxTime);
+    quint32 clientRequestBudget() const;
+    qint64 clientTimeBudget() const;
+    /**
+     * Sets whether reading further requests is postponed to the next iteration of the Qt
+     * event loop once a client exceeded its dispatch budget, so that a client flooding the
+     * compositor with requests can't starve timers and rendering. Default is @c false.
+     *
+     * The wl_event_loop does not allow to suspend single clients, so all clients get
+     * postponed together.
+     */
+    void setDeferOverBudgetClients(bool defer);
+    bool deferOverBudgetClients() const;
+
     /**
      * Create a client for the given file descriptor.
      *
@@ -115,6 +162,14 @@ public:
     QList<OutputDeviceV2Interface *> outputDevices() const;
     QList<OutputInterface *> outputs() const;
     QVector<OutputInterface *> outputsIntersecting(const QRect &rect) const;
+    /**
+     * Replaces the content of @p outputs with the outputs intersecting @p rect. The vector keeps
+     * its capacity, so reusing it for repeated queries, e.g. while a window is moved, does not
+     * allocate memory.
+     *
+     * @since 5.24
+     */
+    void outputsIntersecting(const QRect &rect, QVector<OutputInterface *> *outputs) const;
 
     /**
      * Gets the ClientConnection for the given @p client.
@@ -146,6 +201,18 @@ public:
      */
     ClientBuffer *clientBufferForResource(wl_resource *resource) const;
 
+    /**
+     * Flushes the clients which received frame callbacks for surfaces on the given @p output
+     * since they got flushed last. The compositor should call this method once it has called
+     * SurfaceInterface::frameRendered for all surfaces on the @p output, so that the frame
+     * callbacks reach the clients without waiting for the event loop to go idle.
+     *
+     * All other clients with pending events are flushed when the event loop is about to block.
+     *
+     * @see SurfaceInterface::frameRendered
+     */
+    void flushFrame(OutputInterface *output);
+
 private Q_SLOTS:
     void flush();
 
@@ -154,6 +221,21 @@ Q_SIGNALS:
     void runningChanged(bool);
     void clientConnected(KWaylandServer::ClientConnection *);
     void clientDisconnected(KWaylandServer::ClientConnection *);
+    /**
+     * This signal is emitted when flushing the @p client failed because its socket is full
+     * and when the pending events got written later on. A backlogged client is not flushed
+     * together with the other clients, it gets flushed once its socket becomes writable.
+     *
+     * @see ClientConnection::isBacklogged
+     */
+    void clientBackloggedChanged(KWaylandServer::ClientConnection *client, bool backlogged);
+    /**
+     * This signal is emitted after a dispatch of the event loop in which the @p client sent
+     * @p requests requests taking @p time nanoseconds, exceeding the configured budget.
+     *
+     * @see setClientDispatchBudget
+     */
+    void clientOverBudget(KWaylandServer::ClientConnection *client, quint32 requests, qint64 time);
 
 private:
     friend class DisplayPrivate;
@@ -9,10 +9,13 @@
 
 #include <wayland-server-core.h>
 
+#include <QElapsedTimer>
 #include <QHash>
 #include <QList>
+#include <QRect>
 #include <QSocketNotifier>
 #include <QString>
+#include <QThread>
 #include <QVector>
 
 #include <EGL/egl.h>
@@ -29,6 +32,28 @@ class OutputInterface;
 class OutputDeviceV2Interface;
 class SeatInterface;
 struct ClientBufferDestroyListener;
+class DisplayPrivate;
+
+/**
+ * Per-client bookkeeping of the Display. Unlike ClientConnection it exists for every
+ * wl_client from its creation on and is destroyed together with the wl_client.
+ */
+struct ClientState : wl_listener {
+    DisplayPrivate *display;
+    wl_client *client;
+    ClientConnection *connection = nullptr;
+    // flush scheduling
+    bool dirty = false;
+    bool backlogged = false;
+    QVector<OutputInterface *> frameOutputs;
+    QSocketNotifier *writeNotifier = nullptr;
+    // request accounting, totals and the dispatch cycle in progress
+    quint64 requestCount = 0;
+    qint64 dispatchTime = 0;
+    quint32 cycleRequests = 0;
+    qint64 cycleTime = 0;
+    bool active = false;
+};
 
 class DisplayPrivate
 {
@@ -38,15 +63,41 @@ public:
 
     void registerSocketName(const QString &socketName);
 
+    void registerOutput(OutputInterface *output);
+    void unregisterOutput(OutputInterface *output);
+    void updateOutputGeometry(OutputInterface *output);
+
     void registerClientBuffer(ClientBuffer *clientBuffer);
     void unregisterClientBuffer(ClientBuffer *clientBuffer);
 
+    ClientState *clientState(wl_client *client) const;
+    void markClientDirty(ClientState *state);
+    void markFrameRendered(wl_client *client, const QVector<OutputInterface *> &outputs);
+    bool flushClient(ClientState *state);
+    void flushDirtyClients(OutputInterface *output = nullptr);
+    void setClientBacklogged(ClientState *state, bool backlogged);
+    void accountRequest(ClientState *state);
+    void finishDispatchCycle();
+
+    static void clientCreatedCallback(wl_listener *listener, void *data);
+    static void clientDestroyedCallback(wl_listener *listener, void *data);
+    static void protocolLoggerCallback(void *data, wl_protocol_logger_type type, const wl_protocol_logger_message *message);
+
     Display *q;
     QSocketNotifier *socketNotifier = nullptr;
+    QMetaObject::Connection aboutToBlockConnection;
+    QThread *eventLoopThread = nullptr;
     wl_display *display = nullptr;
     wl_event_loop *loop = nullptr;
     bool running = false;
     QList<OutputInterface *> outputs;
+    // the logical geometry of each output in the order of outputs, kept up to date on changes
+    struct OutputGeometry {
+        OutputInterface *output;
+        QRect geometry;
+    };
+    QVector<OutputGeometry> outputLayout;
+    QRect outputsBoundingRect;
     QList<OutputDeviceV2Interface *> outputdevicesV2;
     QVector<SeatInterface *> seats;
     QVector<ClientConnection *> clients;
@@ -55,6 +106,18 @@ public:
     QHash<::wl_resource *, ClientBuffer *> resourceToBuffer;
     QHash<ClientBuffer *, ClientBufferDestroyListener *> bufferToListener;
     QList<ClientBufferIntegration *> bufferIntegrations;
+    struct ClientCreatedListener : wl_listener {
+        DisplayPrivate *display;
+    } clientCreatedListener;
+    wl_protocol_logger *protocolLogger = nullptr;
+    QVector<ClientState *> dirtyClients;
+    QVector<ClientState *> activeClients;
+    ClientState *dispatchingClient = nullptr;
+    QElapsedTimer dispatchTimer;
+    qint64 lastRequestTime = 0;
+    quint32 clientRequestBudget = 0;
+    qint64 clientTimeBudget = 0;
+    bool deferOverBudgetClients = false;
 };
 
 } // namespace KWaylandServer
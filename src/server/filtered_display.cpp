@@ -9,22 +9,58 @@
 
 #include <wayland-server.h>
 
+#include <QAtomicInteger>
 #include <QByteArray>
+#include <QHash>
+#include <QVector>
+
+#include <algorithm>
 
 namespace KWaylandServer
 {
+/**
+ * The decisions of allowInterface for one client, indexed by the interned interface.
+ * It's destroyed together with the wl_client.
+ */
+struct FilterCache : wl_listener {
+    quint32 generation = 0;
+    // -1 for not decided yet
+    QVector<qint8> decisions;
+};
+
 class FilteredDisplayPrivate
 {
 public:
     FilteredDisplayPrivate(FilteredDisplay *_q);
     FilteredDisplay *q;
+    // interface names are interned by their static wl_interface
+    QHash<const wl_interface *, int> interfaceIndexes;
+    QVector<QByteArray> interfaceNames;
+    // bumped by invalidateFilter, which may be called from any thread
+    QAtomicInteger<quint32> generation;
+
+    int internInterface(const wl_interface *interface);
+    FilterCache *cache(wl_client *client, int interfaceIndex);
+
+    static void clientDestroyedCallback(wl_listener *listener, void *data)
+    {
+        Q_UNUSED(data)
+        FilterCache *cache = static_cast<FilterCache *>(listener);
+        wl_list_remove(&cache->link);
+        delete cache;
+    }
+
     static bool globalFilterCallback(const wl_client *client, const wl_global *global, void *data)
     {
         auto t = static_cast<FilteredDisplayPrivate *>(data);
-        auto clientConnection = t->q->getConnection(const_cast<wl_client *>(client));
-        auto interface = wl_global_get_interface(global);
-        auto name = QByteArray::fromRawData(interface->name, strlen(interface->name));
-        return t->q->allowInterface(clientConnection, name);
+        const int index = t->internInterface(wl_global_get_interface(global));
+        FilterCache *cache = t->cache(const_cast<wl_client *>(client), index);
+        qint8 &decision = cache->decisions[index];
+        if (decision == -1) {
+            auto clientConnection = t->q->getConnection(const_cast<wl_client *>(client));
+            decision = t->q->allowInterface(clientConnection, t->interfaceNames.at(index)) ? 1 : 0;
+        }
+        return decision;
     };
 };
 
@@ -33,6 +69,39 @@ FilteredDisplayPrivate::FilteredDisplayPrivate(FilteredDisplay *_q)
 {
 }
 
+int FilteredDisplayPrivate::internInterface(const wl_interface *interface)
+{
+    auto it = interfaceIndexes.constFind(interface);
+    if (it != interfaceIndexes.constEnd()) {
+        return *it;
+    }
+    const int index = interfaceNames.count();
+    interfaceNames << QByteArray::fromRawData(interface->name, strlen(interface->name));
+    interfaceIndexes.insert(interface, index);
+    return index;
+}
+
+FilterCache *FilteredDisplayPrivate::cache(wl_client *client, int interfaceIndex)
+{
+    const quint32 currentGeneration = generation.loadAcquire();
+    FilterCache *cache = static_cast<FilterCache *>(wl_client_get_destroy_listener(client, clientDestroyedCallback));
+    if (!cache) {
+        cache = new FilterCache;
+        cache->notify = clientDestroyedCallback;
+        cache->generation = currentGeneration;
+        wl_client_add_destroy_listener(client, cache);
+    } else if (cache->generation != currentGeneration) {
+        cache->generation = currentGeneration;
+        cache->decisions.fill(-1);
+    }
+    const int decidedCount = cache->decisions.count();
+    if (decidedCount <= interfaceIndex) {
+        cache->decisions.resize(interfaceNames.count());
+        std::fill(cache->decisions.begin() + decidedCount, cache->decisions.end(), -1);
+    }
+    return cache;
+}
+
 FilteredDisplay::FilteredDisplay(QObject *parent)
     : Display(parent)
     , d(new FilteredDisplayPrivate(this))
@@ -49,4 +118,9 @@ FilteredDisplay::~FilteredDisplay()
 {
 }
 
+void FilteredDisplay::invalidateFilter()
+{
+    d->generation.fetchAndAddOrdered(1);
+}
+
 }
@@ -18,6 +18,7 @@ class FilteredDisplayPrivate;
  * Server Implementation that allows one to restrict which globals are available to which clients
  *
  * Users of this class must implement the virtual @method allowInterface method.
+ * Its result is cached, see @method invalidateFilter.
  */
 class KWAYLANDSERVER_EXPORT FilteredDisplay : public Display
 {
@@ -36,6 +37,18 @@ public:
      */
     virtual bool allowInterface(ClientConnection *client, const QByteArray &interfaceName) = 0;
 
+    /**
+     * The result of allowInterface is cached per client and interface. Call this method
+     * whenever the policy implemented in allowInterface changed, so that it gets asked
+     * again for all clients and interfaces.
+     *
+     * Globals which were already announced to a client are not withdrawn. This method
+     * may also be called from another thread than the one running a threaded display.
+     *
+     * @since 5.24
+     */
+    void invalidateFilter();
+
 private:
     QScopedPointer<FilteredDisplayPrivate> d;
 };
@@ -4,25 +4,63 @@
 
 #include "globalproperty_interface.h"
 #include "display.h"
+#include "logging.h"
 #include "surface_interface_p.h"
+#include "surfaceproperties_p.h"
 
+#include <QDataStream>
+#include <QHash>
 #include <QJsonObject>
 #include <QJsonDocument>
 #include <QJsonParseError>
+#include <QVector>
 
 #include "qwayland-server-dde-globalproperty.h"
 
 namespace KWaylandServer
 {
 static const quint32 s_version = 1;
+
+/**
+ * The records of the binary encoding, each starting with the operation as quint8 followed by
+ * the key id as quint16, all little endian:
+ * - DefineKey: quint16 length, UTF-8 name; registers the name for the id with this client
+ * - Bool: quint8
+ * - Int: qint32
+ * - Double: IEEE 754 double
+ * - String: quint32 length, UTF-8 text
+ * - Remove: no value
+ * - Int64: qint64
+ * - UInt64: quint64
+ *
+ * The base64 encoded records are prefixed with s_binaryMagic, which can't start JSON.
+ */
+enum class PropertyRecord : quint8 {
+    DefineKey = 0,
+    Bool = 1,
+    Int = 2,
+    Double = 3,
+    String = 4,
+    Remove = 5,
+    Int64 = 6,
+    UInt64 = 7,
+};
+
+static const QLatin1String s_binaryMagic("dwpb:");
+
 class GlobalPropertyInterfacePrivate : public QtWaylandServer::dde_globalproperty
 {
 public:
     GlobalPropertyInterfacePrivate(GlobalPropertyInterface *q, Display *display);
 
+    bool decodeBinary(Resource *resource, const QByteArray &data, QVariantMap *changes);
+
     GlobalPropertyInterface *q;
+    // the key names registered by each client for the binary encoding
+    QHash<Resource *, QVector<QString>> keyTables;
 
 private:
+    void dde_globalproperty_destroy_resource(Resource *resource) override;
     void dde_globalproperty_set_property(Resource *resource, const QString &module, const QString &function, struct ::wl_resource *surface, int32_t type, const QString &data) override;
     void dde_globalproperty_get_property(Resource *resource, const QString &data) override;
 };
@@ -34,32 +72,143 @@ GlobalPropertyInterfacePrivate::GlobalPropertyInterfacePrivate(GlobalPropertyInt
 
 }
 
+bool GlobalPropertyInterfacePrivate::decodeBinary(Resource *resource, const QByteArray &data, QVariantMap *changes)
+{
+    QVector<QString> &keys = keyTables[resource];
+    QDataStream stream(data);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    while (!stream.atEnd()) {
+        quint8 operation;
+        quint16 id;
+        stream >> operation >> id;
+        if (stream.status() != QDataStream::Ok) {
+            return false;
+        }
+
+        if (PropertyRecord(operation) == PropertyRecord::DefineKey) {
+            quint16 length;
+            stream >> length;
+            QByteArray name(length, Qt::Uninitialized);
+            if (stream.readRawData(name.data(), length) != length) {
+                return false;
+            }
+            if (keys.size() <= id) {
+                keys.resize(id + 1);
+            }
+            keys[id] = QString::fromUtf8(name);
+            continue;
+        }
+
+        if (id >= keys.size() || keys[id].isNull()) {
+            return false;
+        }
+        const QString &key = keys[id];
+        switch (PropertyRecord(operation)) {
+        case PropertyRecord::Bool: {
+            quint8 value;
+            stream >> value;
+            changes->insert(key, bool(value));
+            break;
+        }
+        case PropertyRecord::Int: {
+            qint32 value;
+            stream >> value;
+            changes->insert(key, value);
+            break;
+        }
+        case PropertyRecord::Int64: {
+            qint64 value;
+            stream >> value;
+            changes->insert(key, value);
+            break;
+        }
+        case PropertyRecord::UInt64: {
+            quint64 value;
+            stream >> value;
+            changes->insert(key, value);
+            break;
+        }
+        case PropertyRecord::Double: {
+            double value;
+            stream >> value;
+            changes->insert(key, value);
+            break;
+        }
+        case PropertyRecord::String: {
+            quint32 length;
+            stream >> length;
+            if (stream.status() != QDataStream::Ok || length > quint32(data.size())) {
+                return false;
+            }
+            QByteArray value(length, Qt::Uninitialized);
+            if (stream.readRawData(value.data(), length) != int(length)) {
+                return false;
+            }
+            changes->insert(key, QString::fromUtf8(value));
+            break;
+        }
+        case PropertyRecord::Remove:
+            changes->insert(key, QVariant());
+            break;
+        default:
+            return false;
+        }
+        if (stream.status() != QDataStream::Ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void GlobalPropertyInterfacePrivate::dde_globalproperty_destroy_resource(Resource *resource)
+{
+    keyTables.remove(resource);
+}
+
 void GlobalPropertyInterfacePrivate::dde_globalproperty_set_property(Resource *resource, const QString &module, const QString &function, struct ::wl_resource *surface, int32_t type, const QString &data)
 {
+    Q_UNUSED(module)
+    Q_UNUSED(function)
     SurfaceInterface *si = SurfaceInterface::get(surface);
     if (!si) {
         wl_resource_post_error(resource->handle, 0, "Invalid surface");
         return;
     }
 
-    QJsonParseError error;
-    const auto doc = QJsonDocument::fromJson(data.toUtf8(), &error);
-    if (error.error != QJsonParseError::NoError) {
-        qDebug() << "Failed to parse data" << error.errorString();
-        return;
+    QVariantMap ret;
+    // older clients sent JSON regardless of the type
+    if (type == int32_t(GlobalPropertyInterface::Encoding::Binary) && data.startsWith(s_binaryMagic)) {
+        if (!decodeBinary(resource, QByteArray::fromBase64(data.midRef(s_binaryMagic.size()).toLatin1()), &ret)) {
+            qCWarning(KWAYLAND_SERVER) << "Failed to decode binary window properties";
+            return;
+        }
+    } else {
+        QJsonParseError error;
+        const auto doc = QJsonDocument::fromJson(data.toUtf8(), &error);
+        if (error.error != QJsonParseError::NoError) {
+            qDebug() << "Failed to parse data" << error.errorString();
+            return;
+        }
+        ret = doc.object().toVariantMap();
     }
-    QMap<QString, QVariant> ret;
-    const QJsonObject rootObj = doc.object();
-    for (const auto &key : rootObj.keys()) {
-        const QVariant &value = rootObj[key].toVariant();
-        ret[key] = value;
+
+    SurfacePropertiesPrivate::get(si)->updateWindowDecoration(ret);
+    // removals are only reflected in the stored properties
+    for (auto it = ret.begin(); it != ret.end();) {
+        if (it.value().isValid()) {
+            ++it;
+        } else {
+            it = ret.erase(it);
+        }
     }
     emit q->windowDecoratePropertyChanged(si, ret);
 }
 
 void GlobalPropertyInterfacePrivate::dde_globalproperty_get_property(Resource *resource, const QString &data)
 {
-
+    // the protocol has no event to answer with, the compositor reads the stored properties instead
+    Q_UNUSED(resource)
+    Q_UNUSED(data)
 }
 
 GlobalPropertyInterface::GlobalPropertyInterface(Display *display, QObject *parent)
@@ -74,4 +223,14 @@ GlobalPropertyInterface::~GlobalPropertyInterface()
 
 }
 
+QVariantMap GlobalPropertyInterface::surfaceProperties(SurfaceInterface *surface) const
+{
+    return surface->properties()->windowDecoration();
+}
+
+QVariant GlobalPropertyInterface::surfaceProperty(SurfaceInterface *surface, const QString &key) const
+{
+    return surface->properties()->windowDecoration().value(key);
+}
+
 }
@@ -8,6 +8,7 @@
 #include <QObject>
 #include <QString>
 #include <QMap>
+#include <QVariant>
 
 #include <DWayland/Server/kwaylandserver_export.h>
 
@@ -31,10 +32,43 @@ class KWAYLANDSERVER_EXPORT GlobalPropertyInterface : public QObject
     Q_OBJECT
     //Q_PROPERTY(QString propertyData READ propertyData WRITE setPropertyData NOTIFY WindowDecoratePropertyChanged)
 public:
+    /**
+     * The encoding of the data of a set_property request, passed as its type.
+     * @since 5.24
+     */
+    enum class Encoding {
+        /**
+         * A JSON object.
+         */
+        Json = 0,
+        /**
+         * Base64 encoded typed records which refer to the keys by ids the client registered
+         * before, see the client side GlobalProperty::setProperties. The data is prefixed
+         * with "dwpb:", data of this type without it is parsed as JSON, as older clients
+         * did not care about the type.
+         */
+        Binary = 1,
+    };
+
     explicit GlobalPropertyInterface(Display *display, QObject *parent = nullptr);
     virtual ~GlobalPropertyInterface();
 
+    /**
+     * @returns The properties the client set for @p surface so far.
+     * @since 5.24
+     */
+    QVariantMap surfaceProperties(SurfaceInterface *surface) const;
+    /**
+     * @returns The property @p key the client set for @p surface, or an invalid QVariant.
+     * @since 5.24
+     */
+    QVariant surfaceProperty(SurfaceInterface *surface, const QString &key) const;
+
 Q_SIGNALS:
+    /**
+     * Emitted with the properties the client set for the surface. Properties the client
+     * removed are not included, SurfaceProperties::windowDecoration reflects them.
+     */
     void windowDecoratePropertyChanged(SurfaceInterface *, QMap<QString, QVariant> &) const;
 
 private:
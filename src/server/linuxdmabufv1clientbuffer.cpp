@@ -15,9 +15,10 @@
 #include "logging.h"
 #include "surface_interface_p.h"
 
-#include <QTemporaryFile>
-#include <fcntl.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 namespace KWaylandServer
@@ -31,24 +32,157 @@ LinuxDmaBufV1ClientBufferIntegrationPrivate::LinuxDmaBufV1ClientBufferIntegratio
 {
 }
 
-void LinuxDmaBufV1ClientBufferIntegrationPrivate::zwp_linux_dmabuf_v1_bind_resource(Resource *resource)
+LinuxDmaBufV1ClientBufferIntegrationPrivate::~LinuxDmaBufV1ClientBufferIntegrationPrivate()
 {
-    if (resource->version() < ZWP_LINUX_DMABUF_V1_GET_DEFAULT_FEEDBACK_SINCE_VERSION) {
-        for (auto it = supportedModifiers.constBegin(); it != supportedModifiers.constEnd(); ++it) {
-            const uint32_t format = it.key();
-            QSet<uint64_t> modifiers = it.value();
-            if (modifiers.isEmpty()) {
-                modifiers.insert(DRM_FORMAT_MOD_INVALID);
+    // surface feedbacks can outlive the integration
+    for (LinuxDmaBufV1FeedbackPrivate *feedback : qAsConst(feedbacks)) {
+        if (feedback != LinuxDmaBufV1FeedbackPrivate::get(defaultFeedback.data())) {
+            feedback->m_bufferintegration = nullptr;
+        }
+    }
+}
+
+LinuxDmaBufV1ClientBufferIntegrationPrivate *LinuxDmaBufV1ClientBufferIntegrationPrivate::get(LinuxDmaBufV1ClientBufferIntegration *q)
+{
+    return q->d.data();
+}
+
+bool operator==(const LinuxDmaBufV1ImportKey::Plane &a, const LinuxDmaBufV1ImportKey::Plane &b)
+{
+    return a.device == b.device && a.inode == b.inode && a.offset == b.offset && a.stride == b.stride && a.modifier == b.modifier;
+}
+
+bool operator==(const LinuxDmaBufV1ImportKey &a, const LinuxDmaBufV1ImportKey &b)
+{
+    return a.planes == b.planes && a.format == b.format && a.size == b.size && a.flags == b.flags;
+}
+
+uint qHash(const LinuxDmaBufV1ImportKey &key, uint seed)
+{
+    seed = qHash(key.format, seed);
+    seed = qHash(key.size.width(), seed);
+    seed = qHash(key.size.height(), seed);
+    for (const LinuxDmaBufV1ImportKey::Plane &plane : key.planes) {
+        seed = qHash(quint64(plane.device), seed);
+        seed = qHash(quint64(plane.inode), seed);
+        seed = qHash(plane.offset, seed);
+        seed = qHash(plane.stride, seed);
+        seed = qHash(plane.modifier, seed);
+    }
+    return seed;
+}
+
+bool LinuxDmaBufV1ClientBufferIntegrationPrivate::makeImportKey(const QVector<LinuxDmaBufV1Plane> &planes,
+                                                                quint32 format,
+                                                                const QSize &size,
+                                                                quint32 flags,
+                                                                LinuxDmaBufV1ImportKey *key) const
+{
+    if (!importCacheEnabled) {
+        return false;
+    }
+    *key = {{}, format, size, flags};
+    key->planes.reserve(planes.count());
+    for (const LinuxDmaBufV1Plane &plane : planes) {
+        struct stat info;
+        if (fstat(plane.fd, &info) != 0) {
+            return false;
+        }
+        key->planes.append({info.st_dev, info.st_ino, plane.offset, plane.stride, plane.modifier});
+    }
+    return true;
+}
+
+void LinuxDmaBufV1ClientBufferIntegrationPrivate::addToImportCache(const LinuxDmaBufV1ImportKey &key, LinuxDmaBufV1ClientBuffer *buffer)
+{
+    // the buffers keep the dmabufs open, so the files cannot be reused while an entry exists
+    importCache[key].append(buffer);
+    QObject::connect(buffer, &QObject::destroyed, q, [this, key, buffer] {
+        auto it = importCache.find(key);
+        if (it != importCache.end()) {
+            it->removeOne(buffer);
+            if (it->isEmpty()) {
+                importCache.erase(it);
             }
+        }
+    });
+}
+
+LinuxDmaBufV1ClientBuffer *
+LinuxDmaBufV1ClientBufferIntegrationPrivate::importBuffer(const QVector<LinuxDmaBufV1Plane> &planes, quint32 format, const QSize &size, quint32 flags)
+{
+    LinuxDmaBufV1ImportKey key;
+    if (!makeImportKey(planes, format, size, flags, &key)) {
+        return rendererInterface->importBuffer(planes, format, size, flags);
+    }
+
+    LinuxDmaBufV1ClientBuffer *buffer;
+    auto it = importCache.constFind(key);
+    if (it != importCache.constEnd()) {
+        ++importCacheHits;
+        buffer = rendererInterface->reuseImport(it->first(), planes, format, size, flags);
+    } else {
+        ++importCacheMisses;
+        buffer = rendererInterface->importBuffer(planes, format, size, flags);
+    }
+    if (buffer) {
+        addToImportCache(key, buffer);
+    }
+    return buffer;
+}
+
+static QFuture<LinuxDmaBufV1ClientBuffer *> readyFuture(LinuxDmaBufV1ClientBuffer *buffer)
+{
+    QFutureInterface<LinuxDmaBufV1ClientBuffer *> result;
+    result.reportStarted();
+    result.reportResult(buffer);
+    result.reportFinished();
+    return result.future();
+}
+
+QFuture<LinuxDmaBufV1ClientBuffer *>
+LinuxDmaBufV1ClientBufferIntegrationPrivate::importBufferAsync(const QVector<LinuxDmaBufV1Plane> &planes, quint32 format, const QSize &size, quint32 flags)
+{
+    LinuxDmaBufV1ImportKey key;
+    if (!makeImportKey(planes, format, size, flags, &key)) {
+        return rendererInterface->importBufferAsync(planes, format, size, flags);
+    }
+
+    auto it = importCache.constFind(key);
+    if (it != importCache.constEnd()) {
+        // reusing an import is cheap, no need to go through the renderer's queue
+        ++importCacheHits;
+        LinuxDmaBufV1ClientBuffer *buffer = rendererInterface->reuseImport(it->first(), planes, format, size, flags);
+        if (buffer) {
+            addToImportCache(key, buffer);
+        }
+        return readyFuture(buffer);
+    }
+
+    ++importCacheMisses;
+    const QFuture<LinuxDmaBufV1ClientBuffer *> import = rendererInterface->importBufferAsync(planes, format, size, flags);
+    auto watcher = new QFutureWatcher<LinuxDmaBufV1ClientBuffer *>(q);
+    QObject::connect(watcher, &QFutureWatcherBase::finished, q, [this, key, watcher] {
+        const QFuture<LinuxDmaBufV1ClientBuffer *> import = watcher->future();
+        if (import.resultCount() && import.result()) {
+            addToImportCache(key, import.result());
+        }
+        watcher->deleteLater();
+    });
+    watcher->setFuture(import);
+    return import;
+}
 
-            for (const uint64_t &modifier : qAsConst(modifiers)) {
-                if (resource->version() >= ZWP_LINUX_DMABUF_V1_MODIFIER_SINCE_VERSION) {
-                    const uint32_t modifier_lo = modifier & 0xffffffff;
-                    const uint32_t modifier_hi = modifier >> 32;
-                    send_modifier(resource->handle, format, modifier_hi, modifier_lo);
-                } else if (modifier == DRM_FORMAT_MOD_LINEAR || modifier == DRM_FORMAT_MOD_INVALID) {
-                    send_format(resource->handle, format);
-                }
+void LinuxDmaBufV1ClientBufferIntegrationPrivate::zwp_linux_dmabuf_v1_bind_resource(Resource *resource)
+{
+    if (resource->version() < ZWP_LINUX_DMABUF_V1_GET_DEFAULT_FEEDBACK_SINCE_VERSION) {
+        for (const auto &[format, modifier] : qAsConst(legacyFormats)) {
+            if (resource->version() >= ZWP_LINUX_DMABUF_V1_MODIFIER_SINCE_VERSION) {
+                const uint32_t modifier_lo = modifier & 0xffffffff;
+                const uint32_t modifier_hi = modifier >> 32;
+                send_modifier(resource->handle, format, modifier_hi, modifier_lo);
+            } else if (modifier == DRM_FORMAT_MOD_LINEAR || modifier == DRM_FORMAT_MOD_INVALID) {
+                send_format(resource->handle, format);
             }
         }
     }
@@ -107,6 +241,11 @@ LinuxDmaBufParamsV1::~LinuxDmaBufParamsV1()
 void LinuxDmaBufParamsV1::zwp_linux_buffer_params_v1_destroy_resource(Resource *resource)
 {
     Q_UNUSED(resource)
+    if (m_pendingImport) {
+        // deleted once the import finished, it owns the file descriptors until then
+        m_isDestroyed = true;
+        return;
+    }
     delete this;
 }
 
@@ -165,23 +304,52 @@ void LinuxDmaBufParamsV1::zwp_linux_buffer_params_v1_create(Resource *resource,
     m_isUsed = true;
     m_planes.resize(m_planeCount);
 
-    LinuxDmaBufV1ClientBuffer *clientBuffer = m_integration->rendererInterface()->importBuffer(m_planes, format, QSize(width, height), flags);
+    // the client is told about the buffer with an event, so it can be imported in the background
+    const QFuture<LinuxDmaBufV1ClientBuffer *> import =
+        LinuxDmaBufV1ClientBufferIntegrationPrivate::get(m_integration)->importBufferAsync(m_planes, format, QSize(width, height), flags);
+    if (import.isFinished()) {
+        finishCreate(import.resultCount() ? import.result() : nullptr);
+        return;
+    }
+    m_pendingImport.reset(new QFutureWatcher<LinuxDmaBufV1ClientBuffer *>());
+    QObject::connect(m_pendingImport.data(), &QFutureWatcherBase::finished, m_pendingImport.data(), [this] {
+        const QFuture<LinuxDmaBufV1ClientBuffer *> import = m_pendingImport->future();
+        // the watcher is still emitting
+        m_pendingImport.take()->deleteLater();
+        finishCreate(import.resultCount() ? import.result() : nullptr);
+        if (m_isDestroyed) {
+            delete this;
+        }
+    });
+    m_pendingImport->setFuture(import);
+}
+
+void LinuxDmaBufParamsV1::finishCreate(LinuxDmaBufV1ClientBuffer *clientBuffer)
+{
     if (!clientBuffer) {
-        send_failed(resource->handle);
+        if (!m_isDestroyed) {
+            send_failed();
+        }
         return;
     }
 
     m_planes.clear(); // the ownership of file descriptors has been moved to the buffer
 
-    wl_resource *bufferResource = wl_resource_create(resource->client(), &wl_buffer_interface, 1, 0);
+    if (m_isDestroyed) {
+        // nobody is interested in the buffer anymore
+        delete clientBuffer;
+        return;
+    }
+
+    wl_resource *bufferResource = wl_resource_create(wl_resource_get_client(resource()->handle), &wl_buffer_interface, 1, 0);
     if (!bufferResource) {
         delete clientBuffer;
-        wl_resource_post_no_memory(resource->handle);
+        wl_resource_post_no_memory(resource()->handle);
         return;
     }
 
     clientBuffer->initialize(bufferResource);
-    send_created(resource->handle, bufferResource);
+    send_created(bufferResource);
 
     DisplayPrivate *displayPrivate = DisplayPrivate::get(m_integration->display());
     displayPrivate->registerClientBuffer(clientBuffer);
@@ -206,7 +374,8 @@ void LinuxDmaBufParamsV1::zwp_linux_buffer_params_v1_create_immed(Resource *reso
     m_isUsed = true;
     m_planes.resize(m_planeCount);
 
-    LinuxDmaBufV1ClientBuffer *clientBuffer = m_integration->rendererInterface()->importBuffer(m_planes, format, QSize(width, height), flags);
+    LinuxDmaBufV1ClientBuffer *clientBuffer =
+        LinuxDmaBufV1ClientBufferIntegrationPrivate::get(m_integration)->importBuffer(m_planes, format, QSize(width, height), flags);
     if (!clientBuffer) {
         wl_resource_post_error(resource->handle, error_invalid_wl_buffer, "importing the supplied dmabufs failed");
         return;
@@ -309,6 +478,37 @@ void LinuxDmaBufV1ClientBufferIntegration::setRendererInterface(RendererInterfac
     d->rendererInterface = rendererInterface;
 }
 
+QFuture<LinuxDmaBufV1ClientBuffer *> LinuxDmaBufV1ClientBufferIntegration::RendererInterface::importBufferAsync(const QVector<LinuxDmaBufV1Plane> &planes,
+                                                                                                             quint32 format,
+                                                                                                             const QSize &size,
+                                                                                                             quint32 flags)
+{
+    return readyFuture(importBuffer(planes, format, size, flags));
+}
+
+void LinuxDmaBufV1ClientBufferIntegration::setImportCacheEnabled(bool enabled)
+{
+    d->importCacheEnabled = enabled;
+    if (!enabled) {
+        d->importCache.clear();
+    }
+}
+
+bool LinuxDmaBufV1ClientBufferIntegration::isImportCacheEnabled() const
+{
+    return d->importCacheEnabled;
+}
+
+quint64 LinuxDmaBufV1ClientBufferIntegration::importCacheHits() const
+{
+    return d->importCacheHits;
+}
+
+quint64 LinuxDmaBufV1ClientBufferIntegration::importCacheMisses() const
+{
+    return d->importCacheMisses;
+}
+
 void LinuxDmaBufV1ClientBufferIntegration::setSupportedFormatsWithModifiers(const QVector<LinuxDmaBufV1Feedback::Tranche> &tranches)
 {
     if (LinuxDmaBufV1FeedbackPrivate::get(d->defaultFeedback.data())->m_tranches != tranches) {
@@ -317,9 +517,24 @@ void LinuxDmaBufV1ClientBufferIntegration::setSupportedFormatsWithModifiers(cons
             set.insert(tranche.formatTable);
         }
         d->supportedModifiers = set;
+        d->legacyFormats.clear();
+        for (auto it = set.constBegin(); it != set.constEnd(); ++it) {
+            if (it->isEmpty()) {
+                d->legacyFormats.append({it.key(), DRM_FORMAT_MOD_INVALID});
+            }
+            for (const uint64_t &modifier : *it) {
+                d->legacyFormats.append({it.key(), modifier});
+            }
+        }
         d->mainDevice = tranches.first().device;
+        d->mainDeviceBytes = QByteArray(reinterpret_cast<const char *>(&d->mainDevice), sizeof(dev_t));
         d->table.reset(new LinuxDmaBufV1FormatTable(set));
-        d->defaultFeedback->setTranches(tranches);
+        d->tableSerial++;
+        LinuxDmaBufV1FeedbackPrivate::get(d->defaultFeedback.data())->updateTranches(tranches);
+        // the indices changed and every feedback includes the default tranches
+        for (LinuxDmaBufV1FeedbackPrivate *feedback : qAsConst(d->feedbacks)) {
+            feedback->sendToAll();
+        }
     }
 }
 
@@ -443,12 +658,8 @@ LinuxDmaBufV1Feedback::~LinuxDmaBufV1Feedback() = default;
 
 void LinuxDmaBufV1Feedback::setTranches(const QVector<Tranche> &tranches)
 {
-    if (d->m_tranches != tranches) {
-        d->m_tranches = tranches;
-        const auto &map = d->resourceMap();
-        for (const auto &resource : map) {
-            d->send(resource);
-        }
+    if (d->updateTranches(tranches)) {
+        d->sendToAll();
     }
 }
 
@@ -460,6 +671,14 @@ LinuxDmaBufV1FeedbackPrivate *LinuxDmaBufV1FeedbackPrivate::get(LinuxDmaBufV1Fee
 LinuxDmaBufV1FeedbackPrivate::LinuxDmaBufV1FeedbackPrivate(LinuxDmaBufV1ClientBufferIntegrationPrivate *bufferintegration)
     : m_bufferintegration(bufferintegration)
 {
+    m_bufferintegration->feedbacks.append(this);
+}
+
+LinuxDmaBufV1FeedbackPrivate::~LinuxDmaBufV1FeedbackPrivate()
+{
+    if (m_bufferintegration) {
+        m_bufferintegration->feedbacks.removeOne(this);
+    }
 }
 
 bool operator==(const LinuxDmaBufV1Feedback::Tranche &t1, const LinuxDmaBufV1Feedback::Tranche &t2)
@@ -467,41 +686,81 @@ bool operator==(const LinuxDmaBufV1Feedback::Tranche &t1, const LinuxDmaBufV1Fee
     return t1.device == t2.device && t1.flags == t2.flags && t1.formatTable == t2.formatTable;
 }
 
+static LinuxDmaBufV1FeedbackPrivate::EncodedTranche encodeTranche(const LinuxDmaBufV1Feedback::Tranche &tranche, const LinuxDmaBufV1FormatTable *table)
+{
+    return {
+        QByteArray(reinterpret_cast<const char *>(&tranche.device), sizeof(dev_t)),
+        table ? table->encodeIndices(tranche.formatTable) : QByteArray(),
+        static_cast<uint32_t>(tranche.flags),
+    };
+}
+
+bool LinuxDmaBufV1FeedbackPrivate::updateTranches(const QVector<LinuxDmaBufV1Feedback::Tranche> &tranches)
+{
+    if (m_tranches == tranches) {
+        return false;
+    }
+    QVector<EncodedTranche> encoded;
+    encoded.reserve(tranches.count());
+    const bool reuse = m_tableSerial == m_bufferintegration->tableSerial;
+    for (int i = 0; i < tranches.count(); ++i) {
+        // e.g. only the scanout tranche changes when a surface moves to another plane
+        const int previous = reuse ? m_tranches.indexOf(tranches[i]) : -1;
+        if (previous != -1) {
+            encoded.append(m_encodedTranches[previous]);
+        } else {
+            encoded.append(encodeTranche(tranches[i], m_bufferintegration->table.data()));
+        }
+    }
+    m_tranches = tranches;
+    m_encodedTranches = encoded;
+    m_tableSerial = m_bufferintegration->tableSerial;
+    return true;
+}
+
+const QVector<LinuxDmaBufV1FeedbackPrivate::EncodedTranche> &LinuxDmaBufV1FeedbackPrivate::encodedTranches()
+{
+    if (m_tableSerial != m_bufferintegration->tableSerial) {
+        m_encodedTranches.clear();
+        for (const auto &tranche : qAsConst(m_tranches)) {
+            m_encodedTranches.append(encodeTranche(tranche, m_bufferintegration->table.data()));
+        }
+        m_tableSerial = m_bufferintegration->tableSerial;
+    }
+    return m_encodedTranches;
+}
+
 void LinuxDmaBufV1FeedbackPrivate::send(Resource *resource)
 {
     send_format_table(resource->handle, m_bufferintegration->table->fd, m_bufferintegration->table->size);
-    QByteArray bytes;
-    bytes.append(reinterpret_cast<const char *>(&m_bufferintegration->mainDevice), sizeof(dev_t));
-    send_main_device(resource->handle, bytes);
-    const auto &sendTranche = [this, resource](const LinuxDmaBufV1Feedback::Tranche &tranche) {
-        QByteArray targetDevice;
-        targetDevice.append(reinterpret_cast<const char *>(&tranche.device), sizeof(dev_t));
-        QByteArray indices;
-        for (auto it = tranche.formatTable.begin(); it != tranche.formatTable.end(); it++) {
-            const uint32_t format = it.key();
-            for (const auto &mod : qAsConst(it.value())) {
-                uint16_t index = m_bufferintegration->table->indices[std::pair<uint32_t, uint64_t>(format, mod)];
-                indices.append(reinterpret_cast<const char *>(&index), 2);
-            }
-        }
-        send_tranche_target_device(resource->handle, targetDevice);
-        send_tranche_formats(resource->handle, indices);
-        send_tranche_flags(resource->handle, static_cast<uint32_t>(tranche.flags));
+    send_main_device(resource->handle, m_bufferintegration->mainDeviceBytes);
+    const auto &sendTranche = [this, resource](const EncodedTranche &tranche) {
+        send_tranche_target_device(resource->handle, tranche.targetDevice);
+        send_tranche_formats(resource->handle, tranche.formats);
+        send_tranche_flags(resource->handle, tranche.flags);
         send_tranche_done(resource->handle);
     };
-    for (const auto &tranche : qAsConst(m_tranches)) {
+    for (const auto &tranche : encodedTranches()) {
         sendTranche(tranche);
     }
     // send default hints as the last fallback tranche
     const auto defaultFeedbackPrivate = get(m_bufferintegration->defaultFeedback.data());
     if (this != defaultFeedbackPrivate) {
-        for (const auto &tranche : qAsConst(defaultFeedbackPrivate->m_tranches)) {
+        for (const auto &tranche : defaultFeedbackPrivate->encodedTranches()) {
             sendTranche(tranche);
         }
     }
     send_done(resource->handle);
 }
 
+void LinuxDmaBufV1FeedbackPrivate::sendToAll()
+{
+    const auto &map = resourceMap();
+    for (const auto &resource : map) {
+        send(resource);
+    }
+}
+
 void LinuxDmaBufV1FeedbackPrivate::zwp_linux_dmabuf_feedback_v1_bind_resource(Resource *resource)
 {
     send(resource);
@@ -529,27 +788,34 @@ LinuxDmaBufV1FormatTable::LinuxDmaBufV1FormatTable(const QHash<uint32_t, QSet<ui
         }
     }
     size = data.size() * sizeof(linux_dmabuf_feedback_v1_table_entry);
-    QScopedPointer<QTemporaryFile> tmp(new QTemporaryFile());
-    if (!tmp->open()) {
-        qCWarning(KWAYLAND_SERVER) << "Failed to create keymap file:" << tmp->errorString();
-        return;
-    }
-    fd = open(tmp->fileName().toUtf8().constData(), O_RDONLY | O_CLOEXEC);
+    fd = memfd_create("linux-dmabuf-feedback-format-table", MFD_CLOEXEC | MFD_ALLOW_SEALING);
     if (fd < 0) {
-        qCWarning(KWAYLAND_SERVER) << "Could not create readonly shm fd!" << strerror(errno);
+        qCWarning(KWAYLAND_SERVER) << "Failed to create format table file:" << strerror(errno);
         return;
     }
-    unlink(tmp->fileName().toUtf8().constData());
-    if (!tmp->resize(size)) {
-        qCWarning(KWAYLAND_SERVER) << "Failed to resize keymap file:" << tmp->errorString();
+    if (ftruncate(fd, size) < 0 || pwrite(fd, data.constData(), size, 0) != size) {
+        qCWarning(KWAYLAND_SERVER) << "Failed to write format table file:" << strerror(errno);
+        close(fd);
+        fd = -1;
         return;
     }
-    uchar *address = tmp->map(0, size);
-    if (!address) {
-        qCWarning(KWAYLAND_SERVER) << "Failed to map keymap file:" << tmp->errorString();
-        return;
+    // clients map the table, none of them may change it for the others
+    if (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) < 0) {
+        qCWarning(KWAYLAND_SERVER) << "Failed to seal format table file:" << strerror(errno);
+    }
+}
+
+QByteArray LinuxDmaBufV1FormatTable::encodeIndices(const QHash<uint32_t, QSet<uint64_t>> &formatTable) const
+{
+    QByteArray encoded;
+    for (auto it = formatTable.begin(); it != formatTable.end(); it++) {
+        encoded.reserve(encoded.size() + it->size() * sizeof(uint16_t));
+        for (const uint64_t &mod : *it) {
+            const uint16_t index = indices.value({it.key(), mod});
+            encoded.append(reinterpret_cast<const char *>(&index), sizeof(uint16_t));
+        }
     }
-    memcpy(address, data.data(), size);
+    return encoded;
 }
 
 LinuxDmaBufV1FormatTable::~LinuxDmaBufV1FormatTable()
@@ -11,6 +11,7 @@
 #include "clientbuffer.h"
 #include "clientbufferintegration.h"
 
+#include <QFuture>
 #include <QHash>
 #include <QSet>
 #include <sys/types.h>
@@ -123,6 +124,39 @@ public:
          * @return The imported buffer on success, and nullptr otherwise.
          */
         virtual LinuxDmaBufV1ClientBuffer *importBuffer(const QVector<LinuxDmaBufV1Plane> &planes, quint32 format, const QSize &size, quint32 flags) = 0;
+
+        /**
+         * Imports a linux-dmabuf buffer without blocking the compositor, e.g. on a worker
+         * thread. Used for buffers created with the create request, whose result the client
+         * waits for. Buffers created with create_immed are imported with importBuffer.
+         *
+         * The future has to finish on the thread of the display. The ownership rules are the
+         * same as for importBuffer, a null result means the import failed. The default
+         * implementation imports synchronously with importBuffer.
+         *
+         * @since 5.24
+         */
+        virtual QFuture<LinuxDmaBufV1ClientBuffer *>
+        importBufferAsync(const QVector<LinuxDmaBufV1Plane> &planes, quint32 format, const QSize &size, quint32 flags);
+
+        /**
+         * Creates a buffer for dmabufs which are imported already as @p imported, e.g. because
+         * a client wraps the buffers of its swapchain in new wl_buffer objects. The renderer can
+         * share its import (EGLImage, texture) with @p imported then. Only called if the import
+         * cache is enabled.
+         *
+         * The ownership of the file descriptors is the same as for importBuffer. The default
+         * implementation imports the planes again.
+         *
+         * @see LinuxDmaBufV1ClientBufferIntegration::setImportCacheEnabled
+         * @since 5.24
+         */
+        virtual LinuxDmaBufV1ClientBuffer *
+        reuseImport(LinuxDmaBufV1ClientBuffer *imported, const QVector<LinuxDmaBufV1Plane> &planes, quint32 format, const QSize &size, quint32 flags)
+        {
+            Q_UNUSED(imported)
+            return importBuffer(planes, format, size, flags);
+        }
     };
 
     RendererInterface *rendererInterface() const;
@@ -136,6 +170,26 @@ public:
 
     void setSupportedFormatsWithModifiers(const QVector<LinuxDmaBufV1Feedback::Tranche> &tranches);
 
+    /**
+     * Enables looking up the buffers created for the same dmabufs, identified by the files
+     * of the planes along with their layout, format, size and flags. New buffers for such
+     * dmabufs are created with RendererInterface::reuseImport instead of importBuffer. An
+     * entry is dropped once all of its buffers are destroyed. Disabled by default.
+     * @since 5.24
+     */
+    void setImportCacheEnabled(bool enabled);
+    bool isImportCacheEnabled() const;
+    /**
+     * @returns How many buffers were created with RendererInterface::reuseImport.
+     * @since 5.24
+     */
+    quint64 importCacheHits() const;
+    /**
+     * @returns How many buffers were imported while the cache was enabled.
+     * @since 5.24
+     */
+    quint64 importCacheMisses() const;
+
 private:
     friend class LinuxDmaBufV1ClientBufferIntegrationPrivate;
     QScopedPointer<LinuxDmaBufV1ClientBufferIntegrationPrivate> d;
@@ -20,24 +20,80 @@
 #include "qwayland-server-wayland.h"
 
 #include <QDebug>
+#include <QFutureWatcher>
+#include <QSize>
 #include <QVector>
 
 namespace KWaylandServer
 {
 
 class LinuxDmaBufV1FormatTable;
+class LinuxDmaBufV1FeedbackPrivate;
+
+/**
+ * Identifies the dmabufs of a buffer, the planes by the files they refer to.
+ */
+struct LinuxDmaBufV1ImportKey {
+    struct Plane {
+        dev_t device;
+        ino_t inode;
+        quint32 offset;
+        quint32 stride;
+        quint64 modifier;
+    };
+    QVector<Plane> planes;
+    quint32 format;
+    QSize size;
+    quint32 flags;
+};
+
+bool operator==(const LinuxDmaBufV1ImportKey::Plane &a, const LinuxDmaBufV1ImportKey::Plane &b);
+bool operator==(const LinuxDmaBufV1ImportKey &a, const LinuxDmaBufV1ImportKey &b);
+uint qHash(const LinuxDmaBufV1ImportKey &key, uint seed = 0);
 
 class LinuxDmaBufV1ClientBufferIntegrationPrivate : public QtWaylandServer::zwp_linux_dmabuf_v1
 {
 public:
     LinuxDmaBufV1ClientBufferIntegrationPrivate(LinuxDmaBufV1ClientBufferIntegration *q, Display *display);
+    ~LinuxDmaBufV1ClientBufferIntegrationPrivate() override;
+
+    static LinuxDmaBufV1ClientBufferIntegrationPrivate *get(LinuxDmaBufV1ClientBufferIntegration *q);
+    /**
+     * Imports the planes through the renderer, reusing an earlier import of the same dmabufs
+     * if the import cache is enabled.
+     */
+    LinuxDmaBufV1ClientBuffer *importBuffer(const QVector<LinuxDmaBufV1Plane> &planes, quint32 format, const QSize &size, quint32 flags);
+    /**
+     * Like importBuffer, but imports through RendererInterface::importBufferAsync.
+     */
+    QFuture<LinuxDmaBufV1ClientBuffer *> importBufferAsync(const QVector<LinuxDmaBufV1Plane> &planes, quint32 format, const QSize &size, quint32 flags);
 
     LinuxDmaBufV1ClientBufferIntegration *q;
     LinuxDmaBufV1ClientBufferIntegration::RendererInterface *rendererInterface = nullptr;
+    // declared before the default feedback, which registers itself here
+    QVector<LinuxDmaBufV1FeedbackPrivate *> feedbacks;
     QScopedPointer<LinuxDmaBufV1Feedback> defaultFeedback;
     QScopedPointer<LinuxDmaBufV1FormatTable> table;
     dev_t mainDevice;
     QHash<uint32_t, QSet<uint64_t>> supportedModifiers;
+    // encoded once for every feedback and legacy bind
+    QByteArray mainDeviceBytes;
+    QVector<std::pair<uint32_t, uint64_t>> legacyFormats;
+    // incremented whenever the format table gets replaced, indices into it change then
+    quint32 tableSerial = 0;
+
+    bool importCacheEnabled = false;
+    quint64 importCacheHits = 0;
+    quint64 importCacheMisses = 0;
+    // the live buffers created for each set of dmabufs
+    QHash<LinuxDmaBufV1ImportKey, QVector<LinuxDmaBufV1ClientBuffer *>> importCache;
+
+private:
+    /**
+     * @returns Whether the import cache is enabled and @p key identifies the dmabufs.
+     */
+    bool makeImportKey(const QVector<LinuxDmaBufV1Plane> &planes, quint32 format, const QSize &size, quint32 flags, LinuxDmaBufV1ImportKey *key) const;
+    void addToImportCache(const LinuxDmaBufV1ImportKey &key, LinuxDmaBufV1ClientBuffer *buffer);
 
 protected:
     void zwp_linux_dmabuf_v1_bind_resource(Resource *resource) override;
@@ -82,11 +138,17 @@ protected:
 
 private:
     bool test(Resource *resource, uint32_t width, uint32_t height);
+    /**
+     * Sends the result of the import started by create, unless the client is gone.
+     */
+    void finishCreate(LinuxDmaBufV1ClientBuffer *clientBuffer);
 
     LinuxDmaBufV1ClientBufferIntegration *m_integration;
     QVector<LinuxDmaBufV1Plane> m_planes;
     int m_planeCount = 0;
     bool m_isUsed = false;
+    QScopedPointer<QFutureWatcher<LinuxDmaBufV1ClientBuffer *>> m_pendingImport;
+    bool m_isDestroyed = false;
 };
 
 class LinuxDmaBufV1FormatTable
@@ -95,20 +157,45 @@ public:
     LinuxDmaBufV1FormatTable(const QHash<uint32_t, QSet<uint64_t>> &supportedModifiers);
     ~LinuxDmaBufV1FormatTable();
 
+    /**
+     * @returns The indices of the format and modifier pairs in @p formatTable, as sent in
+     * the tranche_formats event.
+     */
+    QByteArray encodeIndices(const QHash<uint32_t, QSet<uint64_t>> &formatTable) const;
+
     int fd = -1;
     int size;
-    QMap<std::pair<uint32_t, uint64_t>, uint16_t> indices;
+    QHash<std::pair<uint32_t, uint64_t>, uint16_t> indices;
 };
 
 class LinuxDmaBufV1FeedbackPrivate : public QtWaylandServer::zwp_linux_dmabuf_feedback_v1
 {
 public:
     LinuxDmaBufV1FeedbackPrivate(LinuxDmaBufV1ClientBufferIntegrationPrivate *bufferintegration);
+    ~LinuxDmaBufV1FeedbackPrivate() override;
 
     static LinuxDmaBufV1FeedbackPrivate *get(LinuxDmaBufV1Feedback *q);
     void send(Resource *resource);
+    void sendToAll();
+    /**
+     * Replaces the tranches, only the tranches which differ from the current ones get encoded.
+     * @returns Whether the tranches changed.
+     */
+    bool updateTranches(const QVector<LinuxDmaBufV1Feedback::Tranche> &tranches);
+
+    struct EncodedTranche {
+        QByteArray targetDevice;
+        QByteArray formats;
+        uint32_t flags;
+    };
+    /**
+     * @returns The tranches as sent to clients, encoded against the current format table.
+     */
+    const QVector<EncodedTranche> &encodedTranches();
 
     QVector<LinuxDmaBufV1Feedback::Tranche> m_tranches;
+    QVector<EncodedTranche> m_encodedTranches;
+    quint32 m_tableSerial = 0;
     LinuxDmaBufV1ClientBufferIntegrationPrivate *m_bufferintegration;
 
 protected:
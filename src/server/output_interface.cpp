@@ -7,50 +7,15 @@
 #include "output_interface.h"
 #include "display.h"
 #include "display_p.h"
+#include "output_interface_p.h"
 #include "utils.h"
 
-#include "qwayland-server-wayland.h"
-
-#include <QPointer>
 #include <QVector>
 
 namespace KWaylandServer
 {
 static const int s_version = 3;
 
-class OutputInterfacePrivate : public QtWaylandServer::wl_output
-{
-public:
-    explicit OutputInterfacePrivate(Display *display, OutputInterface *q);
-
-    void sendScale(Resource *resource);
-    void sendGeometry(Resource *resource);
-    void sendMode(Resource *resource);
-    void sendDone(Resource *resource);
-
-    void broadcastGeometry();
-
-    OutputInterface *q;
-    QPointer<Display> display;
-    QSize physicalSize;
-    QPoint globalPosition;
-    QString manufacturer = QStringLiteral("org.kde.kwin");
-    QString model = QStringLiteral("none");
-    int scale = 1;
-    OutputInterface::SubPixel subPixel = OutputInterface::SubPixel::Unknown;
-    OutputInterface::Transform transform = OutputInterface::Transform::Normal;
-    OutputInterface::Mode mode;
-    struct {
-        OutputInterface::DpmsMode mode = OutputInterface::DpmsMode::Off;
-        bool supported = false;
-    } dpms;
-
-private:
-    void output_destroy_global() override;
-    void output_bind_resource(Resource *resource) override;
-    void output_release(Resource *resource) override;
-};
-
 OutputInterfacePrivate::OutputInterfacePrivate(Display *display, OutputInterface *q)
     : QtWaylandServer::wl_output(*display, s_version)
     , q(q)
@@ -136,12 +101,40 @@ void OutputInterfacePrivate::sendDone(Resource *resource)
 
 void OutputInterfacePrivate::broadcastGeometry()
 {
+    if (updateDepth > 0) {
+        return;
+    }
     const auto outputResources = resourceMap();
     for (Resource *resource : outputResources) {
         sendGeometry(resource);
     }
 }
 
+void OutputInterfacePrivate::flushUpdate()
+{
+    const bool modeChanged = announced.mode.size != mode.size || announced.mode.refreshRate != mode.refreshRate;
+    const bool scaleChanged = announced.scale != scale;
+    const bool geometryChanged = announced.physicalSize != physicalSize || announced.manufacturer != manufacturer || announced.model != model
+        || announced.subPixel != subPixel || announced.transform != transform;
+    if (!modeChanged && !scaleChanged && !geometryChanged) {
+        return;
+    }
+
+    const auto outputResources = resourceMap();
+    for (Resource *resource : outputResources) {
+        if (modeChanged) {
+            sendMode(resource);
+        }
+        if (scaleChanged) {
+            sendScale(resource);
+        }
+        if (geometryChanged) {
+            sendGeometry(resource);
+        }
+        sendDone(resource);
+    }
+}
+
 void OutputInterfacePrivate::output_destroy_global()
 {
     delete q;
@@ -171,7 +164,7 @@ OutputInterface::OutputInterface(Display *display, QObject *parent)
     , d(new OutputInterfacePrivate(display, this))
 {
     DisplayPrivate *displayPrivate = DisplayPrivate::get(display);
-    displayPrivate->outputs.append(this);
+    displayPrivate->registerOutput(this);
 }
 
 OutputInterface::~OutputInterface()
@@ -187,7 +180,7 @@ void OutputInterface::remove()
 
     if (d->display) {
         DisplayPrivate *displayPrivate = DisplayPrivate::get(d->display);
-        displayPrivate->outputs.removeOne(this);
+        displayPrivate->unregisterOutput(this);
     }
 
     Q_EMIT removed();
@@ -217,9 +210,11 @@ void OutputInterface::setMode(const Mode &mode)
 
     d->mode = mode;
 
-    const auto outputResources = d->resourceMap();
-    for (OutputInterfacePrivate::Resource *resource : outputResources) {
-        d->sendMode(resource);
+    if (d->updateDepth == 0) {
+        const auto outputResources = d->resourceMap();
+        for (OutputInterfacePrivate::Resource *resource : outputResources) {
+            d->sendMode(resource);
+        }
     }
 
     Q_EMIT modeChanged();
@@ -303,9 +298,11 @@ void OutputInterface::setScale(int scale)
     }
     d->scale = scale;
 
-    const auto outputResources = d->resourceMap();
-    for (OutputInterfacePrivate::Resource *resource : outputResources) {
-        d->sendScale(resource);
+    if (d->updateDepth == 0) {
+        const auto outputResources = d->resourceMap();
+        for (OutputInterfacePrivate::Resource *resource : outputResources) {
+            d->sendScale(resource);
+        }
     }
 
     Q_EMIT scaleChanged(d->scale);
@@ -390,6 +387,29 @@ bool OutputInterface::isEnabled() const
     return d->dpms.mode == DpmsMode::On;
 }
 
+void OutputInterface::beginUpdate()
+{
+    if (d->updateDepth++ > 0) {
+        return;
+    }
+    d->announced.physicalSize = d->physicalSize;
+    d->announced.manufacturer = d->manufacturer;
+    d->announced.model = d->model;
+    d->announced.scale = d->scale;
+    d->announced.subPixel = d->subPixel;
+    d->announced.transform = d->transform;
+    d->announced.mode = d->mode;
+}
+
+void OutputInterface::commitUpdate()
+{
+    Q_ASSERT(d->updateDepth > 0);
+    if (--d->updateDepth > 0) {
+        return;
+    }
+    d->flushUpdate();
+}
+
 void OutputInterface::done()
 {
     const auto outputResources = d->resourceMap();
@@ -403,6 +423,11 @@ void OutputInterface::done(wl_client *client)
     d->sendDone(d->resourceMap().value(client));
 }
 
+OutputInterfacePrivate *OutputInterfacePrivate::get(OutputInterface *output)
+{
+    return output->d.data();
+}
+
 OutputInterface *OutputInterface::get(wl_resource *native)
 {
     if (auto outputPrivate = resource_cast<OutputInterfacePrivate *>(native)) {
@@ -124,6 +124,26 @@ public:
      */
     void done(wl_client *client);
 
+    /**
+     * Starts collecting changes to the mode, scale and geometry instead of sending them right away.
+     *
+     * The matching commitUpdate sends only what differs from the state at the time beginUpdate
+     * was called, followed by a single done event per resource, so no explicit done call is needed.
+     * The change signals are still emitted immediately. Calls can be nested, the changes are sent
+     * by the outermost commitUpdate.
+     *
+     * @see commitUpdate
+     * @since 5.24
+     */
+    void beginUpdate();
+    /**
+     * Sends the changes collected since the matching beginUpdate.
+     *
+     * @see beginUpdate
+     * @since 5.24
+     */
+    void commitUpdate();
+
     static OutputInterface *get(wl_resource *native);
 
 Q_SIGNALS:
@@ -154,6 +174,7 @@ Q_SIGNALS:
     void bound(ClientConnection *client, wl_resource *boundResource);
 
 private:
+    friend class OutputInterfacePrivate;
     QScopedPointer<OutputInterfacePrivate> d;
 };
 
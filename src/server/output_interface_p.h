@@ -0,0 +1,65 @@
+/*
+    SPDX-FileCopyrightText: 2014 Martin Gräßlin <mgraesslin@kde.org>
+    SPDX-FileCopyrightText: 2021 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#pragma once
+
+#include "output_interface.h"
+
+#include <QPointer>
+
+#include "qwayland-server-wayland.h"
+
+namespace KWaylandServer
+{
+class OutputInterfacePrivate : public QtWaylandServer::wl_output
+{
+public:
+    static OutputInterfacePrivate *get(OutputInterface *output);
+
+    explicit OutputInterfacePrivate(Display *display, OutputInterface *q);
+
+    void sendScale(Resource *resource);
+    void sendGeometry(Resource *resource);
+    void sendMode(Resource *resource);
+    void sendDone(Resource *resource);
+
+    void broadcastGeometry();
+    void flushUpdate();
+
+    OutputInterface *q;
+    QPointer<Display> display;
+    QSize physicalSize;
+    QPoint globalPosition;
+    QString manufacturer = QStringLiteral("org.kde.kwin");
+    QString model = QStringLiteral("none");
+    int scale = 1;
+    OutputInterface::SubPixel subPixel = OutputInterface::SubPixel::Unknown;
+    OutputInterface::Transform transform = OutputInterface::Transform::Normal;
+    OutputInterface::Mode mode;
+    struct {
+        OutputInterface::DpmsMode mode = OutputInterface::DpmsMode::Off;
+        bool supported = false;
+    } dpms;
+
+    // the state clients knew about when the outermost beginUpdate was called
+    struct {
+        QSize physicalSize;
+        QString manufacturer;
+        QString model;
+        int scale = 1;
+        OutputInterface::SubPixel subPixel = OutputInterface::SubPixel::Unknown;
+        OutputInterface::Transform transform = OutputInterface::Transform::Normal;
+        OutputInterface::Mode mode;
+    } announced;
+    int updateDepth = 0;
+
+private:
+    void output_destroy_global() override;
+    void output_bind_resource(Resource *resource) override;
+    void output_release(Resource *resource) override;
+};
+
+} // namespace KWaylandServer
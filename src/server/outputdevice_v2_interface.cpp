@@ -28,6 +28,8 @@ public:
     ~OutputDeviceV2InterfacePrivate() override;
 
     void updateGeometry();
+    void broadcast(void (OutputDeviceV2InterfacePrivate::*send)(Resource *resource));
+    void flushUpdate();
 
     void sendGeometry(Resource *resource);
     wl_resource *sendNewMode(Resource *resource, OutputDeviceModeV2Interface *mode);
@@ -71,6 +73,31 @@ public:
     QPointer<Display> display;
     OutputDeviceV2Interface *q;
 
+    // the state clients knew about when the outermost beginUpdate was called
+    struct {
+        QSize physicalSize;
+        QPoint globalPosition;
+        QString manufacturer;
+        QString model;
+        qreal scale = 1.0;
+        QString serialNumber;
+        QString eisaId;
+        QString name;
+        OutputDeviceV2Interface::SubPixel subPixel = OutputDeviceV2Interface::SubPixel::Unknown;
+        OutputDeviceV2Interface::Transform transform = OutputDeviceV2Interface::Transform::Normal;
+        QByteArray edid;
+        bool enabled = true;
+        QUuid uuid;
+        OutputDeviceV2Interface::Capabilities capabilities;
+        uint32_t overscan = 0;
+        OutputDeviceV2Interface::VrrPolicy vrrPolicy = OutputDeviceV2Interface::VrrPolicy::Automatic;
+        OutputDeviceV2Interface::RgbRange rgbRange = OutputDeviceV2Interface::RgbRange::Automatic;
+    } announced;
+    int updateDepth = 0;
+    // mode objects were added or removed during the update
+    bool modesChanged = false;
+    bool currentModeChanged = false;
+
 private:
     int32_t toTransform() const;
     int32_t toSubPixel() const;
@@ -96,6 +123,7 @@ public:
     void bindResource(wl_resource *resource);
 
     static OutputDeviceModeV2InterfacePrivate *get(OutputDeviceModeV2Interface *mode) { return mode->d.data(); }
+    static void takeOver(OutputDeviceModeV2Interface *mode, OutputDeviceModeV2Interface *previous);
 
     OutputDeviceModeV2Interface *q;
 
@@ -177,6 +205,10 @@ void OutputDeviceV2Interface::setCurrentMode(OutputDeviceModeV2Interface *mode)
 
     mode->setFlags(mode->flags() | OutputDeviceModeV2Interface::ModeFlag::Current);
     d->currentMode = mode;
+    if (d->updateDepth > 0) {
+        d->currentModeChanged = true;
+        return;
+    }
 
     const auto clientResources = d->resourceMap();
     for (auto it = clientResources.begin(); it != clientResources.end(); ++it) {
@@ -345,13 +377,125 @@ void OutputDeviceV2InterfacePrivate::sendDone(Resource *resource)
 
 void OutputDeviceV2InterfacePrivate::updateGeometry()
 {
+    broadcast(&OutputDeviceV2InterfacePrivate::sendGeometry);
+}
+
+void OutputDeviceV2InterfacePrivate::broadcast(void (OutputDeviceV2InterfacePrivate::*send)(Resource *resource))
+{
+    if (updateDepth > 0) {
+        // sent by flushUpdate if still different from what the clients know
+        return;
+    }
     const auto clientResources = resourceMap();
     for (const auto &resource : clientResources) {
-        sendGeometry(resource);
+        (this->*send)(resource);
         sendDone(resource);
     }
 }
 
+void OutputDeviceV2InterfacePrivate::flushUpdate()
+{
+    const bool geometryChanged = announced.physicalSize != physicalSize || announced.globalPosition != globalPosition
+        || announced.manufacturer != manufacturer || announced.model != model || announced.subPixel != subPixel || announced.transform != transform;
+    const bool scaleChanged = !qFuzzyCompare(announced.scale, scale);
+    const bool serialNumberChanged = announced.serialNumber != serialNumber;
+    const bool eisaIdChanged = announced.eisaId != eisaId;
+    const bool nameChanged = announced.name != name;
+    const bool edidChanged = announced.edid != edid;
+    const bool enabledChanged = announced.enabled != enabled;
+    const bool uuidChanged = announced.uuid != uuid;
+    const bool capabilitiesChanged = announced.capabilities != capabilities;
+    const bool overscanChanged = announced.overscan != overscan;
+    const bool vrrPolicyChanged = announced.vrrPolicy != vrrPolicy;
+    const bool rgbRangeChanged = announced.rgbRange != rgbRange;
+    const bool sendCurrent = currentModeChanged && currentMode;
+
+    const bool changed = modesChanged || sendCurrent || geometryChanged || scaleChanged || serialNumberChanged || eisaIdChanged || nameChanged
+        || edidChanged || enabledChanged || uuidChanged || capabilitiesChanged || overscanChanged || vrrPolicyChanged || rgbRangeChanged;
+    modesChanged = false;
+    currentModeChanged = false;
+    if (!changed) {
+        return;
+    }
+
+    const auto clientResources = resourceMap();
+    for (const auto &resource : clientResources) {
+        if (geometryChanged) {
+            sendGeometry(resource);
+        }
+        if (scaleChanged) {
+            sendScale(resource);
+        }
+        if (eisaIdChanged) {
+            sendEisaId(resource);
+        }
+        if (nameChanged) {
+            sendName(resource);
+        }
+        if (serialNumberChanged) {
+            sendSerialNumber(resource);
+        }
+        if (sendCurrent) {
+            sendCurrentMode(resource, currentMode);
+        }
+        if (uuidChanged) {
+            sendUuid(resource);
+        }
+        if (edidChanged) {
+            sendEdid(resource);
+        }
+        if (enabledChanged) {
+            sendEnabled(resource);
+        }
+        if (capabilitiesChanged) {
+            sendCapabilities(resource);
+        }
+        if (overscanChanged) {
+            sendOverscan(resource);
+        }
+        if (vrrPolicyChanged) {
+            sendVrrPolicy(resource);
+        }
+        if (rgbRangeChanged) {
+            sendRgbRange(resource);
+        }
+        sendDone(resource);
+    }
+}
+
+void OutputDeviceV2Interface::beginUpdate()
+{
+    if (d->updateDepth++ > 0) {
+        return;
+    }
+    d->announced.physicalSize = d->physicalSize;
+    d->announced.globalPosition = d->globalPosition;
+    d->announced.manufacturer = d->manufacturer;
+    d->announced.model = d->model;
+    d->announced.scale = d->scale;
+    d->announced.serialNumber = d->serialNumber;
+    d->announced.eisaId = d->eisaId;
+    d->announced.name = d->name;
+    d->announced.subPixel = d->subPixel;
+    d->announced.transform = d->transform;
+    d->announced.edid = d->edid;
+    d->announced.enabled = d->enabled;
+    d->announced.uuid = d->uuid;
+    d->announced.capabilities = d->capabilities;
+    d->announced.overscan = d->overscan;
+    d->announced.vrrPolicy = d->vrrPolicy;
+    d->announced.rgbRange = d->rgbRange;
+}
+
+void OutputDeviceV2Interface::commitUpdate()
+{
+    Q_ASSERT(d->updateDepth > 0);
+    if (--d->updateDepth > 0) {
+        return;
+    }
+    d->flushUpdate();
+}
+
 void OutputDeviceV2Interface::setPhysicalSize(const QSize &arg)
 {
     if (d->physicalSize == arg) {
@@ -433,11 +577,7 @@ void OutputDeviceV2Interface::setScale(qreal scale)
         return;
     }
     d->scale = scale;
-    const auto clientResources = d->resourceMap();
-    for (const auto &resource : clientResources) {
-        d->sendScale(resource);
-        d->sendDone(resource);
-    }
+    d->broadcast(&OutputDeviceV2InterfacePrivate::sendScale);
 }
 
 QSize OutputDeviceV2Interface::physicalSize() const
@@ -504,20 +644,44 @@ void OutputDeviceV2Interface::setModes(const QList<OutputDeviceModeV2Interface *
 
     const auto clientResources = d->resourceMap();
 
-    const auto oldModes = d->modes;
+    const auto previousModes = d->modes;
+    auto oldModes = d->modes;
+    for (OutputDeviceModeV2Interface *outputDeviceMode : modes) {
+        oldModes.removeOne(outputDeviceMode);
+    }
+    const auto oldCurrentMode = d->currentMode ? OutputDeviceModeV2InterfacePrivate::get(d->currentMode) : nullptr;
     d->modes.clear();
     d->currentMode = nullptr;
 
+    QList<OutputDeviceModeV2Interface *> addedModes;
+    QList<OutputDeviceModeV2Interface *> replacedModes;
     for (OutputDeviceModeV2Interface *outputDeviceMode : modes) {
         d->modes << outputDeviceMode;
         outputDeviceMode->setParent(this);
 
+        if (previousModes.contains(outputDeviceMode)) {
+            if (outputDeviceMode->flags().testFlag(OutputDeviceModeV2Interface::ModeFlag::Current)) {
+                d->currentMode = outputDeviceMode;
+            }
+            continue;
+        }
+
+        // clients keep the mode objects whose parameters did not change
+        auto it = std::find_if(oldModes.begin(), oldModes.end(), [outputDeviceMode](OutputDeviceModeV2Interface *oldMode) {
+            return oldMode->size() == outputDeviceMode->size() && oldMode->refreshRate() == outputDeviceMode->refreshRate()
+                && oldMode->flags().testFlag(OutputDeviceModeV2Interface::ModeFlag::Preferred)
+                == outputDeviceMode->flags().testFlag(OutputDeviceModeV2Interface::ModeFlag::Preferred);
+        });
+        if (it != oldModes.end()) {
+            OutputDeviceModeV2InterfacePrivate::takeOver(outputDeviceMode, *it);
+            replacedModes << *it;
+            oldModes.erase(it);
+        } else {
+            addedModes << outputDeviceMode;
+        }
+
         if (outputDeviceMode->flags().testFlag(OutputDeviceModeV2Interface::ModeFlag::Current)) {
             d->currentMode = outputDeviceMode;
-        } else {
-            for (auto resource : clientResources) {
-                d->sendNewMode(resource, outputDeviceMode);
-            }
         }
     }
 
@@ -525,13 +689,41 @@ void OutputDeviceV2Interface::setModes(const QList<OutputDeviceModeV2Interface *
         d->currentMode = d->modes.at(0);
     }
 
-    for (auto resource : clientResources) {
-        d->sendNewMode(resource, d->currentMode);
-        d->sendCurrentMode(resource, d->currentMode);
+    // the current mode needs to be sent as last mode
+    for (OutputDeviceModeV2Interface *outputDeviceMode : qAsConst(addedModes)) {
+        if (outputDeviceMode == d->currentMode) {
+            continue;
+        }
+        for (auto resource : clientResources) {
+            d->sendNewMode(resource, outputDeviceMode);
+        }
+    }
+    if (addedModes.contains(d->currentMode)) {
+        for (auto resource : clientResources) {
+            d->sendNewMode(resource, d->currentMode);
+        }
+    }
+
+    const bool currentModeChanged = OutputDeviceModeV2InterfacePrivate::get(d->currentMode) != oldCurrentMode;
+    if (currentModeChanged && d->updateDepth == 0) {
+        for (auto resource : clientResources) {
+            d->sendCurrentMode(resource, d->currentMode);
+        }
     }
 
+    const bool modesChanged = !addedModes.isEmpty() || !oldModes.isEmpty();
     qDeleteAll(oldModes.crbegin(), oldModes.crend());
+    // these only hold the state the new modes brought along, without any resources
+    qDeleteAll(replacedModes);
 
+    if (d->updateDepth > 0) {
+        d->modesChanged |= modesChanged;
+        d->currentModeChanged |= currentModeChanged;
+        return;
+    }
+    if (!modesChanged && !currentModeChanged) {
+        return;
+    }
     for (auto resource : clientResources) {
         d->sendDone(resource);
     }
@@ -539,12 +731,11 @@ void OutputDeviceV2Interface::setModes(const QList<OutputDeviceModeV2Interface *
 
 void OutputDeviceV2Interface::setEdid(const QByteArray &edid)
 {
-    d->edid = edid;
-    const auto clientResources = d->resourceMap();
-    for (const auto &resource : clientResources) {
-        d->sendEdid(resource);
-        d->sendDone(resource);
+    if (d->edid == edid) {
+        return;
     }
+    d->edid = edid;
+    d->broadcast(&OutputDeviceV2InterfacePrivate::sendEdid);
 }
 
 QByteArray OutputDeviceV2Interface::edid() const
@@ -556,11 +747,7 @@ void OutputDeviceV2Interface::setEnabled(bool enabled)
 {
     if (d->enabled != enabled) {
         d->enabled = enabled;
-        const auto clientResources = d->resourceMap();
-        for (const auto &resource : clientResources) {
-            d->sendEnabled(resource);
-            d->sendDone(resource);
-        }
+        d->broadcast(&OutputDeviceV2InterfacePrivate::sendEnabled);
     }
 }
 
@@ -573,11 +760,7 @@ void OutputDeviceV2Interface::setUuid(const QUuid &uuid)
 {
     if (d->uuid != uuid) {
         d->uuid = uuid;
-        const auto clientResources = d->resourceMap();
-        for (const auto &resource : clientResources) {
-            d->sendUuid(resource);
-            d->sendDone(resource);
-        }
+        d->broadcast(&OutputDeviceV2InterfacePrivate::sendUuid);
     }
 }
 
@@ -615,11 +798,7 @@ void OutputDeviceV2Interface::setCapabilities(Capabilities cap)
 {
     if (d->capabilities != cap) {
         d->capabilities = cap;
-        const auto clientResources = d->resourceMap();
-        for (const auto &resource : clientResources) {
-            d->sendCapabilities(resource);
-            d->sendDone(resource);
-        }
+        d->broadcast(&OutputDeviceV2InterfacePrivate::sendCapabilities);
     }
 }
 
@@ -632,11 +811,7 @@ void OutputDeviceV2Interface::setOverscan(uint32_t overscan)
 {
     if (d->overscan != overscan) {
         d->overscan = overscan;
-        const auto clientResources = d->resourceMap();
-        for (const auto &resource : clientResources) {
-            d->sendOverscan(resource);
-            d->sendDone(resource);
-        }
+        d->broadcast(&OutputDeviceV2InterfacePrivate::sendOverscan);
     }
 }
 
@@ -659,11 +834,7 @@ void OutputDeviceV2Interface::setVrrPolicy(VrrPolicy policy)
 {
     if (d->vrrPolicy != policy) {
         d->vrrPolicy = policy;
-        const auto clientResources = d->resourceMap();
-        for (const auto &resource : clientResources) {
-            d->sendVrrPolicy(resource);
-            d->sendDone(resource);
-        }
+        d->broadcast(&OutputDeviceV2InterfacePrivate::sendVrrPolicy);
     }
 }
 
@@ -676,11 +847,7 @@ void OutputDeviceV2Interface::setRgbRange(RgbRange rgbRange)
 {
     if (d->rgbRange != rgbRange) {
         d->rgbRange = rgbRange;
-        const auto clientResources = d->resourceMap();
-        for (const auto &resource : clientResources) {
-            d->sendRgbRange(resource);
-            d->sendDone(resource);
-        }
+        d->broadcast(&OutputDeviceV2InterfacePrivate::sendRgbRange);
     }
 }
 
@@ -717,6 +884,16 @@ OutputDeviceModeV2Interface::OutputDeviceModeV2Interface(const QSize &size, int
 
 OutputDeviceModeV2Interface::~OutputDeviceModeV2Interface() = default;
 
+void OutputDeviceModeV2InterfacePrivate::takeOver(OutputDeviceModeV2Interface *mode, OutputDeviceModeV2Interface *previous)
+{
+    // the resources clients already have for previous now refer to mode
+    const OutputDeviceModeV2Interface::ModeFlags flags = mode->d->m_flags;
+    mode->d.swap(previous->d);
+    mode->d->q = mode;
+    mode->d->m_flags = flags;
+    previous->d->q = previous;
+}
+
 OutputDeviceModeV2InterfacePrivate::~OutputDeviceModeV2InterfacePrivate()
 {
     const auto map = resourceMap();
@@ -117,6 +117,10 @@ public:
     void setSubPixel(SubPixel subPixel);
     void setTransform(Transform transform);
 
+    /**
+     * Sets the modes of the output. Clients keep the mode objects they already know about
+     * if a new mode has the same size, refresh rate and preferred flag as an old one.
+     */
     void setModes(const QList<KWaylandServer::OutputDeviceModeV2Interface *> &modes);
     void setCurrentMode(KWaylandServer::OutputDeviceModeV2Interface *mode);
 
@@ -135,6 +139,25 @@ public:
     void setVrrPolicy(VrrPolicy policy);
     void setRgbRange(RgbRange rgbRange);
 
+    /**
+     * Starts collecting changes instead of sending each of them with its own done event.
+     *
+     * The matching commitUpdate compares the state with the one at the time beginUpdate
+     * was called and sends only the properties which differ, followed by a single done event
+     * per resource. Calls can be nested, the changes are sent by the outermost commitUpdate.
+     *
+     * @see commitUpdate
+     * @since 5.24
+     */
+    void beginUpdate();
+    /**
+     * Sends the changes collected since the matching beginUpdate.
+     *
+     * @see beginUpdate
+     * @since 5.24
+     */
+    void commitUpdate();
+
     wl_resource *resource() const;
     static OutputDeviceV2Interface *get(wl_resource *native);
 
@@ -7,7 +7,9 @@
 #include "display.h"
 
 #include <QDebug>
+#include <QSet>
 #include <QTimer>
+#include <QVector>
 
 #include <qwayland-server-org-kde-plasma-virtual-desktop.h>
 #include <wayland-server.h>
@@ -25,10 +27,17 @@ public:
     PlasmaVirtualDesktopInterface *q;
     PlasmaVirtualDesktopManagementInterface *vdm;
 
+    bool isBatched() const;
+    void markDirty();
+
     QString id;
     QString name;
     bool active = false;
 
+    // the state clients last got told about, only valid while the desktop is dirty in an update
+    QString announcedName;
+    bool announcedActive = false;
+
 protected:
     void org_kde_plasma_virtual_desktop_bind_resource(Resource *resource) override;
     void org_kde_plasma_virtual_desktop_request_activate(Resource *resource) override;
@@ -39,11 +48,22 @@ class PlasmaVirtualDesktopManagementInterfacePrivate : public QtWaylandServer::o
 public:
     PlasmaVirtualDesktopManagementInterfacePrivate(PlasmaVirtualDesktopManagementInterface *_q, Display *display);
 
+    void flushUpdate();
+
     QList<PlasmaVirtualDesktopInterface *> desktops;
     quint32 rows = 0;
     quint32 columns = 0;
     PlasmaVirtualDesktopManagementInterface *q;
 
+    // nesting depth of beginUpdate, while positive changes are only announced by commitUpdate
+    int updateDepth = 0;
+    // the desktops and rows clients knew about when the update began, without the ones
+    // removed since then; those are kept by id, as a new desktop may reuse the id
+    QVector<PlasmaVirtualDesktopInterface *> announcedDesktops;
+    QStringList removedDesktops;
+    quint32 announcedRows = 0;
+    QSet<PlasmaVirtualDesktopInterface *> dirtyDesktops;
+
     inline QList<PlasmaVirtualDesktopInterface *>::const_iterator constFindDesktop(const QString &id);
     inline QList<PlasmaVirtualDesktopInterface *>::iterator findDesktop(const QString &id);
 
@@ -101,6 +121,77 @@ PlasmaVirtualDesktopManagementInterfacePrivate::PlasmaVirtualDesktopManagementIn
 {
 }
 
+void PlasmaVirtualDesktopManagementInterfacePrivate::flushUpdate()
+{
+    // deactivations go first, so that clients never see two active desktops
+    QVector<PlasmaVirtualDesktopInterface *> changedDesktops;
+    for (PlasmaVirtualDesktopInterface *desktop : qAsConst(dirtyDesktops)) {
+        auto desktopPrivate = desktop->d.data();
+        if (desktopPrivate->active == desktopPrivate->announcedActive || desktopPrivate->active) {
+            continue;
+        }
+        const auto desktopClientResources = desktopPrivate->resourceMap();
+        for (auto resource : desktopClientResources) {
+            desktopPrivate->send_deactivated(resource->handle);
+        }
+        changedDesktops << desktop;
+    }
+    for (PlasmaVirtualDesktopInterface *desktop : qAsConst(dirtyDesktops)) {
+        auto desktopPrivate = desktop->d.data();
+        const bool activated = desktopPrivate->active && !desktopPrivate->announcedActive;
+        const bool renamed = desktopPrivate->name != desktopPrivate->announcedName;
+        if (!activated && !renamed) {
+            continue;
+        }
+        const auto desktopClientResources = desktopPrivate->resourceMap();
+        for (auto resource : desktopClientResources) {
+            if (renamed) {
+                desktopPrivate->send_name(resource->handle, desktopPrivate->name);
+            }
+            if (activated) {
+                desktopPrivate->send_activated(resource->handle);
+            }
+        }
+        if (!changedDesktops.contains(desktop)) {
+            changedDesktops << desktop;
+        }
+    }
+    dirtyDesktops.clear();
+    for (PlasmaVirtualDesktopInterface *desktop : qAsConst(changedDesktops)) {
+        desktop->sendDone();
+    }
+
+    QStringList removed;
+    removed.swap(removedDesktops);
+    // created desktops are announced by ascending position, so that inserting them
+    // one by one into the remaining list yields the current order
+    QVector<QPair<QString, quint32>> created;
+    for (int i = 0; i < desktops.count(); ++i) {
+        if (!announcedDesktops.contains(desktops[i])) {
+            created << qMakePair(desktops[i]->id(), quint32(i));
+        }
+    }
+    const bool rowsChanged = rows != announcedRows;
+    announcedDesktops.clear();
+    if (removed.isEmpty() && created.isEmpty() && !rowsChanged) {
+        return;
+    }
+
+    const auto clientResources = resourceMap();
+    for (auto resource : clientResources) {
+        for (const QString &id : qAsConst(removed)) {
+            send_desktop_removed(resource->handle, id);
+        }
+        for (const auto &desktop : qAsConst(created)) {
+            send_desktop_created(resource->handle, desktop.first, desktop.second);
+        }
+        if (rowsChanged && resource->version() >= ORG_KDE_PLASMA_VIRTUAL_DESKTOP_MANAGEMENT_ROWS_SINCE_VERSION) {
+            send_rows(resource->handle, rows);
+        }
+        send_done(resource->handle);
+    }
+}
+
 void PlasmaVirtualDesktopManagementInterfacePrivate::org_kde_plasma_virtual_desktop_management_bind_resource(Resource *resource)
 {
     quint32 i = 0;
@@ -133,6 +224,9 @@ void PlasmaVirtualDesktopManagementInterface::setRows(quint32 rows)
     }
 
     d->rows = rows;
+    if (d->updateDepth > 0) {
+        return;
+    }
 
     const auto clientResources = d->resourceMap();
     for (auto resource : clientResources) {
@@ -175,6 +269,9 @@ PlasmaVirtualDesktopInterface *PlasmaVirtualDesktopManagementInterface::createDe
     }
 
     d->desktops.insert(actualPosition, desktop);
+    if (d->updateDepth > 0) {
+        return desktop;
+    }
 
     const auto clientResources = d->resourceMap();
     for (auto resource : clientResources) {
@@ -196,9 +293,17 @@ void PlasmaVirtualDesktopManagementInterface::removeDesktop(const QString &id)
         (*deskIt)->d->send_removed(resource->handle);
     }
 
-    const auto clientResources = d->resourceMap();
-    for (auto resource : clientResources) {
-        d->send_desktop_removed(resource->handle, id);
+    d->dirtyDesktops.remove(*deskIt);
+    if (d->updateDepth > 0) {
+        // desktops created within the update were never announced
+        if (d->announcedDesktops.removeOne(*deskIt)) {
+            d->removedDesktops << id;
+        }
+    } else {
+        const auto clientResources = d->resourceMap();
+        for (auto resource : clientResources) {
+            d->send_desktop_removed(resource->handle, id);
+        }
     }
 
     (*deskIt)->deleteLater();
@@ -218,6 +323,25 @@ void PlasmaVirtualDesktopManagementInterface::sendDone()
     }
 }
 
+void PlasmaVirtualDesktopManagementInterface::beginUpdate()
+{
+    if (d->updateDepth++ > 0) {
+        return;
+    }
+    d->announcedDesktops = d->desktops.toVector();
+    d->removedDesktops.clear();
+    d->announcedRows = d->rows;
+}
+
+void PlasmaVirtualDesktopManagementInterface::commitUpdate()
+{
+    Q_ASSERT(d->updateDepth > 0);
+    if (--d->updateDepth > 0) {
+        return;
+    }
+    d->flushUpdate();
+}
+
 //// PlasmaVirtualDesktopInterface
 
 void PlasmaVirtualDesktopInterfacePrivate::org_kde_plasma_virtual_desktop_request_activate(Resource *resource)
@@ -233,6 +357,22 @@ PlasmaVirtualDesktopInterfacePrivate::PlasmaVirtualDesktopInterfacePrivate(Plasm
 {
 }
 
+bool PlasmaVirtualDesktopInterfacePrivate::isBatched() const
+{
+    return vdm->d->updateDepth > 0;
+}
+
+void PlasmaVirtualDesktopInterfacePrivate::markDirty()
+{
+    auto vdmPrivate = vdm->d.data();
+    if (vdmPrivate->dirtyDesktops.contains(q)) {
+        return;
+    }
+    vdmPrivate->dirtyDesktops.insert(q);
+    announcedName = name;
+    announcedActive = active;
+}
+
 PlasmaVirtualDesktopInterfacePrivate::~PlasmaVirtualDesktopInterfacePrivate()
 {
     const auto clientResources = resourceMap();
@@ -277,6 +417,11 @@ void PlasmaVirtualDesktopInterface::setName(const QString &name)
         return;
     }
 
+    if (d->isBatched()) {
+        d->markDirty();
+        d->name = name;
+        return;
+    }
     d->name = name;
 
     const auto clientResources = d->resourceMap();
@@ -296,6 +441,11 @@ void PlasmaVirtualDesktopInterface::setActive(bool active)
         return;
     }
 
+    if (d->isBatched()) {
+        d->markDirty();
+        d->active = active;
+        return;
+    }
     d->active = active;
     const auto clientResources = d->resourceMap();
 
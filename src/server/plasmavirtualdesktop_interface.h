@@ -67,6 +67,26 @@ public:
      */
     void sendDone();
 
+    /**
+     * Starts collecting changes to the desktops, their names, activation state and the rows
+     * instead of sending them one by one. The changes are announced by the matching commitUpdate,
+     * which sends only the net difference followed by a single done event per client and one per
+     * changed desktop, so no explicit sendDone calls are needed for them.
+     *
+     * Calls can be nested, the changes are sent by the outermost commitUpdate.
+     *
+     * @see commitUpdate
+     * @since 5.24
+     */
+    void beginUpdate();
+    /**
+     * Sends the changes collected since the matching beginUpdate.
+     *
+     * @see beginUpdate
+     * @since 5.24
+     */
+    void commitUpdate();
+
 Q_SIGNALS:
     /**
      * A desktop has been activated
@@ -88,6 +108,7 @@ Q_SIGNALS:
     void desktopCreateRequested(const QString &name, quint32 position);
 
 private:
+    friend class PlasmaVirtualDesktopInterfacePrivate;
     QScopedPointer<PlasmaVirtualDesktopManagementInterfacePrivate> d;
 };
 
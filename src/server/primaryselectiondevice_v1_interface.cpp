@@ -26,6 +26,9 @@ public:
     PrimarySelectionDeviceV1Interface *q;
     SeatInterface *seat;
     QPointer<PrimarySelectionSourceV1Interface> selection;
+    // the selection generation of the seat the client holds an offer for, 0 if unknown
+    quint32 selectionGeneration = 0;
+    QPointer<PrimarySelectionOfferV1Interface> selectionOffer;
 
 private:
     void setSelection(PrimarySelectionSourceV1Interface *dataSource);
@@ -125,7 +128,9 @@ void PrimarySelectionDeviceV1Interface::sendSelection(AbstractDataSource *other)
         sendClearSelection();
         return;
     }
+    d->selectionGeneration = 0;
     PrimarySelectionOfferV1Interface *offer = d->createDataOffer(other);
+    d->selectionOffer = offer;
     if (!offer) {
         return;
     }
@@ -134,9 +139,20 @@ void PrimarySelectionDeviceV1Interface::sendSelection(AbstractDataSource *other)
 
 void PrimarySelectionDeviceV1Interface::sendClearSelection()
 {
+    d->selectionGeneration = 0;
+    d->selectionOffer = nullptr;
     d->send_selection(nullptr);
 }
 
+void PrimarySelectionDeviceV1Interface::updateSelection(AbstractDataSource *source, quint32 generation)
+{
+    if (d->selectionGeneration == generation && (!source || d->selectionOffer)) {
+        return;
+    }
+    sendSelection(source);
+    d->selectionGeneration = generation;
+}
+
 wl_client *PrimarySelectionDeviceV1Interface::client() const
 {
     return d->resource()->client();
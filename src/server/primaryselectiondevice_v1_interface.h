@@ -50,7 +50,13 @@ Q_SIGNALS:
 
 private:
     friend class PrimarySelectionDeviceManagerV1InterfacePrivate;
+    friend class SeatInterfacePrivate;
     explicit PrimarySelectionDeviceV1Interface(SeatInterface *seat, wl_resource *resource);
+    /**
+     * Sends @p source as the selection unless this device still holds the offer of the
+     * selection @p generation of the seat.
+     */
+    void updateSelection(AbstractDataSource *source, quint32 generation);
 
     QScopedPointer<PrimarySelectionDeviceV1InterfacePrivate> d;
 };
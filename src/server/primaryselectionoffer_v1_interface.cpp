@@ -6,6 +6,7 @@
 #include "primaryselectionoffer_v1_interface.h"
 #include "primaryselectiondevice_v1_interface.h"
 #include "primaryselectionsource_v1_interface.h"
+#include "datasourcemimetypes_p.h"
 // Qt
 #include <QPointer>
 #include <QStringList>
@@ -74,8 +75,8 @@ PrimarySelectionOfferV1Interface::~PrimarySelectionOfferV1Interface() = default;
 
 void PrimarySelectionOfferV1Interface::sendAllOffers()
 {
-    for (const QString &mimeType : d->source->mimeTypes()) {
-        d->send_offer(mimeType);
+    for (const QByteArray &mimeType : DataSourceMimeTypes::get(d->source)->encoded()) {
+        zwp_primary_selection_offer_v1_send_offer(d->resource()->handle, mimeType.constData());
     }
 }
 
@@ -12,20 +12,19 @@
 #include <display.h>
 #include <output_interface.h>
 
+#include "clientconnection.h"
 #include "logging.h"
+#include "output_interface_p.h"
 
+#include <QElapsedTimer>
 #include <QHash>
-#include <QMutableHashIterator>
+#include <QVector>
 
 #include <functional>
 
 namespace KWaylandServer
 {
 
-static const QString SCREEN_RECORDING_START = QStringLiteral("screenRecordingStart");
-static const QString SCREEN_RECORDING_FINISHED = QStringLiteral("screenRecordingStop");
-static QObject gsScreenRecord;
-
 class BufferHandlePrivate // @see gbm_import_fd_data
 {
 public:
@@ -37,6 +36,8 @@ public:
     quint32 height = 0;
     quint32 stride = 0;
     quint32 format = 0;
+    QRegion damage;
+    bool hasDamage = false;
 };
 
 BufferHandle::BufferHandle()
@@ -94,14 +95,44 @@ quint32 BufferHandle::format() const
     return d->format;
 }
 
+void BufferHandle::setDamage(const QRegion &damage)
+{
+    d->damage = damage;
+    d->hasDamage = true;
+}
+
+QRegion BufferHandle::damage() const
+{
+    if (!d->hasDamage) {
+        return QRect(0, 0, d->width, d->height);
+    }
+    return d->damage;
+}
+
 /**
- * @brief helper struct for manual reference counting.
- * automatic counting via QSharedPointer is no-go here as we hold strong reference in sentBuffers.
+ * @brief A buffer announced to clients, kept until every client holding it is done with it.
  */
 struct BufferHolder
 {
     const BufferHandle *buf;
-    quint64 counter;
+    const OutputInterface *output;
+    // the manager resources holding the buffer, and those of them which did not fetch it yet
+    QVector<wl_resource *> holders;
+    QVector<wl_resource *> unfetched;
+    // when the buffer was announced, in nanoseconds of RemoteAccessManagerInterfacePrivate::clock
+    qint64 announced;
+};
+
+class RemoteAccessSessionPrivate
+{
+public:
+    ClientConnection *client;
+    bool recording = false;
+    quint64 frameCount = 0;
+    quint64 droppedFrameCount = 0;
+    quint64 exportedBytes = 0;
+    qint64 totalLatency = 0;
+    quint64 latencySamples = 0;
 };
 
 class RemoteAccessManagerInterfacePrivate : public QtWaylandServer::org_kde_kwin_remote_access_manager
@@ -116,29 +147,52 @@ public:
      * @param buf buffer containing GBM-related params
      */
     void sendBufferReady(const OutputInterface *output, const BufferHandle *buf);
-    /**
-     * @brief Release all bound buffers associated with this resource
-     * @param resource one of bound clients
-     */
-    void release(wl_resource *resource);
 
     void incrementRenderSequence();
 
+    RemoteAccessManagerInterface::FramePolicy framePolicy(wl_client *client) const;
+
     Display *display;
     int renderSequence = 0;
 
+    int maximumPendingBuffers = 0;
+    int targetFrameRate = 0;
+    RemoteAccessManagerInterface::FramePolicy defaultFramePolicy = RemoteAccessManagerInterface::FramePolicy::DropOldest;
+    QHash<wl_client *, RemoteAccessManagerInterface::FramePolicy> clientFramePolicies;
+    quint64 droppedFrames = 0;
+    quint64 lateFrames = 0;
+
+    QHash<wl_resource *, RemoteAccessSession *> sessions;
+    bool recording = false;
+
 private:
+    virtual void org_kde_kwin_remote_access_manager_bind_resource(Resource *resource) override;
+    virtual void org_kde_kwin_remote_access_manager_destroy_resource(Resource *resource) override;
     virtual void org_kde_kwin_remote_access_manager_get_buffer(Resource *resource, uint32_t buffer, int32_t internal_buffer_id) override;
     virtual void org_kde_kwin_remote_access_manager_release(Resource *resource) override;
     virtual void org_kde_kwin_remote_access_manager_record(Resource *resource, int32_t frame) override;
     virtual void org_kde_kwin_remote_access_manager_get_rendersequence(Resource *resource) override;
 
     /**
-     * @brief Unreferences counter and frees buffer when it reaches zero
-     * @param buf holder to decrease reference counter on
-     * @return true if buffer was released, false otherwise
+     * @brief Drops the reference of @p resource on the buffer @p fd and frees the buffer when
+     * no client holds it anymore
+     */
+    void unref(qint32 fd, wl_resource *resource);
+    /**
+     * @returns The number of buffers of @p output held by @p resource.
+     */
+    int pendingBuffers(const OutputInterface *output, wl_resource *resource) const;
+    /**
+     * @returns Whether the frame may be sent to @p resource according to its frame policy.
+     * Revokes the oldest buffer the client did not fetch yet to make room if allowed to.
+     */
+    bool makeRoom(const OutputInterface *output, wl_resource *resource);
+    void dropFrame(wl_resource *resource);
+    void setRecording(wl_resource *resource, bool recording);
+    /**
+     * Stops the recording of @p resource once it requested no more frames and holds no buffers.
      */
-    bool unref(BufferHolder &buf);
+    void updateRecording(wl_resource *resource);
 
     static const quint32 s_version;
 
@@ -149,7 +203,15 @@ private:
      * Keys are fd numbers as they are unique
      **/
     QHash<qint32, BufferHolder> sentBuffers;
+    // the fds of the buffers in sentBuffers per output, oldest first
+    QHash<const OutputInterface *, QVector<qint32>> outputRings;
     QHash<wl_resource *, qint32> requestFrames;
+    // when the last frame was sent to each manager resource, for pacing to targetFrameRate
+    QHash<wl_resource *, QElapsedTimer> lastFrames;
+    // the damage of each output since the last frame sent to each manager resource, there is
+    // no entry for outputs the resource did not get a frame of yet
+    QHash<wl_resource *, QHash<const OutputInterface *, QRegion>> pendingDamage;
+    QElapsedTimer clock;
 };
 
 const quint32 RemoteAccessManagerInterfacePrivate::s_version = 2;
@@ -159,43 +221,156 @@ RemoteAccessManagerInterfacePrivate::RemoteAccessManagerInterfacePrivate(RemoteA
     , display(display)
     , q(_q)
 {
+    clock.start();
+}
+
+void RemoteAccessManagerInterfacePrivate::dropFrame(wl_resource *resource)
+{
+    ++droppedFrames;
+    if (RemoteAccessSession *session = sessions.value(resource)) {
+        ++session->d->droppedFrameCount;
+    }
+}
+
+void RemoteAccessManagerInterfacePrivate::setRecording(wl_resource *resource, bool recording)
+{
+    RemoteAccessSession *session = sessions.value(resource);
+    if (!session || session->d->recording == recording) {
+        return;
+    }
+    session->d->recording = recording;
+    Q_EMIT session->recordingChanged(recording);
+
+    bool anyRecording = false;
+    for (RemoteAccessSession *other : qAsConst(sessions)) {
+        anyRecording |= other->d->recording;
+    }
+    if (this->recording != anyRecording) {
+        this->recording = anyRecording;
+        Q_EMIT q->screenRecordStatusChanged(anyRecording);
+    }
+}
+
+void RemoteAccessManagerInterfacePrivate::updateRecording(wl_resource *resource)
+{
+    if (requestFrames.value(resource, -1) != 0) {
+        return;
+    }
+    for (const BufferHolder &holder : qAsConst(sentBuffers)) {
+        if (holder.holders.contains(resource)) {
+            return;
+        }
+    }
+    setRecording(resource, false);
+}
+
+RemoteAccessManagerInterface::FramePolicy RemoteAccessManagerInterfacePrivate::framePolicy(wl_client *client) const
+{
+    return clientFramePolicies.value(client, defaultFramePolicy);
+}
+
+int RemoteAccessManagerInterfacePrivate::pendingBuffers(const OutputInterface *output, wl_resource *resource) const
+{
+    int count = 0;
+    const QVector<qint32> ring = outputRings.value(output);
+    for (qint32 fd : ring) {
+        if (sentBuffers[fd].holders.contains(resource)) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+bool RemoteAccessManagerInterfacePrivate::makeRoom(const OutputInterface *output, wl_resource *resource)
+{
+    if (maximumPendingBuffers <= 0 || pendingBuffers(output, resource) < maximumPendingBuffers) {
+        return true;
+    }
+    if (framePolicy(wl_resource_get_client(resource)) == RemoteAccessManagerInterface::FramePolicy::SkipFrame) {
+        return false;
+    }
+    // buffers the client already fetched stay pinned until it releases them
+    const QVector<qint32> ring = outputRings.value(output);
+    for (qint32 fd : ring) {
+        const BufferHolder &holder = sentBuffers[fd];
+        if (holder.unfetched.contains(resource)) {
+            unref(fd, resource);
+            dropFrame(resource);
+            return true;
+        }
+    }
+    return false;
 }
 
 void RemoteAccessManagerInterfacePrivate::sendBufferReady(const OutputInterface *output, const BufferHandle *buf)
 {
-    BufferHolder holder{buf, 0};
+    BufferHolder holder{buf, output, {}, {}, clock.nsecsElapsed()};
+    const QRegion frameDamage = buf->damage();
+    auto outputPrivate = OutputInterfacePrivate::get(const_cast<OutputInterface *>(output));
+    const auto outputResources = outputPrivate->resourceMap();
     // notify clients
     qCDebug(KWAYLAND_SERVER) << "Server buffer sent: fd" << buf->fd();
-    for (auto res : resourceMap()) {
-        auto client = wl_resource_get_client(res->handle);
-        auto boundScreens = output->clientResources(display->getConnection(client));
+    const auto clientResources = resourceMap();
+    for (auto res : clientResources) {
+        // clients don't necessarily bind outputs,
+        // and there is no reason for a client to bind wl_output multiple times, send only to first one
+        auto boundScreen = outputResources.constFind(res->client());
+        if (boundScreen == outputResources.constEnd()) {
+            continue;
+        }
 
-        // clients don't necessarily bind outputs
-        if (boundScreens.isEmpty()) {
+        const int frame = requestFrames.value(res->handle, -1);
+        if (!frame) {
             continue;
         }
 
-        int frame = -1;
-        if (requestFrames.contains(res->handle)) {
-            frame = requestFrames[res->handle];
+        auto &outputDamage = pendingDamage[res->handle];
+        auto pending = outputDamage.find(output);
+        // the first frame of an output is always sent
+        if (pending != outputDamage.end()) {
+            *pending += frameDamage;
+            if (pending->isEmpty()) {
+                // nothing changed since the last frame sent to the client
+                continue;
+            }
+        }
+
+        if (targetFrameRate > 0) {
+            const QElapsedTimer &lastFrame = lastFrames[res->handle];
+            if (lastFrame.isValid() && lastFrame.elapsed() < 1000 / targetFrameRate) {
+                dropFrame(res->handle);
+                continue;
+            }
+        }
+        if (!makeRoom(output, res->handle)) {
+            dropFrame(res->handle);
+            continue;
         }
 
-        if (frame) {
-            // no reason for client to bind wl_output multiple times, send only to first one
-            send_buffer_ready(res->handle, buf->fd(), boundScreens[0]);
-            holder.counter++;
+        send_buffer_ready(res->handle, buf->fd(), (*boundScreen)->handle);
+        holder.holders << res->handle;
+        holder.unfetched << res->handle;
+        outputDamage[output] = QRegion();
+        if (targetFrameRate > 0) {
+            lastFrames[res->handle].start();
         }
         if (frame > 0) {
             requestFrames[res->handle] = frame - 1;
         }
     }
-    if (holder.counter == 0) {
+    if (holder.holders.isEmpty()) {
         // buffer was not requested by any client
         Q_EMIT q->bufferReleased(buf);
         return;
     }
     // store buffer locally, clients will ask it later
+    auto previous = sentBuffers.constFind(buf->fd());
+    if (previous != sentBuffers.constEnd()) {
+        // the fd got reused while the old buffer was still held, the old one is gone now
+        outputRings[previous->output].removeOne(buf->fd());
+    }
     sentBuffers[buf->fd()] = holder;
+    outputRings[output] << buf->fd();
 }
 
 void RemoteAccessManagerInterfacePrivate::incrementRenderSequence()
@@ -203,28 +378,38 @@ void RemoteAccessManagerInterfacePrivate::incrementRenderSequence()
     renderSequence++;
 }
 
-bool RemoteAccessManagerInterfacePrivate::unref(BufferHolder &bh)
+void RemoteAccessManagerInterfacePrivate::unref(qint32 fd, wl_resource *resource)
 {
-    bh.counter--;
-    if (!bh.counter) {
-        // no more clients using this buffer
-        qCDebug(KWAYLAND_SERVER) << "[ut-gfx ]Buffer released, fd" << bh.buf->fd();
-        sentBuffers.remove(bh.buf->fd());
-        Q_EMIT q->bufferReleased(bh.buf);
-        return true;
+    auto it = sentBuffers.find(fd);
+    if (it == sentBuffers.end() || !it->holders.removeOne(resource)) {
+        return;
     }
-    return false;
+    if (!it->unfetched.removeOne(resource)) {
+        // the client fetched the buffer and is done with it now
+        if (RemoteAccessSession *session = sessions.value(resource)) {
+            session->d->totalLatency += (clock.nsecsElapsed() - it->announced) / 1000;
+            ++session->d->latencySamples;
+        }
+    }
+    if (!it->holders.isEmpty()) {
+        return;
+    }
+    // no more clients using this buffer
+    const BufferHandle *buf = it->buf;
+    qCDebug(KWAYLAND_SERVER) << "[ut-gfx ]Buffer released, fd" << fd;
+    auto ring = outputRings.find(it->output);
+    if (ring != outputRings.end()) {
+        ring->removeOne(fd);
+        if (ring->isEmpty()) {
+            outputRings.erase(ring);
+        }
+    }
+    sentBuffers.erase(it);
+    Q_EMIT q->bufferReleased(buf);
 }
 
 void RemoteAccessManagerInterfacePrivate::org_kde_kwin_remote_access_manager_get_buffer(Resource *resource, uint32_t buffer, int32_t internal_buffer_id)
 {
-    // client asks for buffer we earlier announced, we must have it
-    if (Q_UNLIKELY(!this->sentBuffers.contains(internal_buffer_id))) { // no such buffer (?)
-        wl_resource_post_no_memory(resource->handle);
-        return;
-    }
-
-    BufferHolder &bh = sentBuffers[internal_buffer_id];
     wl_resource *RbiResource = wl_resource_create(resource->client(), &org_kde_kwin_remote_buffer_interface, resource->version(), buffer);
 
     if (!RbiResource) {
@@ -233,41 +418,80 @@ void RemoteAccessManagerInterfacePrivate::org_kde_kwin_remote_access_manager_get
         return;
     }
 
-    auto rbuf = new RemoteBufferInterface(bh.buf, RbiResource);
+    // client asks for buffer we earlier announced
+    auto it = sentBuffers.find(internal_buffer_id);
+    if (it == sentBuffers.end() || !it->unfetched.contains(resource->handle)) {
+        // the buffer got revoked in favour of a newer frame while the announcement was in
+        // flight, the client gets a buffer without parameters which it just releases again
+        qCDebug(KWAYLAND_SERVER) << "Remote buffer revoked before it got fetched, fd" << internal_buffer_id;
+        new RemoteBufferInterface(nullptr, RbiResource);
+        return;
+    }
 
-    QObject::connect(rbuf, &QObject::destroyed, [resource, &bh, this] {
-       if (!resourceMap().contains(resource->client())) {
-            // remote buffer destroy confirmed after client is already gone
-            // all relevant buffers are already unreferenced
-            return;
+    BufferHolder &bh = *it;
+    bh.unfetched.removeOne(resource->handle);
+    // a newer frame of the same output was announced before the client came to fetch this one
+    const QVector<qint32> ring = outputRings.value(bh.output);
+    for (int i = ring.indexOf(internal_buffer_id) + 1; i < ring.count(); ++i) {
+        if (sentBuffers[ring[i]].holders.contains(resource->handle)) {
+            ++lateFrames;
+            break;
         }
-        qCDebug(KWAYLAND_SERVER) << "Remote buffer returned, client" << wl_resource_get_id(resource->handle) << ", fd" << bh.buf->fd();
-        unref(bh);
-        gsScreenRecord.setObjectName(SCREEN_RECORDING_FINISHED);
+    }
+
+    auto rbuf = new RemoteBufferInterface(bh.buf, RbiResource);
+
+    wl_resource *managerResource = resource->handle;
+    const qint32 fd = internal_buffer_id;
+    QObject::connect(rbuf, &QObject::destroyed, q, [managerResource, fd, this] {
+        // does nothing if the manager resource is gone already, it released all its buffers then
+        qCDebug(KWAYLAND_SERVER) << "Remote buffer returned, fd" << fd;
+        unref(fd, managerResource);
+        updateRecording(managerResource);
     });
 
     // send buffer params
     rbuf->sendGbmHandle();
 
-    gsScreenRecord.setObjectName(SCREEN_RECORDING_START);
+    if (RemoteAccessSession *session = sessions.value(resource->handle)) {
+        ++session->d->frameCount;
+        session->d->exportedBytes += quint64(bh.buf->stride()) * bh.buf->height();
+    }
+    setRecording(resource->handle, true);
 }
 
-void RemoteAccessManagerInterfacePrivate::org_kde_kwin_remote_access_manager_release(Resource *resource)
+void RemoteAccessManagerInterfacePrivate::org_kde_kwin_remote_access_manager_bind_resource(Resource *resource)
 {
-    // all holders should decrement their counter as one client is gone
-    QMutableHashIterator<qint32, BufferHolder> itr(sentBuffers);
-    while (itr.hasNext()) {
-        BufferHolder &bh = itr.next().value();
-        if (unref(bh)) {
-            itr.remove();
-        }
+    auto session = new RemoteAccessSession(display->getConnection(resource->client()), q);
+    sessions.insert(resource->handle, session);
+    Q_EMIT q->sessionCreated(session);
+}
+
+void RemoteAccessManagerInterfacePrivate::org_kde_kwin_remote_access_manager_destroy_resource(Resource *resource)
+{
+    // all holders should drop the reference of the client that is gone
+    const auto fds = sentBuffers.keys();
+    for (qint32 fd : fds) {
+        unref(fd, resource->handle);
     }
+    requestFrames.remove(resource->handle);
+    lastFrames.remove(resource->handle);
+    pendingDamage.remove(resource->handle);
+    setRecording(resource->handle, false);
+    delete sessions.take(resource->handle);
+}
+
+void RemoteAccessManagerInterfacePrivate::org_kde_kwin_remote_access_manager_release(Resource *resource)
+{
     wl_resource_destroy(resource->handle);
 }
 
 void RemoteAccessManagerInterfacePrivate::org_kde_kwin_remote_access_manager_record(Resource *resource, int32_t frame)
 {
     requestFrames[resource->handle] = frame;
+    lastFrames.remove(resource->handle);
+    pendingDamage.remove(resource->handle);
+    updateRecording(resource->handle);
     emit q->startRecord(frame);
 }
 
@@ -284,9 +508,6 @@ RemoteAccessManagerInterface::RemoteAccessManagerInterface(Display *display)
     : QObject(nullptr)
     , d(new RemoteAccessManagerInterfacePrivate(this, display))
 {
-    connect(&gsScreenRecord, &QObject::objectNameChanged, this, [=](const QString &name) {
-        Q_EMIT screenRecordStatusChanged(name == SCREEN_RECORDING_START);
-    });
 }
 
 RemoteAccessManagerInterface::~RemoteAccessManagerInterface()
@@ -308,6 +529,115 @@ bool RemoteAccessManagerInterface::isBound() const
     return !d->resourceMap().isEmpty();
 }
 
+void RemoteAccessManagerInterface::setMaximumPendingBuffers(int count)
+{
+    d->maximumPendingBuffers = count;
+}
+
+int RemoteAccessManagerInterface::maximumPendingBuffers() const
+{
+    return d->maximumPendingBuffers;
+}
+
+void RemoteAccessManagerInterface::setFramePolicy(FramePolicy policy)
+{
+    d->defaultFramePolicy = policy;
+}
+
+RemoteAccessManagerInterface::FramePolicy RemoteAccessManagerInterface::framePolicy() const
+{
+    return d->defaultFramePolicy;
+}
+
+void RemoteAccessManagerInterface::setFramePolicy(ClientConnection *client, FramePolicy policy)
+{
+    if (!d->clientFramePolicies.contains(client->client())) {
+        connect(client, &ClientConnection::disconnected, this, [this](ClientConnection *client) {
+            d->clientFramePolicies.remove(client->client());
+        });
+    }
+    d->clientFramePolicies[client->client()] = policy;
+}
+
+RemoteAccessManagerInterface::FramePolicy RemoteAccessManagerInterface::framePolicy(ClientConnection *client) const
+{
+    return d->framePolicy(client->client());
+}
+
+void RemoteAccessManagerInterface::setTargetFrameRate(int fps)
+{
+    d->targetFrameRate = fps;
+}
+
+int RemoteAccessManagerInterface::targetFrameRate() const
+{
+    return d->targetFrameRate;
+}
+
+quint64 RemoteAccessManagerInterface::droppedFrames() const
+{
+    return d->droppedFrames;
+}
+
+quint64 RemoteAccessManagerInterface::lateFrames() const
+{
+    return d->lateFrames;
+}
+
+QVector<RemoteAccessSession *> RemoteAccessManagerInterface::sessions() const
+{
+    return d->sessions.values().toVector();
+}
+
+bool RemoteAccessManagerInterface::isRecording() const
+{
+    return d->recording;
+}
+
+RemoteAccessSession::RemoteAccessSession(ClientConnection *client, QObject *parent)
+    : QObject(parent)
+    , d(new RemoteAccessSessionPrivate)
+{
+    d->client = client;
+}
+
+RemoteAccessSession::~RemoteAccessSession()
+{
+}
+
+ClientConnection *RemoteAccessSession::client() const
+{
+    return d->client;
+}
+
+bool RemoteAccessSession::isRecording() const
+{
+    return d->recording;
+}
+
+quint64 RemoteAccessSession::frameCount() const
+{
+    return d->frameCount;
+}
+
+quint64 RemoteAccessSession::droppedFrameCount() const
+{
+    return d->droppedFrameCount;
+}
+
+quint64 RemoteAccessSession::exportedBytes() const
+{
+    return d->exportedBytes;
+}
+
+qint64 RemoteAccessSession::averageLatency() const
+{
+    if (!d->latencySamples) {
+        return 0;
+    }
+    return d->totalLatency / qint64(d->latencySamples);
+}
+
 class RemoteBufferInterfacePrivate : public QtWaylandServer::org_kde_kwin_remote_buffer
 {
 public:
@@ -9,6 +9,8 @@
 #include <DWayland/Server/kwaylandserver_export.h>
 
 #include <QObject>
+#include <QRegion>
+#include <QVector>
 
 struct wl_resource;
 
@@ -16,6 +18,8 @@ namespace KWaylandServer
 {
 
 class RemoteAccessManagerInterfacePrivate;
+class RemoteAccessSessionPrivate;
+class ClientConnection;
 class Display;
 class OutputInterface;
 class BufferHandlePrivate;
@@ -49,6 +53,14 @@ public:
     quint32 width() const;
     quint32 stride() const;
     quint32 format() const;
+    /**
+     * Sets the region of the buffer which changed since the previous buffer of the same output.
+     * Frames without changes are not sent to clients which got the previous one. Without
+     * damage the whole buffer is considered changed.
+     * @since 5.24
+     **/
+    void setDamage(const QRegion &damage);
+    QRegion damage() const;
 
 private:
     friend class RemoteAccessManagerInterface;
@@ -56,6 +68,52 @@ private:
     QScopedPointer<BufferHandlePrivate> d;
 };
 
+/**
+ * @brief A client bound to the RemoteAccessManagerInterface.
+ *
+ * A session is recording from the first buffer the client fetches until it requested no more
+ * frames and returned all buffers, or until it goes away. The statistics cover the whole
+ * lifetime of the session.
+ *
+ * @see RemoteAccessManagerInterface::sessions
+ * @since 5.24
+ **/
+class KWAYLANDSERVER_EXPORT RemoteAccessSession : public QObject
+{
+    Q_OBJECT
+public:
+    ~RemoteAccessSession() override;
+
+    ClientConnection *client() const;
+    bool isRecording() const;
+    /**
+     * @returns The number of buffers the client fetched.
+     **/
+    quint64 frameCount() const;
+    /**
+     * @returns The number of frames skipped or revoked for this client.
+     * @see RemoteAccessManagerInterface::droppedFrames
+     **/
+    quint64 droppedFrameCount() const;
+    /**
+     * @returns The size of the buffers the client fetched in bytes.
+     **/
+    quint64 exportedBytes() const;
+    /**
+     * @returns The average time in microseconds from announcing a buffer until the client
+     * returned it, over all buffers the client fetched and returned.
+     **/
+    qint64 averageLatency() const;
+
+Q_SIGNALS:
+    void recordingChanged(bool recording);
+
+private:
+    explicit RemoteAccessSession(ClientConnection *client, QObject *parent);
+    friend class RemoteAccessManagerInterfacePrivate;
+    QScopedPointer<RemoteAccessSessionPrivate> d;
+};
+
 class KWAYLANDSERVER_EXPORT RemoteAccessManagerInterface : public QObject
 {
     Q_OBJECT
@@ -63,6 +121,26 @@ public:
     explicit RemoteAccessManagerInterface(Display *display);
     ~RemoteAccessManagerInterface();
 
+    /**
+     * What to do with a new frame for a client which holds maximumPendingBuffers buffers
+     * of the output already.
+     * @since 5.24
+     **/
+    enum class FramePolicy {
+        /**
+         * Revoke the oldest buffer the client did not fetch yet and send the new one.
+         * Buffers the client already fetched are never revoked. If the client requests a
+         * revoked buffer because its announcement was already on the way, the client gets
+         * a buffer which never receives its parameters and still has to release it.
+         **/
+        DropOldest,
+        /**
+         * Do not send the new frame to the client.
+         **/
+        SkipFrame,
+    };
+    Q_ENUM(FramePolicy)
+
     /**
      * Store buffer in sent list and notify client that we have a buffer for it
      **/
@@ -75,12 +153,74 @@ public:
      * Check whether interface has been bound
      **/
     bool isBound() const;
+
+    /**
+     * Sets how many buffers of one output a client may hold at most. A value of 0 or less,
+     * the default, disables the limit and thus the FramePolicy.
+     * @since 5.24
+     **/
+    void setMaximumPendingBuffers(int count);
+    int maximumPendingBuffers() const;
+    /**
+     * Sets the policy used for clients without a policy of their own, by default DropOldest.
+     * @since 5.24
+     **/
+    void setFramePolicy(FramePolicy policy);
+    FramePolicy framePolicy() const;
+    /**
+     * Sets the policy used for frames sent to @p client.
+     * @since 5.24
+     **/
+    void setFramePolicy(ClientConnection *client, FramePolicy policy);
+    FramePolicy framePolicy(ClientConnection *client) const;
+    /**
+     * Limits the frames sent to each client to @p fps frames per second, frames coming in
+     * faster are skipped. The rate applies from the next record request of a client on.
+     * A value of 0, the default, sends every frame.
+     * @since 5.24
+     **/
+    void setTargetFrameRate(int fps);
+    int targetFrameRate() const;
+    /**
+     * @returns The number of frames which were skipped or revoked from a client, because of
+     * the target frame rate or because the client held too many buffers.
+     * @since 5.24
+     **/
+    quint64 droppedFrames() const;
+    /**
+     * @returns The number of buffers fetched by a client after a newer frame of the same
+     * output was announced to it already.
+     * @since 5.24
+     **/
+    quint64 lateFrames() const;
+
+    /**
+     * @returns The sessions of the clients bound to this interface.
+     * @since 5.24
+     **/
+    QVector<RemoteAccessSession *> sessions() const;
+    /**
+     * @returns Whether any of the sessions is recording.
+     * @since 5.24
+     **/
+    bool isRecording() const;
+
 Q_SIGNALS:
     /**
      * Previously sent buffer has been released by client
      */
     void bufferReleased(const BufferHandle *buf);
+    /**
+     * Emitted when the first session starts recording or the last one stops.
+     * @see isRecording
+     **/
     void screenRecordStatusChanged(bool isScreenRecording);
+    /**
+     * Emitted when a client bound the interface. The session is deleted when the client
+     * releases the interface.
+     * @since 5.24
+     **/
+    void sessionCreated(KWaylandServer::RemoteAccessSession *session);
     void startRecord(int count);
 
 private:
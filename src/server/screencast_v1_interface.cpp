@@ -9,6 +9,9 @@
 #include "output_interface.h"
 
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QTimer>
 
 #include "qwayland-server-zkde-screencast-unstable-v1.h"
 
@@ -22,6 +25,36 @@ public:
     ScreencastStreamV1InterfacePrivate(ScreencastStreamV1Interface *q)
         : q(q)
     {
+        paceTimer.setSingleShot(true);
+        // a coarse timer may fire before the target frame rate allows the next frame
+        paceTimer.setTimerType(Qt::PreciseTimer);
+        QObject::connect(&paceTimer, &QTimer::timeout, q, [this] {
+            if (this->q->isFrameWanted()) {
+                Q_EMIT this->q->frameWanted();
+            }
+        });
+    }
+
+    /**
+     * @returns How long to wait until the target frame rate allows the next frame, in milliseconds.
+     */
+    qint64 paceDelay() const
+    {
+        if (targetFrameRate <= 0 || !lastFrame.isValid()) {
+            return 0;
+        }
+        return qMax(qint64(0), qint64(1000 / targetFrameRate) - lastFrame.elapsed());
+    }
+
+    bool updateCursorVisible()
+    {
+        const QRectF cursorRect(cursorPosition - cursorHotspot, cursorImage.size() / cursorImage.devicePixelRatio());
+        const bool visible = QRectF(region).intersects(cursorRect) || (cursorImage.isNull() && region.contains(cursorPosition.toPoint()));
+        if (cursorVisible == visible) {
+            return false;
+        }
+        cursorVisible = visible;
+        return true;
     }
 
     void zkde_screencast_stream_unstable_v1_destroy_resource(Resource *resource) override
@@ -30,6 +63,8 @@ public:
         if (!stopped) {
             Q_EMIT q->finished();
         }
+        stopped = true;
+        paceTimer.stop();
 
         q->deleteLater();
     }
@@ -43,6 +78,25 @@ public:
     }
 
     bool stopped = false;
+    bool created = false;
+    ScreencastStreamV1Interface::SourceType sourceType = ScreencastStreamV1Interface::SourceType::Output;
+    QPointer<OutputInterface> output;
+    QString windowUuid;
+    QString virtualOutputName;
+    ScreencastV1Interface::CursorMode cursorMode = ScreencastV1Interface::Hidden;
+    QRect region;
+
+    qreal targetFrameRate = 0;
+    bool frameRequested = false;
+    QElapsedTimer lastFrame;
+    QTimer paceTimer;
+
+    // in global coordinates
+    QPointF cursorPosition;
+    QImage cursorImage;
+    QPoint cursorHotspot;
+    bool cursorVisible = false;
+
     ScreencastStreamV1Interface *const q;
 };
 
@@ -57,11 +111,17 @@ ScreencastStreamV1Interface::~ScreencastStreamV1Interface() = default;
 void ScreencastStreamV1Interface::sendCreated(quint32 nodeid)
 {
     d->send_created(nodeid);
+    d->created = true;
+    if (isFrameWanted()) {
+        Q_EMIT frameWanted();
+    }
 }
 
 void ScreencastStreamV1Interface::sendFailed(const QString &error)
 {
     d->send_failed(error);
+    d->stopped = true;
+    d->paceTimer.stop();
 }
 
 void ScreencastStreamV1Interface::sendClosed()
@@ -69,6 +129,148 @@ void ScreencastStreamV1Interface::sendClosed()
     if (!d->stopped) {
         d->send_closed();
     }
+    d->stopped = true;
+    d->paceTimer.stop();
+}
+
+ScreencastStreamV1Interface::SourceType ScreencastStreamV1Interface::sourceType() const
+{
+    return d->sourceType;
+}
+
+OutputInterface *ScreencastStreamV1Interface::output() const
+{
+    return d->output;
+}
+
+QString ScreencastStreamV1Interface::windowUuid() const
+{
+    return d->windowUuid;
+}
+
+QString ScreencastStreamV1Interface::virtualOutputName() const
+{
+    return d->virtualOutputName;
+}
+
+ScreencastV1Interface::CursorMode ScreencastStreamV1Interface::cursorMode() const
+{
+    return d->cursorMode;
+}
+
+void ScreencastStreamV1Interface::setRegion(const QRect &region)
+{
+    if (d->region == region) {
+        return;
+    }
+    d->region = region;
+    if (d->cursorMode == ScreencastV1Interface::Metadata) {
+        CursorChanges changes = CursorChange::Position;
+        if (d->updateCursorVisible()) {
+            changes |= CursorChange::Visibility;
+        }
+        Q_EMIT cursorChanged(changes);
+    }
+}
+
+QRect ScreencastStreamV1Interface::region() const
+{
+    return d->region;
+}
+
+void ScreencastStreamV1Interface::setTargetFrameRate(qreal fps)
+{
+    d->targetFrameRate = fps;
+}
+
+qreal ScreencastStreamV1Interface::targetFrameRate() const
+{
+    return d->targetFrameRate;
+}
+
+void ScreencastStreamV1Interface::requestFrame()
+{
+    if (d->frameRequested) {
+        return;
+    }
+    d->frameRequested = true;
+    if (!d->created || d->stopped) {
+        return;
+    }
+    const qint64 delay = d->paceDelay();
+    if (delay > 0) {
+        d->paceTimer.start(delay);
+    } else {
+        Q_EMIT frameWanted();
+    }
+}
+
+bool ScreencastStreamV1Interface::isFrameWanted() const
+{
+    return d->created && !d->stopped && d->frameRequested && d->paceDelay() == 0;
+}
+
+void ScreencastStreamV1Interface::frameSent()
+{
+    d->frameRequested = false;
+    d->paceTimer.stop();
+    d->lastFrame.start();
+}
+
+void ScreencastStreamV1Interface::setCursorPosition(const QPointF &position)
+{
+    if (d->cursorMode != ScreencastV1Interface::Metadata || d->cursorPosition == position) {
+        return;
+    }
+    d->cursorPosition = position;
+    CursorChanges changes;
+    if (d->updateCursorVisible()) {
+        changes |= CursorChange::Visibility;
+    }
+    // moving outside of the region is not interesting for the consumer
+    if (d->cursorVisible) {
+        changes |= CursorChange::Position;
+    }
+    if (changes) {
+        Q_EMIT cursorChanged(changes);
+    }
+}
+
+void ScreencastStreamV1Interface::setCursorImage(const QImage &image, const QPoint &hotspot)
+{
+    if (d->cursorMode != ScreencastV1Interface::Metadata) {
+        return;
+    }
+    if (d->cursorHotspot == hotspot && d->cursorImage.cacheKey() == image.cacheKey()) {
+        return;
+    }
+    d->cursorImage = image;
+    d->cursorHotspot = hotspot;
+    CursorChanges changes = CursorChange::Shape;
+    if (d->updateCursorVisible()) {
+        changes |= CursorChange::Visibility;
+    }
+    Q_EMIT cursorChanged(changes);
+}
+
+QPointF ScreencastStreamV1Interface::cursorPosition() const
+{
+    return d->cursorPosition - d->region.topLeft();
+}
+
+QImage ScreencastStreamV1Interface::cursorImage() const
+{
+    return d->cursorImage;
+}
+
+QPoint ScreencastStreamV1Interface::cursorHotspot() const
+{
+    return d->cursorHotspot;
+}
+
+bool ScreencastStreamV1Interface::isCursorVisible() const
+{
+    return d->cursorVisible;
 }
 
 class ScreencastV1InterfacePrivate : public QtWaylandServer::zkde_screencast_unstable_v1
@@ -80,21 +282,31 @@ public:
     {
     }
 
-    ScreencastStreamV1Interface *createStream(Resource *resource, quint32 streamid) const
+    ScreencastStreamV1Interface *createStream(Resource *resource, quint32 streamid, ScreencastStreamV1Interface::SourceType type, uint32_t pointer) const
     {
         auto stream = new ScreencastStreamV1Interface(q);
         stream->d->init(resource->client(), streamid, resource->version());
+        stream->d->sourceType = type;
+        stream->d->cursorMode = ScreencastV1Interface::CursorMode(pointer);
         return stream;
     }
 
     void zkde_screencast_unstable_v1_stream_output(Resource *resource, uint32_t streamid, struct ::wl_resource *output, uint32_t pointer) override
     {
-        Q_EMIT q->outputScreencastRequested(createStream(resource, streamid), OutputInterface::get(output), ScreencastV1Interface::CursorMode(pointer));
+        auto stream = createStream(resource, streamid, ScreencastStreamV1Interface::SourceType::Output, pointer);
+        OutputInterface *outputInterface = OutputInterface::get(output);
+        stream->d->output = outputInterface;
+        if (outputInterface) {
+            stream->d->region = QRect(outputInterface->globalPosition(), outputInterface->pixelSize() / outputInterface->scale());
+        }
+        Q_EMIT q->outputScreencastRequested(stream, outputInterface, ScreencastV1Interface::CursorMode(pointer));
     }
 
     void zkde_screencast_unstable_v1_stream_window(Resource *resource, uint32_t streamid, const QString &uuid, uint32_t pointer) override
     {
-        Q_EMIT q->windowScreencastRequested(createStream(resource, streamid), uuid, ScreencastV1Interface::CursorMode(pointer));
+        auto stream = createStream(resource, streamid, ScreencastStreamV1Interface::SourceType::Window, pointer);
+        stream->d->windowUuid = uuid;
+        Q_EMIT q->windowScreencastRequested(stream, uuid, ScreencastV1Interface::CursorMode(pointer));
     }
     void zkde_screencast_unstable_v1_stream_virtual_output(Resource *resource,
                                                            uint32_t streamid,
@@ -104,7 +316,10 @@ public:
                                                            wl_fixed_t scale,
                                                            uint32_t pointer) override
     {
-        Q_EMIT q->virtualOutputScreencastRequested(createStream(resource, streamid),
+        auto stream = createStream(resource, streamid, ScreencastStreamV1Interface::SourceType::VirtualOutput, pointer);
+        stream->d->virtualOutputName = name;
+        stream->d->region = QRect(0, 0, width, height);
+        Q_EMIT q->virtualOutputScreencastRequested(stream,
                                                    name,
                                                    {width, height},
                                                    wl_fixed_to_double(scale),
@@ -7,7 +7,9 @@
 #pragma once
 
 #include <DWayland/Server/kwaylandserver_export.h>
+#include <QImage>
 #include <QObject>
+#include <QRect>
 #include <QScopedPointer>
 
 struct wl_resource;
@@ -20,25 +22,6 @@ class ScreencastV1InterfacePrivate;
 class ScreencastStreamV1InterfacePrivate;
 class ScreencastStreamV1Interface;
 
-class KWAYLANDSERVER_EXPORT ScreencastStreamV1Interface : public QObject
-{
-    Q_OBJECT
-public:
-    ~ScreencastStreamV1Interface() override;
-
-    void sendCreated(quint32 nodeid);
-    void sendFailed(const QString &error);
-    void sendClosed();
-
-Q_SIGNALS:
-    void finished();
-
-private:
-    friend class ScreencastV1InterfacePrivate;
-    explicit ScreencastStreamV1Interface(QObject *parent);
-    QScopedPointer<ScreencastStreamV1InterfacePrivate> d;
-};
-
 class KWAYLANDSERVER_EXPORT ScreencastV1Interface : public QObject
 {
     Q_OBJECT
@@ -63,4 +46,144 @@ private:
     QScopedPointer<ScreencastV1InterfacePrivate> d;
 };
 
+/**
+ * @brief A stream requested through ScreencastV1Interface.
+ *
+ * Besides what was requested, the stream keeps track of the region it captures and of whether
+ * its consumer is ready for another frame, so the compositor only renders captures which are
+ * going to be used. The consumer asks for frames with requestFrame, the compositor renders
+ * when frameWanted is emitted and calls frameSent once the frame was handed over.
+ *
+ * With CursorMode::Metadata the cursor is not part of the frames, the compositor passes the
+ * cursor to setCursorPosition and setCursorImage and sends the metadata on cursorChanged
+ * instead of rendering a new frame.
+ */
+class KWAYLANDSERVER_EXPORT ScreencastStreamV1Interface : public QObject
+{
+    Q_OBJECT
+public:
+    ~ScreencastStreamV1Interface() override;
+
+    enum class SourceType {
+        Output,
+        VirtualOutput,
+        Window,
+    };
+    Q_ENUM(SourceType)
+
+    enum class CursorChange {
+        Position = 1 << 0,
+        Shape = 1 << 1,
+        Visibility = 1 << 2,
+    };
+    Q_DECLARE_FLAGS(CursorChanges, CursorChange)
+    Q_FLAG(CursorChanges)
+
+    void sendCreated(quint32 nodeid);
+    void sendFailed(const QString &error);
+    void sendClosed();
+
+    /**
+     * @since 5.24
+     */
+    SourceType sourceType() const;
+    /**
+     * @returns The captured output for SourceType::Output, @c null for other sources or once
+     * the output is gone.
+     * @since 5.24
+     */
+    OutputInterface *output() const;
+    /**
+     * @returns The uuid of the captured window for SourceType::Window.
+     * @since 5.24
+     */
+    QString windowUuid() const;
+    /**
+     * @returns The name of the virtual output for SourceType::VirtualOutput.
+     * @since 5.24
+     */
+    QString virtualOutputName() const;
+    /**
+     * @since 5.24
+     */
+    ScreencastV1Interface::CursorMode cursorMode() const;
+
+    /**
+     * Sets the captured region in global compositor coordinates. For outputs this is the
+     * geometry of the output when the stream was requested, for virtual outputs the requested
+     * size at the origin.
+     * @since 5.24
+     */
+    void setRegion(const QRect &region);
+    QRect region() const;
+    /**
+     * Limits how often frameWanted is emitted, 0 means as often as the consumer asks.
+     * @since 5.24
+     */
+    void setTargetFrameRate(qreal fps);
+    qreal targetFrameRate() const;
+
+    /**
+     * Called when the consumer of the stream is ready for another frame.
+     * @since 5.24
+     */
+    void requestFrame();
+    /**
+     * @returns Whether the consumer is ready for a frame and the target frame rate allows
+     * to send one now.
+     * @since 5.24
+     */
+    bool isFrameWanted() const;
+    /**
+     * Called after a frame was handed to the consumer.
+     * @since 5.24
+     */
+    void frameSent();
+
+    /**
+     * Updates the cursor position in global compositor coordinates. Ignored unless the cursor
+     * mode is CursorMode::Metadata.
+     * @since 5.24
+     */
+    void setCursorPosition(const QPointF &position);
+    /**
+     * Updates the cursor shape. Ignored unless the cursor mode is CursorMode::Metadata.
+     * @since 5.24
+     */
+    void setCursorImage(const QImage &image, const QPoint &hotspot);
+    /**
+     * @returns The cursor position relative to the region.
+     * @since 5.24
+     */
+    QPointF cursorPosition() const;
+    QImage cursorImage() const;
+    QPoint cursorHotspot() const;
+    /**
+     * @returns Whether the cursor image intersects the region.
+     * @since 5.24
+     */
+    bool isCursorVisible() const;
+
+Q_SIGNALS:
+    void finished();
+    /**
+     * Emitted when the stream wants a frame, the compositor should render one then.
+     * @since 5.24
+     */
+    void frameWanted();
+    /**
+     * Emitted when the cursor metadata changed.
+     * @since 5.24
+     */
+    void cursorChanged(KWaylandServer::ScreencastStreamV1Interface::CursorChanges changes);
+
+private:
+    friend class ScreencastV1InterfacePrivate;
+    explicit ScreencastStreamV1Interface(QObject *parent);
+    QScopedPointer<ScreencastStreamV1InterfacePrivate> d;
+};
+
 }
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(KWaylandServer::ScreencastStreamV1Interface::CursorChanges)
+Q_DECLARE_METATYPE(KWaylandServer::ScreencastStreamV1Interface::CursorChanges)
@@ -11,6 +11,7 @@
 #include "datacontrolsource_v1_interface.h"
 #include "datadevice_interface.h"
 #include "datadevice_interface_p.h"
+#include "datasourcemimetypes_p.h"
 #include "datasource_interface.h"
 #include "display.h"
 #include "display_p.h"
@@ -38,6 +39,7 @@
 namespace KWaylandServer
 {
 static const int s_version = 7;
+static const QByteArray s_onlyReplaceEmpty = QByteArrayLiteral("application/x-kde-onlyReplaceEmpty");
 
 SeatInterfacePrivate *SeatInterfacePrivate::get(SeatInterface *seat)
 {
@@ -144,21 +146,25 @@ QVector<DataDeviceInterface *> SeatInterfacePrivate::dataDevicesForSurface(Surfa
     if (!surface) {
         return {};
     }
-    QVector<DataDeviceInterface *> primarySelectionDevices;
-    for (auto it = dataDevices.constBegin(); it != dataDevices.constEnd(); ++it) {
-        if ((*it)->client() == *surface->client()) {
-            primarySelectionDevices << *it;
-        }
-    }
-    return primarySelectionDevices;
+    return clientDataDevices.value(*surface->client());
 }
 
 void SeatInterfacePrivate::registerDataDevice(DataDeviceInterface *dataDevice)
 {
     Q_ASSERT(dataDevice->seat() == q);
     dataDevices << dataDevice;
-    auto dataDeviceCleanup = [this, dataDevice] {
+    // the resource is gone by the time the device is destroyed
+    wl_client *client = dataDevice->client();
+    clientDataDevices[client] << dataDevice;
+    auto dataDeviceCleanup = [this, dataDevice, client] {
         dataDevices.removeOne(dataDevice);
+        auto it = clientDataDevices.find(client);
+        if (it != clientDataDevices.end()) {
+            it->removeOne(dataDevice);
+            if (it->isEmpty()) {
+                clientDataDevices.erase(it);
+            }
+        }
         globalKeyboard.focus.selections.removeOne(dataDevice);
     };
     QObject::connect(dataDevice, &QObject::destroyed, q, dataDeviceCleanup);
@@ -180,7 +186,7 @@ void SeatInterfacePrivate::registerDataDevice(DataDeviceInterface *dataDevice)
         if (*globalKeyboard.focus.surface->client() == dataDevice->client()) {
             globalKeyboard.focus.selections.append(dataDevice);
             if (currentSelection) {
-                dataDevice->sendSelection(currentSelection);
+                dataDevice->updateSelection(currentSelection, selectionGeneration);
             }
         }
     }
@@ -208,7 +214,7 @@ void SeatInterfacePrivate::registerDataControlDevice(DataControlDeviceV1Interfac
         // Special klipper workaround to avoid a race
         // If the mimetype x-kde-onlyReplaceEmpty is set, and we've had another update in the meantime, do nothing
         // See https://github.com/swaywm/wlr-protocols/issues/92
-        if (dataDevice->selection() && dataDevice->selection()->mimeTypes().contains(QLatin1String("application/x-kde-onlyReplaceEmpty")) && currentSelection) {
+        if (dataDevice->selection() && DataSourceMimeTypes::get(dataDevice->selection())->contains(s_onlyReplaceEmpty) && currentSelection) {
             dataDevice->selection()->cancel();
             return;
         }
@@ -228,7 +234,7 @@ void SeatInterfacePrivate::registerDataControlDevice(DataControlDeviceV1Interfac
         // Special klipper workaround to avoid a race
         // If the mimetype x-kde-onlyReplaceEmpty is set, and we've had another update in the meantime, do nothing
         // See https://github.com/swaywm/wlr-protocols/issues/92
-        if (dataDevice->primarySelection() && dataDevice->primarySelection()->mimeTypes().contains(QLatin1String("application/x-kde-onlyReplaceEmpty"))
+        if (dataDevice->primarySelection() && DataSourceMimeTypes::get(dataDevice->primarySelection())->contains(s_onlyReplaceEmpty)
             && currentPrimarySelection) {
             dataDevice->primarySelection()->cancel();
             return;
@@ -237,10 +243,10 @@ void SeatInterfacePrivate::registerDataControlDevice(DataControlDeviceV1Interfac
     });
 
     if (currentSelection) {
-        dataDevice->sendSelection(currentSelection);
+        dataDevice->updateSelection(currentSelection, selectionGeneration);
     }
     if (currentPrimarySelection) {
-        dataDevice->sendPrimarySelection(currentPrimarySelection);
+        dataDevice->updatePrimarySelection(currentPrimarySelection, primarySelectionGeneration);
     }
 }
 
@@ -266,7 +272,7 @@ void SeatInterfacePrivate::registerPrimarySelectionDevice(PrimarySelectionDevice
         if (*globalKeyboard.focus.surface->client() == primarySelectionDevice->client()) {
             globalKeyboard.focus.primarySelections.append(primarySelectionDevice);
             if (currentPrimarySelection) {
-                primarySelectionDevice->sendSelection(currentPrimarySelection);
+                primarySelectionDevice->updateSelection(currentPrimarySelection, primarySelectionGeneration);
             }
         }
     }
@@ -533,6 +539,16 @@ void SeatInterface::setDragTarget(AbstractDropHandler *dropTarget,
     return;
 }
 
+void SeatInterface::setDragMotionInterval(int msec)
+{
+    d->dragMotionInterval = qMax(0, msec);
+}
+
+int SeatInterface::dragMotionInterval() const
+{
+    return d->dragMotionInterval;
+}
+
 void SeatInterface::setDragTarget(AbstractDropHandler *target, SurfaceInterface *surface, const QMatrix4x4 &inputTransformation)
 {
     if (d->drag.mode == SeatInterfacePrivate::Drag::Mode::Pointer) {
@@ -935,12 +951,9 @@ void SeatInterface::setFocusedKeyboardSurface(SurfaceInterface *surface)
         // selection?
         const QVector<DataDeviceInterface *> dataDevices = d->dataDevicesForSurface(surface);
         d->globalKeyboard.focus.selections = dataDevices;
+        // devices which still hold the offer for the current selection are not sent it again
         for (auto dataDevice : dataDevices) {
-            if (d->currentSelection) {
-                dataDevice->sendSelection(d->currentSelection);
-            } else {
-                dataDevice->sendClearSelection();
-            }
+            dataDevice->updateSelection(d->currentSelection, d->selectionGeneration);
         }
         // primary selection
         QVector<PrimarySelectionDeviceV1Interface *> primarySelectionDevices;
@@ -952,11 +965,7 @@ void SeatInterface::setFocusedKeyboardSurface(SurfaceInterface *surface)
 
         d->globalKeyboard.focus.primarySelections = primarySelectionDevices;
         for (auto primaryDataDevice : primarySelectionDevices) {
-            if (d->currentPrimarySelection) {
-                primaryDataDevice->sendSelection(d->currentPrimarySelection);
-            } else {
-                primaryDataDevice->sendClearSelection();
-            }
+            primaryDataDevice->updateSelection(d->currentPrimarySelection, d->primarySelectionGeneration);
         }
     }
 
@@ -1304,25 +1313,41 @@ void SeatInterface::setSelection(AbstractDataSource *selection)
         d->currentSelection = d->currentCachedSelection;
     }
 
+    ++d->selectionGeneration;
+
+    if (d->selectionCache) {
+        d->selectionCache->setSource(d->currentSelection);
+    }
+
     for (auto focussedSelection : qAsConst(d->globalKeyboard.focus.selections)) {
-        if (d->currentSelection) {
-            focussedSelection->sendSelection(d->currentSelection);
-        } else {
-            focussedSelection->sendClearSelection();
-        }
+        focussedSelection->updateSelection(d->currentSelection, d->selectionGeneration);
     }
 
     for (auto control : qAsConst(d->dataControlDevices)) {
-        if (selection) {
-            control->sendSelection(selection);
-        } else {
-            control->sendClearSelection();
-        }
+        control->updateSelection(selection, d->selectionGeneration);
     }
 
     Q_EMIT selectionChanged(selection);
 }
 
+void SeatInterface::setSelectionCacheSize(qint64 size)
+{
+    if (size <= 0) {
+        d->selectionCache.reset();
+        return;
+    }
+    if (!d->selectionCache) {
+        d->selectionCache.reset(new SelectionCache);
+        d->selectionCache->setSource(d->currentSelection);
+    }
+    d->selectionCache->setMaximumSize(size);
+}
+
+qint64 SeatInterface::selectionCacheSize() const
+{
+    return d->selectionCache ? d->selectionCache->maximumSize() : 0;
+}
+
 AbstractDataSource *SeatInterface::primarySelection() const
 {
     return d->currentPrimarySelection;
@@ -1346,20 +1371,13 @@ void SeatInterface::setPrimarySelection(AbstractDataSource *selection)
     }
 
     d->currentPrimarySelection = selection;
+    ++d->primarySelectionGeneration;
 
     for (auto focussedSelection : qAsConst(d->globalKeyboard.focus.primarySelections)) {
-        if (selection) {
-            focussedSelection->sendSelection(selection);
-        } else {
-            focussedSelection->sendClearSelection();
-        }
+        focussedSelection->updateSelection(selection, d->primarySelectionGeneration);
     }
     for (auto control : qAsConst(d->dataControlDevices)) {
-        if (selection) {
-            control->sendPrimarySelection(selection);
-        } else {
-            control->sendClearPrimarySelection();
-        }
+        control->updatePrimarySelection(selection, d->primarySelectionGeneration);
     }
 
     Q_EMIT primarySelectionChanged(selection);
@@ -1390,8 +1408,9 @@ void SeatInterface::startDrag(AbstractDataSource *dragSource, SurfaceInterface *
     }
     d->drag.dragIcon = dragIcon;
 
-    if (!d->dataDevicesForSurface(originSurface).isEmpty()) {
-        d->drag.target = d->dataDevicesForSurface(originSurface)[0];
+    const QVector<DataDeviceInterface *> originDevices = d->dataDevicesForSurface(originSurface);
+    if (!originDevices.isEmpty()) {
+        d->drag.target = originDevices.first();
     }
     if (d->drag.target) {
         d->drag.target->updateDragTarget(originSurface, dragSerial);
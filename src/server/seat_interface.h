@@ -225,6 +225,20 @@ public:
      * The enter position is derived from current global position and transformed by @p inputTransformation.
      */
     void setDragTarget(AbstractDropHandler *dropTarget, SurfaceInterface *surface, const QMatrix4x4 &inputTransformation = QMatrix4x4());
+    /**
+     * Limits the drag motion events sent to the drag target to one per @p msec, e.g. the refresh
+     * interval of the output the drag happens on. Motion in between is coalesced, the latest
+     * position is sent once the interval elapsed and before a drop. The default of @c 0 sends
+     * each motion right away.
+     * @since 5.24
+     */
+    void setDragMotionInterval(int msec);
+    /**
+     * @returns The minimum time in msec between two drag motion events.
+     * @see setDragMotionInterval
+     * @since 5.24
+     */
+    int dragMotionInterval() const;
     ///@}
 
     AbstractDropHandler *dropHandlerForSurface(SurfaceInterface *surface) const;
@@ -660,6 +674,24 @@ public:
 
     void updateCachedSelection(AbstractDataSource *selection);
 
+    /**
+     * Enables keeping the content of the clipboard selection in the compositor. Each mime
+     * type is requested once from the selection's source and all further requests for it
+     * are served by the compositor, even if the source is busy.
+     *
+     * @param size The maximum size in bytes of the content kept per mime type, larger
+     * content is always requested from the source. @c 0 disables the cache, which is the default.
+     * @see selectionCacheSize
+     * @since 5.24
+     */
+    void setSelectionCacheSize(qint64 size);
+    /**
+     * @returns The maximum size of the content kept per mime type of the clipboard selection.
+     * @see setSelectionCacheSize
+     * @since 5.24
+     */
+    qint64 selectionCacheSize() const;
+
     KWaylandServer::AbstractDataSource *primarySelection() const;
     void setPrimarySelection(AbstractDataSource *selection);
 
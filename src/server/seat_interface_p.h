@@ -8,6 +8,7 @@
 
 // KWayland
 #include "seat_interface.h"
+#include "selectioncache_p.h"
 // Qt
 #include <QHash>
 #include <QMap>
@@ -52,6 +53,9 @@ public:
     QScopedPointer<PointerInterface> pointer;
     QScopedPointer<TouchInterface> touch;
     QVector<DataDeviceInterface *> dataDevices;
+    // the data devices of each client, so that looking them up during drag'n'drop motion is cheap
+    QHash<wl_client *, QVector<DataDeviceInterface *>> clientDataDevices;
+    int dragMotionInterval = 0;
     QVector<PrimarySelectionDeviceV1Interface *> primarySelectionDevices;
     QVector<DataControlDeviceV1Interface *> dataControlDevices;
 
@@ -65,7 +69,12 @@ public:
     // the last thing copied into the clipboard content
     AbstractDataSource *currentSelection = nullptr;
     AbstractDataSource *currentPrimarySelection = nullptr;
+    // bumped whenever the (primary) selection changes, lets data devices skip sending an offer
+    // for a selection they already hold one for
+    quint32 selectionGeneration = 1;
+    quint32 primarySelectionGeneration = 1;
     AbstractDataSource *currentCachedSelection = nullptr;
+    QScopedPointer<SelectionCache> selectionCache;
 
     // Pointer related members
     struct Pointer {
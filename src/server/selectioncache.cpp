@@ -0,0 +1,402 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include "selectioncache_p.h"
+#include "abstract_data_source.h"
+#include "logging.h"
+#include "utils/sigpipeblocker.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThreadPool>
+#include <QVector>
+#include <QtConcurrentRun>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <unistd.h>
+
+namespace KWaylandServer
+{
+// the time in msec a receiver may stall before its transfer is given up
+static const int s_transferTimeout = 5000;
+// the time in msec after which the content of a silent source is no longer cached, but
+// passed on to the waiting receivers once the source continues
+static const int s_fillTimeout = 5000;
+static const int s_chunkSize = 64 * 1024;
+// transfers block their thread, so they get their own pool instead of the global one
+static const int s_maxTransferThreads = 4;
+
+static QHash<AbstractDataSource *, SelectionCache *> s_caches;
+
+struct SelectionCacheEntry {
+    ~SelectionCacheEntry()
+    {
+        if (memfd != -1) {
+            close(memfd);
+        }
+    }
+
+    enum class State {
+        Filling,
+        Complete,
+        // the content is not kept, because it is too big or the source stalled
+        Uncached,
+        Failed,
+    };
+
+    QMutex mutex;
+    State state = State::Filling;
+    int memfd = -1;
+    qint64 size = 0;
+    // receivers which asked for the content while it's being read from the source
+    QVector<int> pendingFds;
+};
+
+static QThreadPool *transferPool()
+{
+    // not destroyed on exit, that would wait for transfers to sources which never finish
+    static QThreadPool *pool = [] {
+        auto pool = new QThreadPool;
+        pool->setMaxThreadCount(s_maxTransferThreads);
+        return pool;
+    }();
+    return pool;
+}
+
+/**
+ * @returns Whether a transfer would start right away instead of being queued.
+ */
+static bool hasIdleTransferThread()
+{
+    QThreadPool *pool = transferPool();
+    return pool->activeThreadCount() < pool->maxThreadCount();
+}
+
+/**
+ * Waits until @p fd is ready for @p events, at most @p timeout msec or forever if it's @c -1.
+ */
+static bool waitFor(int fd, short events, int timeout = s_transferTimeout)
+{
+    pollfd pfd = {fd, events, 0};
+    while (true) {
+        const int ret = poll(&pfd, 1, timeout);
+        if (ret > 0) {
+            // errors and hangups are reported by the following read or write
+            return true;
+        }
+        if (ret == 0 || errno != EINTR) {
+            return false;
+        }
+    }
+}
+
+static bool writeAll(int fd, const char *data, qint64 size)
+{
+    while (size > 0) {
+        const ssize_t written = write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN && waitFor(fd, POLLOUT)) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+/**
+ * Sends the first @p size bytes of @p memfd to the receiver @p fd.
+ */
+static bool sendContent(int memfd, qint64 size, int fd)
+{
+    off_t offset = 0;
+    while (offset < size) {
+        const ssize_t sent = sendfile(fd, memfd, &offset, qMin<qint64>(size - offset, s_chunkSize));
+        if (sent > 0) {
+            continue;
+        }
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent < 0 && errno == EAGAIN) {
+            if (!waitFor(fd, POLLOUT)) {
+                return false;
+            }
+            continue;
+        }
+        if (sent < 0 && (errno == EINVAL || errno == ENOSYS)) {
+            // the receiver does not support sendfile, copy the rest
+            QByteArray buffer(s_chunkSize, Qt::Uninitialized);
+            while (offset < size) {
+                const ssize_t count = pread(memfd, buffer.data(), qMin<qint64>(size - offset, s_chunkSize), offset);
+                if (count < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (count <= 0 || !writeAll(fd, buffer.constData(), count)) {
+                    return false;
+                }
+                offset += count;
+            }
+            return true;
+        }
+        return false;
+    }
+    return true;
+}
+
+static void prepareReceiver(int fd)
+{
+    // writes must not block a worker thread forever, see waitFor
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+static void serveEntry(QSharedPointer<SelectionCacheEntry> entry, int fd)
+{
+    SigPipeBlocker blocker;
+    prepareReceiver(fd);
+    sendContent(entry->memfd, entry->size, fd);
+    close(fd);
+}
+
+/**
+ * Reads the content from the source into the memfd and passes it on to the receivers which
+ * asked for it in the meantime. If the content turns out too big or the source stalls, it's
+ * passed on to them straight from the source. The transfer only fails if reading fails.
+ */
+static void fillEntry(QSharedPointer<SelectionCacheEntry> entry, int readFd, qint64 maximumSize)
+{
+    SigPipeBlocker blocker;
+    SelectionCacheEntry::State state = SelectionCacheEntry::State::Complete;
+    QByteArray buffer;
+    bool canSplice = true;
+    qint64 size = 0;
+    while (true) {
+        if (size > maximumSize) {
+            state = SelectionCacheEntry::State::Uncached;
+            break;
+        }
+        if (!waitFor(readFd, POLLIN, s_fillTimeout)) {
+            // the receivers would have waited for the source without the cache as well
+            state = SelectionCacheEntry::State::Uncached;
+            break;
+        }
+        ssize_t count;
+        if (canSplice) {
+            loff_t offset = size;
+            count = splice(readFd, nullptr, entry->memfd, &offset, s_chunkSize, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+            if (count < 0 && errno == EINVAL) {
+                canSplice = false;
+                buffer.resize(s_chunkSize);
+                lseek(entry->memfd, size, SEEK_SET);
+                continue;
+            }
+        } else {
+            count = read(readFd, buffer.data(), buffer.size());
+            if (count > 0 && !writeAll(entry->memfd, buffer.constData(), count)) {
+                state = SelectionCacheEntry::State::Failed;
+                break;
+            }
+        }
+        if (count == 0) {
+            break;
+        }
+        if (count < 0) {
+            if (errno == EINTR || errno == EAGAIN) {
+                continue;
+            }
+            state = SelectionCacheEntry::State::Failed;
+            break;
+        }
+        size += count;
+    }
+
+    QVector<int> receivers;
+    {
+        QMutexLocker locker(&entry->mutex);
+        entry->state = state;
+        entry->size = state == SelectionCacheEntry::State::Complete ? size : 0;
+        receivers.swap(entry->pendingFds);
+    }
+
+    for (int fd : qAsConst(receivers)) {
+        prepareReceiver(fd);
+    }
+
+    switch (state) {
+    case SelectionCacheEntry::State::Complete:
+        for (int fd : qAsConst(receivers)) {
+            sendContent(entry->memfd, size, fd);
+        }
+        break;
+    case SelectionCacheEntry::State::Uncached: {
+        for (int &fd : receivers) {
+            if (!sendContent(entry->memfd, size, fd)) {
+                close(fd);
+                fd = -1;
+            }
+        }
+        receivers.removeAll(-1);
+        buffer.resize(s_chunkSize);
+        while (!receivers.isEmpty() && waitFor(readFd, POLLIN, -1)) {
+            const ssize_t count = read(readFd, buffer.data(), buffer.size());
+            if (count < 0 && (errno == EINTR || errno == EAGAIN)) {
+                continue;
+            }
+            if (count <= 0) {
+                break;
+            }
+            for (int &fd : receivers) {
+                if (!writeAll(fd, buffer.constData(), count)) {
+                    close(fd);
+                    fd = -1;
+                }
+            }
+            receivers.removeAll(-1);
+        }
+        ftruncate(entry->memfd, 0);
+        break;
+    }
+    case SelectionCacheEntry::State::Failed:
+        qCWarning(KWAYLAND_SERVER) << "Failed to read the selection content from the data source";
+        ftruncate(entry->memfd, 0);
+        break;
+    case SelectionCacheEntry::State::Filling:
+        Q_UNREACHABLE();
+        break;
+    }
+
+    for (int fd : qAsConst(receivers)) {
+        close(fd);
+    }
+    close(readFd);
+}
+
+SelectionCache::SelectionCache(QObject *parent)
+    : QObject(parent)
+{
+}
+
+SelectionCache::~SelectionCache()
+{
+    setSource(nullptr);
+}
+
+void SelectionCache::setMaximumSize(qint64 size)
+{
+    if (m_maximumSize == size) {
+        return;
+    }
+    m_maximumSize = size;
+    m_entries.clear();
+}
+
+qint64 SelectionCache::maximumSize() const
+{
+    return m_maximumSize;
+}
+
+AbstractDataSource *SelectionCache::source() const
+{
+    return m_source;
+}
+
+void SelectionCache::setSource(AbstractDataSource *source)
+{
+    if (m_source == source) {
+        return;
+    }
+    if (m_source) {
+        disconnect(m_source, nullptr, this, nullptr);
+        if (s_caches.value(m_source) == this) {
+            s_caches.remove(m_source);
+        }
+    }
+    // transfers in progress hold on to their entry
+    m_entries.clear();
+    m_source = source;
+    if (m_source) {
+        s_caches.insert(m_source, this);
+        connect(m_source, &AbstractDataSource::aboutToBeDestroyed, this, [this]() {
+            setSource(nullptr);
+        });
+    }
+}
+
+void SelectionCache::requestData(AbstractDataSource *source, const QString &mimeType, qint32 fd)
+{
+    if (SelectionCache *cache = s_caches.value(source)) {
+        cache->transfer(mimeType, fd);
+    } else {
+        source->requestData(mimeType, fd);
+    }
+}
+
+void SelectionCache::transfer(const QString &mimeType, qint32 fd)
+{
+    QSharedPointer<SelectionCacheEntry> entry = m_entries.value(mimeType);
+    if (!entry) {
+        if (!hasIdleTransferThread()) {
+            // don't queue behind transfers waiting for their sources
+            m_source->requestData(mimeType, fd);
+            return;
+        }
+        int pipeFds[2];
+        if (pipe2(pipeFds, O_CLOEXEC) != 0) {
+            qCWarning(KWAYLAND_SERVER) << "Could not create a pipe for caching the selection";
+            m_source->requestData(mimeType, fd);
+            return;
+        }
+        const int memfd = memfd_create("kwayland-selection", MFD_CLOEXEC);
+        if (memfd == -1) {
+            qCWarning(KWAYLAND_SERVER) << "Could not create a memfd for caching the selection";
+            close(pipeFds[0]);
+            close(pipeFds[1]);
+            m_source->requestData(mimeType, fd);
+            return;
+        }
+        fcntl(pipeFds[0], F_SETFL, O_NONBLOCK);
+
+        entry.reset(new SelectionCacheEntry);
+        entry->memfd = memfd;
+        entry->pendingFds << fd;
+        m_entries.insert(mimeType, entry);
+
+        m_source->requestData(mimeType, pipeFds[1]);
+        QtConcurrent::run(transferPool(), fillEntry, entry, pipeFds[0], m_maximumSize);
+        return;
+    }
+
+    QMutexLocker locker(&entry->mutex);
+    switch (entry->state) {
+    case SelectionCacheEntry::State::Filling:
+        entry->pendingFds << fd;
+        return;
+    case SelectionCacheEntry::State::Complete:
+        locker.unlock();
+        if (!hasIdleTransferThread()) {
+            break;
+        }
+        QtConcurrent::run(transferPool(), serveEntry, entry, int(fd));
+        return;
+    case SelectionCacheEntry::State::Uncached:
+        break;
+    case SelectionCacheEntry::State::Failed:
+        // try again with the next request
+        m_entries.remove(mimeType);
+        break;
+    }
+    locker.unlock();
+    m_source->requestData(mimeType, fd);
+}
+
+}
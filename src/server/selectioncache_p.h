@@ -0,0 +1,59 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include <QHash>
+#include <QObject>
+#include <QSharedPointer>
+
+namespace KWaylandServer
+{
+class AbstractDataSource;
+struct SelectionCacheEntry;
+
+/**
+ * Keeps the content of the clipboard selection in the compositor, so that pasting does not
+ * involve the client owning the selection every time.
+ *
+ * The content of a mime type is requested from the source the first time somebody asks for
+ * it and stored in a memfd. All further requests for that mime type are served from the memfd
+ * on a worker thread, even if the source is busy. Content larger than the maximum size, or of
+ * a source which stalls while being read, is not kept; requests for it go to the source again.
+ * If all transfer threads are busy, requests go to the source as well.
+ */
+class SelectionCache : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SelectionCache(QObject *parent = nullptr);
+    ~SelectionCache() override;
+
+    /**
+     * The maximum size in bytes of the content kept for one mime type.
+     */
+    void setMaximumSize(qint64 size);
+    qint64 maximumSize() const;
+
+    /**
+     * Sets the @p source whose content is cached, dropping the content of the previous one.
+     */
+    void setSource(AbstractDataSource *source);
+    AbstractDataSource *source() const;
+
+    /**
+     * Writes the content of @p source for @p mimeType to @p fd and closes it. This is served
+     * from the cache if there is one for @p source, otherwise the @p source is asked.
+     */
+    static void requestData(AbstractDataSource *source, const QString &mimeType, qint32 fd);
+
+private:
+    void transfer(const QString &mimeType, qint32 fd);
+
+    AbstractDataSource *m_source = nullptr;
+    QHash<QString, QSharedPointer<SelectionCacheEntry>> m_entries;
+    qint64 m_maximumSize = 0;
+};
+
+}
@@ -6,6 +6,7 @@
 #include "strut_interface.h"
 #include "display.h"
 #include "surface_interface_p.h"
+#include "surfaceproperties_p.h"
 #include <qwayland-server-wayland.h>
 #include <qwayland-server-strut.h>
 
@@ -58,8 +59,6 @@ void StrutInterfacePrivate::com_deepin_kwin_strut_set_strut_partial(Resource *re
                                                                     int32_t bottom_start_x,
                                                                     int32_t bottom_end_x)
 {
-    Q_UNUSED(resource);
-
     struct deepinKwinStrut kwinStrut(left,
                                      right,
                                      top,
@@ -73,6 +72,11 @@ void StrutInterfacePrivate::com_deepin_kwin_strut_set_strut_partial(Resource *re
                                      bottom_start_x,
                                      bottom_end_x);
     SurfaceInterface *si = SurfaceInterface::get(surface);
+    if (!si) {
+        wl_resource_post_error(resource->handle, 0, "Invalid surface");
+        return;
+    }
+    SurfacePropertiesPrivate::get(si)->setStrut(kwinStrut);
 
     Q_EMIT q->setStrut(si, kwinStrut);
 }
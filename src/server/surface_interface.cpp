@@ -9,17 +9,24 @@
 #include "clientconnection.h"
 #include "compositor_interface.h"
 #include "display.h"
+#include "display_p.h"
 #include "idleinhibit_v1_interface_p.h"
 #include "linuxdmabufv1clientbuffer.h"
+#include "output_interface_p.h"
 #include "pointerconstraints_v1_interface_p.h"
 #include "region_interface_p.h"
 #include "subcompositor_interface.h"
 #include "subsurface_interface_p.h"
+#include "surfacecommitmailbox_p.h"
+#include "surfaceproperties_p.h"
 #include "surface_interface_p.h"
 #include "surfacerole_p.h"
 #include "utils.h"
+
+#include <QVarLengthArray>
 // std
 #include <algorithm>
+#include <iterator>
 
 namespace KWaylandServer
 {
@@ -338,6 +345,9 @@ SurfaceInterface::SurfaceInterface(CompositorInterface *compositor, wl_resource
     d->compositor = compositor;
     d->init(resource);
     d->client = compositor->display()->getConnection(d->resource()->client());
+    if (compositor->display()->isThreaded()) {
+        d->commitMailbox = SurfaceCommitMailboxPrivate::create(compositor->display());
+    }
 }
 
 SurfaceInterface::~SurfaceInterface()
@@ -364,26 +374,53 @@ CompositorInterface *SurfaceInterface::compositor() const
     return d->compositor;
 }
 
-void SurfaceInterface::frameRendered(quint32 msec)
+bool SurfaceInterfacePrivate::hasFrameCallbacksInTree() const
+{
+    if (!wl_list_empty(&current.frameCallbacks)) {
+        return true;
+    }
+    for (SubSurfaceInterface *subsurface : qAsConst(current.below)) {
+        if (SurfaceInterfacePrivate::get(subsurface->surface())->hasFrameCallbacksInTree()) {
+            return true;
+        }
+    }
+    for (SubSurfaceInterface *subsurface : qAsConst(current.above)) {
+        if (SurfaceInterfacePrivate::get(subsurface->surface())->hasFrameCallbacksInTree()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void SurfaceInterfacePrivate::sendFrameDone(quint32 msec)
 {
     // notify all callbacks
     wl_resource *resource;
     wl_resource *tmp;
 
-    wl_resource_for_each_safe(resource, tmp, &d->current.frameCallbacks)
+    wl_resource_for_each_safe(resource, tmp, &current.frameCallbacks)
     {
         wl_callback_send_done(resource, msec);
         wl_resource_destroy(resource);
     }
 
-    for (SubSurfaceInterface *subsurface : qAsConst(d->current.below)) {
-        subsurface->surface()->frameRendered(msec);
+    for (SubSurfaceInterface *subsurface : qAsConst(current.below)) {
+        SurfaceInterfacePrivate::get(subsurface->surface())->sendFrameDone(msec);
     }
-    for (SubSurfaceInterface *subsurface : qAsConst(d->current.above)) {
-        subsurface->surface()->frameRendered(msec);
+    for (SubSurfaceInterface *subsurface : qAsConst(current.above)) {
+        SurfaceInterfacePrivate::get(subsurface->surface())->sendFrameDone(msec);
     }
 }
 
+void SurfaceInterface::frameRendered(quint32 msec)
+{
+    // the subsurfaces are shown on the outputs of this surface
+    if (d->hasFrameCallbacksInTree()) {
+        DisplayPrivate::get(d->compositor->display())->markFrameRendered(d->client->client(), d->outputs);
+    }
+    d->sendFrameDone(msec);
+}
+
 bool SurfaceInterface::hasFrameCallbacks() const
 {
     return !wl_list_empty(&d->current.frameCallbacks);
@@ -651,9 +688,31 @@ void SurfaceInterfacePrivate::applyState(SurfaceState *next)
     if (role) {
         role->commit();
     }
+    if (commitMailbox) {
+        publishCommit(bufferChanged);
+    }
+    if (properties) {
+        SurfacePropertiesPrivate::get(q)->commit();
+    }
     Q_EMIT q->committed();
 }
 
+void SurfaceInterfacePrivate::publishCommit(bool bufferChanged)
+{
+    SurfaceCommit commit;
+    commit.buffer = bufferRef;
+    commit.offset = current.offset;
+    commit.size = surfaceSize;
+    commit.bufferScale = current.bufferScale;
+    commit.bufferTransform = current.bufferTransform;
+    if (bufferChanged) {
+        commit.damage = current.damage;
+    }
+    commit.opaque = current.opaque;
+    commit.input = inputRegion;
+    SurfaceCommitMailboxPrivate::get(commitMailbox.data())->publish(commit);
+}
+
 void SurfaceInterfacePrivate::commitSubSurface()
 {
     if (subSurface->isSynchronized()) {
@@ -827,32 +886,43 @@ QVector<OutputInterface *> SurfaceInterface::outputs() const
     return d->outputs;
 }
 
-void SurfaceInterface::setOutputs(const QVector<OutputInterface *> &outputs)
+template<typename Func>
+static void forEachOutputResource(OutputInterface *output, wl_client *client, Func func)
 {
-    QVector<OutputInterface *> removedOutputs = d->outputs;
-    for (auto it = outputs.constBegin(), end = outputs.constEnd(); it != end; ++it) {
-        const auto o = *it;
-        removedOutputs.removeOne(o);
+    const auto resources = OutputInterfacePrivate::get(output)->resourceMap();
+    for (auto it = resources.constFind(client); it != resources.constEnd() && it.key() == client; ++it) {
+        func((*it)->handle);
     }
-    for (auto it = removedOutputs.constBegin(), end = removedOutputs.constEnd(); it != end; ++it) {
-        const auto resources = (*it)->clientResources(client());
-        for (wl_resource *outputResource : resources) {
+}
+
+void SurfaceInterface::setOutputs(const QVector<OutputInterface *> &outputs)
+{
+    // diff the sorted sets, outputs are few so this does not need to allocate
+    using OutputSet = QVarLengthArray<OutputInterface *, 8>;
+    OutputSet oldOutputs;
+    oldOutputs.append(d->outputs.constData(), d->outputs.count());
+    std::sort(oldOutputs.begin(), oldOutputs.end());
+    OutputSet newOutputs;
+    newOutputs.append(outputs.constData(), outputs.count());
+    std::sort(newOutputs.begin(), newOutputs.end());
+
+    OutputSet removedOutputs;
+    std::set_difference(oldOutputs.cbegin(), oldOutputs.cend(), newOutputs.cbegin(), newOutputs.cend(), std::back_inserter(removedOutputs));
+    OutputSet addedOutputs;
+    std::set_difference(newOutputs.cbegin(), newOutputs.cend(), oldOutputs.cbegin(), oldOutputs.cend(), std::back_inserter(addedOutputs));
+
+    wl_client *wlClient = client()->client();
+    for (OutputInterface *o : qAsConst(removedOutputs)) {
+        forEachOutputResource(o, wlClient, [this](wl_resource *outputResource) {
             d->send_leave(outputResource);
-        }
-        disconnect(d->outputDestroyedConnections.take(*it));
-        disconnect(d->outputBoundConnections.take(*it));
-    }
-    QVector<OutputInterface *> addedOutputsOutputs = outputs;
-    for (auto it = d->outputs.constBegin(), end = d->outputs.constEnd(); it != end; ++it) {
-        const auto o = *it;
-        addedOutputsOutputs.removeOne(o);
-    }
-    for (auto it = addedOutputsOutputs.constBegin(), end = addedOutputsOutputs.constEnd(); it != end; ++it) {
-        const auto o = *it;
-        const auto resources = o->clientResources(client());
-        for (wl_resource *outputResource : resources) {
+        });
+        disconnect(d->outputDestroyedConnections.take(o));
+        disconnect(d->outputBoundConnections.take(o));
+    }
+    for (OutputInterface *o : qAsConst(addedOutputs)) {
+        forEachOutputResource(o, wlClient, [this](wl_resource *outputResource) {
             d->send_enter(outputResource);
-        }
+        });
         d->outputDestroyedConnections[o] = connect(o, &OutputInterface::removed, this, [this, o] {
             auto outputs = d->outputs;
             if (outputs.removeAll(o)) {
@@ -959,6 +1029,16 @@ LinuxDmaBufV1Feedback *SurfaceInterface::dmabufFeedbackV1() const
     return d->dmabufFeedbackV1.data();
 }
 
+QSharedPointer<SurfaceCommitMailbox> SurfaceInterface::commitMailbox() const
+{
+    return d->commitMailbox;
+}
+
+SurfaceProperties *SurfaceInterface::properties() const
+{
+    return SurfacePropertiesPrivate::get(const_cast<SurfaceInterface *>(this))->q;
+}
+
 QPointF SurfaceInterface::mapToBuffer(const QPointF &point) const
 {
     return d->surfaceToBufferMatrix.map(point);
@@ -12,6 +12,7 @@
 #include <QObject>
 #include <QPointer>
 #include <QRegion>
+#include <QSharedPointer>
 
 #include <DWayland/Server/kwaylandserver_export.h>
 
@@ -27,6 +28,8 @@ class ShadowInterface;
 class SlideInterface;
 class SubSurfaceInterface;
 class SurfaceInterfacePrivate;
+class SurfaceCommitMailbox;
+class SurfaceProperties;
 class LinuxDmaBufV1Feedback;
 
 /**
@@ -157,6 +160,12 @@ public:
      */
     QPointF mapToChild(SurfaceInterface *child, const QPointF &point) const;
 
+    /**
+     * Sends the done event to all pending frame callbacks of this surface and its sub-surfaces.
+     *
+     * The events are written to the client on the next Display::flushFrame for one of the
+     * outputs the surface is on, or at the latest when the event loop is about to block.
+     */
     void frameRendered(quint32 msec);
     bool hasFrameCallbacks() const;
 
@@ -308,6 +317,26 @@ public:
      */
     LinuxDmaBufV1Feedback *dmabufFeedbackV1() const;
 
+    /**
+     * Returns the mailbox the commits of this surface are published to, if the Display
+     * dispatches its event loop in a dedicated thread; otherwise returns @c null.
+     *
+     * The mailbox has to be retrieved in the event loop thread, e.g. from a slot connected
+     * to CompositorInterface::surfaceCreated with Qt::DirectConnection, and can then be
+     * handed over to the thread consuming the commits.
+     *
+     * @see Display::startThreaded
+     */
+    QSharedPointer<SurfaceCommitMailbox> commitMailbox() const;
+
+    /**
+     * Returns the window properties the client set for this surface, created on first use.
+     *
+     * @see SurfaceProperties
+     * @since 5.24
+     */
+    SurfaceProperties *properties() const;
+
     /**
      * @returns The SurfaceInterface for the @p native resource.
      */
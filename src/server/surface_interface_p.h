@@ -88,8 +88,14 @@ public:
     void commitFromCache();
 
     void commitSubSurface();
+    /**
+     * @returns Whether the surface or any of its subsurfaces has a frame callback.
+     */
+    bool hasFrameCallbacksInTree() const;
+    void sendFrameDone(quint32 msec);
     QMatrix4x4 buildSurfaceToBufferMatrix();
     void applyState(SurfaceState *next);
+    void publishCommit(bool bufferChanged);
 
     bool computeEffectiveMapped() const;
     void updateEffectiveMapped();
@@ -122,6 +128,8 @@ public:
     ViewportInterface *viewportExtension = nullptr;
     QScopedPointer<LinuxDmaBufV1Feedback> dmabufFeedbackV1;
     ClientConnection *client = nullptr;
+    QSharedPointer<SurfaceCommitMailbox> commitMailbox;
+    SurfaceProperties *properties = nullptr;
 
 protected:
     void surface_destroy_resource(Resource *resource) override;
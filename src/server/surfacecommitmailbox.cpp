@@ -0,0 +1,87 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include "surfacecommitmailbox.h"
+#include "clientbuffer.h"
+#include "display.h"
+#include "surfacecommitmailbox_p.h"
+
+#include <QThread>
+#include <QVarLengthArray>
+
+namespace KWaylandServer
+{
+QSharedPointer<SurfaceCommitMailbox> SurfaceCommitMailboxPrivate::create(Display *display)
+{
+    return QSharedPointer<SurfaceCommitMailbox>(new SurfaceCommitMailbox(display));
+}
+
+SurfaceCommitMailboxPrivate::SurfaceCommitMailboxPrivate(Display *display)
+    : display(display)
+{
+}
+
+void SurfaceCommitMailboxPrivate::publish(const SurfaceCommit &commit)
+{
+    // the back slot is owned by the producer, whatever it holds is no longer visible to the consumer
+    SurfaceCommit &slot = commits.back();
+    if (slot.buffer) {
+        slot.buffer->unref();
+    }
+
+    // if the previous commit has not been fetched, its damage must not get lost
+    if (!commits.hasPending()) {
+        unfetchedDamage = QRegion();
+    }
+    unfetchedDamage += commit.damage;
+
+    slot = commit;
+    slot.damage = unfetchedDamage;
+    slot.serial = ++serial;
+    if (slot.buffer) {
+        slot.buffer->ref();
+    }
+    commits.publish();
+}
+
+SurfaceCommitMailbox::SurfaceCommitMailbox(Display *display)
+    : d(new SurfaceCommitMailboxPrivate(display))
+{
+}
+
+SurfaceCommitMailbox::~SurfaceCommitMailbox()
+{
+    QVarLengthArray<ClientBuffer *, 3> buffers;
+    for (int i = 0; i < 3; ++i) {
+        if (ClientBuffer *buffer = d->commits.slot(i).buffer) {
+            buffers.append(buffer);
+        }
+    }
+    if (buffers.isEmpty()) {
+        return;
+    }
+    // buffers may only be released in the event loop thread
+    auto release = [buffers]() {
+        for (ClientBuffer *buffer : buffers) {
+            buffer->unref();
+        }
+    };
+    if (d->display->thread() == QThread::currentThread() || !d->display->isRunning()) {
+        release();
+    } else {
+        QMetaObject::invokeMethod(d->display, release, Qt::QueuedConnection);
+    }
+}
+
+bool SurfaceCommitMailbox::fetch()
+{
+    return d->commits.fetch();
+}
+
+const SurfaceCommit &SurfaceCommitMailbox::current() const
+{
+    return d->commits.front();
+}
+
+} // namespace KWaylandServer
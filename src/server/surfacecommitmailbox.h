@@ -0,0 +1,80 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include "output_interface.h"
+
+#include <QRegion>
+#include <QScopedPointer>
+
+#include <DWayland/Server/kwaylandserver_export.h>
+
+namespace KWaylandServer
+{
+class ClientBuffer;
+class Display;
+class SurfaceCommitMailboxPrivate;
+
+/**
+ * The SurfaceCommit struct is a snapshot of the state of a SurfaceInterface taken when
+ * the surface got committed.
+ */
+struct KWAYLANDSERVER_EXPORT SurfaceCommit {
+    /**
+     * The attached buffer. It stays referenced as long as the snapshot is alive in the
+     * SurfaceCommitMailbox, the consumer must not ref or unref it.
+     */
+    ClientBuffer *buffer = nullptr;
+    QPoint offset;
+    QSize size;
+    qint32 bufferScale = 1;
+    OutputInterface::Transform bufferTransform = OutputInterface::Transform::Normal;
+    /**
+     * The surface-local damage of all commits since the consumer fetched the previous
+     * snapshot, so no damage is lost if commits get superseded.
+     */
+    QRegion damage;
+    QRegion opaque;
+    QRegion input;
+    /**
+     * Increases with every commit of the surface.
+     */
+    quint64 serial = 0;
+};
+
+/**
+ * @brief Lock-free handoff of surface commits from the Wayland event loop thread.
+ *
+ * When the Display is started with Display::startThreaded, surface commits are processed in
+ * the event loop thread. Each commit publishes a SurfaceCommit snapshot into the mailbox of the
+ * surface, which can be fetched from one other thread, e.g. the compositor's rendering thread,
+ * without locking and without waiting for the event loop thread.
+ *
+ * The mailbox can outlive its SurfaceInterface, but has to be destroyed before the Display.
+ *
+ * @see SurfaceInterface::commitMailbox
+ */
+class KWAYLANDSERVER_EXPORT SurfaceCommitMailbox
+{
+public:
+    ~SurfaceCommitMailbox();
+
+    /**
+     * Makes the latest published commit available through current(). Returns @c false if the
+     * surface has not been committed since the last fetch.
+     */
+    bool fetch();
+    /**
+     * The commit fetched last. It is not modified until the next fetch().
+     */
+    const SurfaceCommit &current() const;
+
+private:
+    friend class SurfaceCommitMailboxPrivate;
+    explicit SurfaceCommitMailbox(Display *display);
+    QScopedPointer<SurfaceCommitMailboxPrivate> d;
+};
+
+} // namespace KWaylandServer
@@ -0,0 +1,36 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include "surfacecommitmailbox.h"
+#include "utils/triplebuffer.h"
+
+#include <QSharedPointer>
+
+namespace KWaylandServer
+{
+class SurfaceCommitMailboxPrivate
+{
+public:
+    static QSharedPointer<SurfaceCommitMailbox> create(Display *display);
+    static SurfaceCommitMailboxPrivate *get(SurfaceCommitMailbox *mailbox)
+    {
+        return mailbox->d.data();
+    }
+
+    explicit SurfaceCommitMailboxPrivate(Display *display);
+
+    /**
+     * Publishes the @p commit, must only be called from the event loop thread.
+     */
+    void publish(const SurfaceCommit &commit);
+
+    Display *display;
+    TripleBuffer<SurfaceCommit> commits;
+    QRegion unfetchedDamage;
+    quint64 serial = 0;
+};
+
+} // namespace KWaylandServer
@@ -0,0 +1,169 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include "surfaceproperties.h"
+#include "surface_interface.h"
+#include "surface_interface_p.h"
+#include "surfaceproperties_p.h"
+
+namespace KWaylandServer
+{
+static bool operator==(const deepinKwinStrut &a, const deepinKwinStrut &b)
+{
+    return a.left == b.left && a.right == b.right && a.top == b.top && a.bottom == b.bottom && a.left_start_y == b.left_start_y
+        && a.left_end_y == b.left_end_y && a.right_start_y == b.right_start_y && a.right_end_y == b.right_end_y && a.top_start_x == b.top_start_x
+        && a.top_end_x == b.top_end_x && a.bottom_start_x == b.bottom_start_x && a.bottom_end_x == b.bottom_end_x;
+}
+
+SurfacePropertiesPrivate *SurfacePropertiesPrivate::get(SurfaceInterface *surface)
+{
+    SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(surface);
+    if (!surfacePrivate->properties) {
+        surfacePrivate->properties = new SurfaceProperties(surface);
+    }
+    return surfacePrivate->properties->d.data();
+}
+
+SurfacePropertiesPrivate::SurfacePropertiesPrivate(SurfaceProperties *q, SurfaceInterface *surface)
+    : q(q)
+    , surface(surface)
+{
+}
+
+void SurfacePropertiesPrivate::markDirty(SurfaceProperties::Property property)
+{
+    properties |= property;
+    dirty |= property;
+    if (commitScheduled) {
+        return;
+    }
+    // in case the client does not commit the surface
+    commitScheduled = true;
+    QMetaObject::invokeMethod(
+        q,
+        [this] {
+            commit();
+        },
+        Qt::QueuedConnection);
+}
+
+void SurfacePropertiesPrivate::setNoTitleBar(qint32 value)
+{
+    if (properties.testFlag(SurfaceProperties::Property::NoTitleBar) && noTitleBar == value) {
+        return;
+    }
+    noTitleBar = value;
+    markDirty(SurfaceProperties::Property::NoTitleBar);
+}
+
+void SurfacePropertiesPrivate::setWindowRadius(const QPointF &radius)
+{
+    if (properties.testFlag(SurfaceProperties::Property::WindowRadius) && windowRadius == radius) {
+        return;
+    }
+    windowRadius = radius;
+    markDirty(SurfaceProperties::Property::WindowRadius);
+}
+
+void SurfacePropertiesPrivate::setSplitWindow(SplitType type, int mode)
+{
+    if (properties.testFlag(SurfaceProperties::Property::SplitWindow) && splitType == type && splitMode == mode) {
+        return;
+    }
+    splitType = type;
+    splitMode = mode;
+    markDirty(SurfaceProperties::Property::SplitWindow);
+}
+
+void SurfacePropertiesPrivate::setStrut(const deepinKwinStrut &value)
+{
+    if (properties.testFlag(SurfaceProperties::Property::Strut) && strut == value) {
+        return;
+    }
+    strut = value;
+    markDirty(SurfaceProperties::Property::Strut);
+}
+
+void SurfacePropertiesPrivate::updateWindowDecoration(const QVariantMap &changes)
+{
+    bool changed = false;
+    for (auto it = changes.constBegin(); it != changes.constEnd(); ++it) {
+        if (!it.value().isValid()) {
+            changed |= windowDecoration.remove(it.key()) > 0;
+            continue;
+        }
+        auto current = windowDecoration.find(it.key());
+        if (current == windowDecoration.end()) {
+            windowDecoration.insert(it.key(), it.value());
+            changed = true;
+        } else if (*current != it.value()) {
+            *current = it.value();
+            changed = true;
+        }
+    }
+    if (changed) {
+        markDirty(SurfaceProperties::Property::WindowDecoration);
+    }
+}
+
+void SurfacePropertiesPrivate::commit()
+{
+    commitScheduled = false;
+    if (!dirty) {
+        return;
+    }
+    const SurfaceProperties::Properties changed = dirty;
+    dirty = SurfaceProperties::Properties();
+    Q_EMIT q->propertiesChanged(changed);
+}
+
+SurfaceProperties::SurfaceProperties(SurfaceInterface *surface)
+    : QObject(surface)
+    , d(new SurfacePropertiesPrivate(this, surface))
+{
+}
+
+SurfaceProperties::~SurfaceProperties() = default;
+
+SurfaceInterface *SurfaceProperties::surface() const
+{
+    return d->surface;
+}
+
+SurfaceProperties::Properties SurfaceProperties::properties() const
+{
+    return d->properties;
+}
+
+qint32 SurfaceProperties::noTitleBar() const
+{
+    return d->noTitleBar;
+}
+
+QPointF SurfaceProperties::windowRadius() const
+{
+    return d->windowRadius;
+}
+
+SplitType SurfaceProperties::splitType() const
+{
+    return d->splitType;
+}
+
+int SurfaceProperties::splitMode() const
+{
+    return d->splitMode;
+}
+
+deepinKwinStrut SurfaceProperties::strut() const
+{
+    return d->strut;
+}
+
+QVariantMap SurfaceProperties::windowDecoration() const
+{
+    return d->windowDecoration;
+}
+
+}
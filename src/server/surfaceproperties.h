@@ -0,0 +1,81 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include "ddeshell_interface.h"
+#include "strut_interface.h"
+
+#include <QObject>
+#include <QPointF>
+#include <QScopedPointer>
+#include <QVariantMap>
+
+#include <DWayland/Server/kwaylandserver_export.h>
+
+namespace KWaylandServer
+{
+class SurfaceInterface;
+class SurfacePropertiesPrivate;
+
+/**
+ * @brief The window properties a client set for a SurfaceInterface.
+ *
+ * The properties set through DDEShellSurfaceInterface, GlobalPropertyInterface and
+ * StrutInterface are kept here, so the compositor does not have to mirror them. Changes are
+ * collected and announced with a single propertiesChanged signal when the surface gets committed,
+ * or when control returns to the event loop if the client does not commit the surface.
+ *
+ * @see SurfaceInterface::properties
+ * @since 5.24
+ */
+class KWAYLANDSERVER_EXPORT SurfaceProperties : public QObject
+{
+    Q_OBJECT
+public:
+    enum class Property {
+        NoTitleBar = 1 << 0,
+        WindowRadius = 1 << 1,
+        SplitWindow = 1 << 2,
+        Strut = 1 << 3,
+        WindowDecoration = 1 << 4,
+    };
+    Q_DECLARE_FLAGS(Properties, Property)
+    Q_FLAG(Properties)
+
+    ~SurfaceProperties() override;
+
+    SurfaceInterface *surface() const;
+    /**
+     * @returns The properties the client has set so far.
+     */
+    Properties properties() const;
+
+    qint32 noTitleBar() const;
+    QPointF windowRadius() const;
+    SplitType splitType() const;
+    int splitMode() const;
+    deepinKwinStrut strut() const;
+    /**
+     * @returns The decoration properties set through GlobalPropertyInterface.
+     */
+    QVariantMap windowDecoration() const;
+
+Q_SIGNALS:
+    /**
+     * Emitted once per commit of the surface if any of the properties in @p changed got
+     * a new value.
+     */
+    void propertiesChanged(KWaylandServer::SurfaceProperties::Properties changed);
+
+private:
+    explicit SurfaceProperties(SurfaceInterface *surface);
+    friend class SurfacePropertiesPrivate;
+    QScopedPointer<SurfacePropertiesPrivate> d;
+};
+
+}
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(KWaylandServer::SurfaceProperties::Properties)
+Q_DECLARE_METATYPE(KWaylandServer::SurfaceProperties::Properties)
@@ -0,0 +1,52 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include "surfaceproperties.h"
+
+namespace KWaylandServer
+{
+class SurfacePropertiesPrivate
+{
+public:
+    /**
+     * @returns The properties of @p surface, created on first use.
+     */
+    static SurfacePropertiesPrivate *get(SurfaceInterface *surface);
+
+    SurfacePropertiesPrivate(SurfaceProperties *q, SurfaceInterface *surface);
+
+    void setNoTitleBar(qint32 noTitleBar);
+    void setWindowRadius(const QPointF &radius);
+    void setSplitWindow(SplitType type, int mode);
+    void setStrut(const deepinKwinStrut &strut);
+    /**
+     * Merges @p changes into the decoration properties, an invalid value removes the property.
+     */
+    void updateWindowDecoration(const QVariantMap &changes);
+
+    /**
+     * Emits propertiesChanged for the changes collected since the last commit.
+     */
+    void commit();
+
+    SurfaceProperties *q;
+    SurfaceInterface *surface;
+    SurfaceProperties::Properties properties;
+    SurfaceProperties::Properties dirty;
+    bool commitScheduled = false;
+
+    qint32 noTitleBar = 0;
+    QPointF windowRadius;
+    SplitType splitType = SplitType::None;
+    int splitMode = 0;
+    deepinKwinStrut strut;
+    QVariantMap windowDecoration;
+
+private:
+    void markDirty(SurfaceProperties::Property property);
+};
+
+}
@@ -0,0 +1,38 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include <pthread.h>
+#include <signal.h>
+
+namespace KWaylandServer
+{
+/**
+ * Blocks SIGPIPE in the current thread for its lifetime. Writing to a pipe whose reader is
+ * gone raises SIGPIPE, which must not terminate the compositor, the write fails with EPIPE.
+ */
+class SigPipeBlocker
+{
+public:
+    SigPipeBlocker()
+    {
+        sigemptyset(&m_set);
+        sigaddset(&m_set, SIGPIPE);
+        pthread_sigmask(SIG_BLOCK, &m_set, &m_previousSet);
+    }
+    ~SigPipeBlocker()
+    {
+        // discard the SIGPIPEs raised in the meantime before unblocking again
+        const timespec timeout = {0, 0};
+        while (sigtimedwait(&m_set, nullptr, &timeout) == SIGPIPE) { }
+        pthread_sigmask(SIG_SETMASK, &m_previousSet, nullptr);
+    }
+
+private:
+    sigset_t m_set;
+    sigset_t m_previousSet;
+};
+
+} // namespace KWaylandServer
@@ -0,0 +1,89 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include <atomic>
+
+namespace KWaylandServer
+{
+/**
+ * Lock-free handoff of the latest value from one producer thread to one consumer thread.
+ *
+ * The producer fills back() and publishes it, the consumer fetches the most recently
+ * published value into front(). Neither side ever waits for the other one. Values
+ * published while the consumer did not fetch are superseded by the next publish.
+ */
+template<typename T>
+class TripleBuffer
+{
+public:
+    /**
+     * The slot the producer writes to. It's never accessed by the consumer.
+     */
+    T &back()
+    {
+        return m_slots[m_back];
+    }
+
+    /**
+     * Hands the back slot over to the consumer. Returns @c false if the previously
+     * published value had not been fetched by the consumer, i.e. it got superseded.
+     */
+    bool publish()
+    {
+        const int previous = m_middle.exchange(m_back | s_dirty, std::memory_order_acq_rel);
+        m_back = previous & s_indexMask;
+        return !(previous & s_dirty);
+    }
+
+    /**
+     * Returns @c true if there is a published value which has not been fetched yet.
+     */
+    bool hasPending() const
+    {
+        return m_middle.load(std::memory_order_acquire) & s_dirty;
+    }
+
+    /**
+     * Makes the latest published value available in front(). Returns @c false if nothing
+     * has been published since the last fetch.
+     */
+    bool fetch()
+    {
+        if (!hasPending()) {
+            return false;
+        }
+        const int previous = m_middle.exchange(m_front, std::memory_order_acq_rel);
+        m_front = previous & s_indexMask;
+        return true;
+    }
+
+    /**
+     * The slot the consumer reads from. It's never accessed by the producer.
+     */
+    const T &front() const
+    {
+        return m_slots[m_front];
+    }
+
+    /**
+     * Access to all slots, only safe once neither producer nor consumer are active anymore.
+     */
+    T &slot(int index)
+    {
+        return m_slots[index];
+    }
+
+private:
+    static constexpr int s_dirty = 4;
+    static constexpr int s_indexMask = 3;
+
+    T m_slots[3];
+    int m_back = 0;
+    std::atomic<int> m_middle{1};
+    int m_front = 2;
+};
+
+} // namespace KWaylandServer